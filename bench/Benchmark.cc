@@ -0,0 +1,232 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <time.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+    typedef std::vector<std::pair<std::string, Benchmark::Function> > Registry;
+
+    // Constructed on first use, the registrars run during the
+    // static initialization of the other files
+    Registry& registry()
+    {
+        static Registry benchmarks;
+        return benchmarks;
+    }
+
+    double median(std::vector<double>& values)
+    {
+        std::sort(values.begin(), values.end());
+        int n = (int)values.size();
+        return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+    }
+
+    // Run iterations of the body, return the time per iteration
+    double sample(Benchmark::Function function, uint64_t iterations,
+            uint64_t& items)
+    {
+        Benchmark::State state(iterations);
+        function(state);
+        items = state.itemsProcessed();
+        return (double)state.elapsedNs() / iterations;
+    }
+
+    // The number of iterations lasting at least minSampleMs
+    uint64_t calibrate(Benchmark::Function function, double minSampleMs)
+    {
+        double minNs = minSampleMs * 1e6;
+        uint64_t iterations = 1;
+        while(true)
+        {
+            uint64_t items;
+            double totalNs = sample(function, iterations, items) * iterations;
+            if(totalNs >= minNs || iterations >= (1ULL << 40))
+                return iterations;
+
+            // Aim a little over the target, at most 100 times more
+            double factor = totalNs > 0 ? 1.2 * minNs / totalNs : 100.0;
+            iterations = (uint64_t)(iterations * std::min(100.0,
+                        std::max(2.0, factor)));
+        }
+    }
+}
+
+uint64_t Benchmark::State::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+Benchmark::Registrar::Registrar(const char *name, Function function)
+{
+    registry().push_back(std::make_pair(std::string(name), function));
+}
+
+Benchmark::Options::Options():
+    warmups(2), repeats(15), minSampleMs(20.0), threshold(0.10)
+{
+}
+
+void Benchmark::computeStats(std::vector<double>& samplesNs, Result& result)
+{
+    result.samples = (int)samplesNs.size();
+    if(samplesNs.empty())
+        return;
+
+    double sum = 0.0;
+    for(int i = 0; i < (int)samplesNs.size(); i ++)
+        sum += samplesNs[i];
+    result.meanNs = sum / samplesNs.size();
+
+    result.medianNs = median(samplesNs);
+    result.minNs = samplesNs.front();
+    result.maxNs = samplesNs.back();
+
+    std::vector<double> deviations(samplesNs.size());
+    for(int i = 0; i < (int)samplesNs.size(); i ++)
+        deviations[i] = fabs(samplesNs[i] - result.medianNs);
+    result.madNs = median(deviations);
+}
+
+int Benchmark::runAll(const Options& options)
+{
+    std::vector<std::pair<std::string, double> > baseline;
+    if(!options.baselineFilename.empty())
+        readJson(options.baselineFilename, baseline);
+
+    std::vector<Result> results;
+    int numRegressions = 0;
+
+    std::cout << std::left << std::setw(36) << "Benchmark" << std::right <<
+        std::setw(14) << "median ns" << std::setw(10) << "mad %" <<
+        std::setw(14) << "min ns" << std::setw(14) << "items/s" <<
+        std::setw(12) << "vs base" << std::endl;
+
+    Registry& benchmarks = registry();
+    for(int b = 0; b < (int)benchmarks.size(); b ++)
+    {
+        const std::string& name = benchmarks[b].first;
+        Function function = benchmarks[b].second;
+        if(name.find(options.filter) == std::string::npos)
+            continue;
+
+        uint64_t iterations = calibrate(function, options.minSampleMs);
+        uint64_t items = 0;
+        for(int i = 0; i < options.warmups; i ++)
+            sample(function, iterations, items);
+
+        std::vector<double> samplesNs;
+        double itemsPerNs = 0.0;
+        for(int i = 0; i < options.repeats; i ++)
+        {
+            double ns = sample(function, iterations, items);
+            samplesNs.push_back(ns);
+            itemsPerNs = (double)items / iterations;
+        }
+
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        computeStats(samplesNs, result);
+        result.itemsPerSecond = result.medianNs > 0 ?
+            itemsPerNs * 1e9 / result.medianNs : 0.0;
+        results.push_back(result);
+
+        std::cout << std::left << std::setw(36) << name << std::right <<
+            std::fixed << std::setprecision(1) <<
+            std::setw(14) << result.medianNs <<
+            std::setw(10) << (result.medianNs > 0 ?
+                    100.0 * result.madNs / result.medianNs : 0.0) <<
+            std::setw(14) << result.minNs <<
+            std::setprecision(0) << std::setw(14) << result.itemsPerSecond;
+
+        for(int i = 0; i < (int)baseline.size(); i ++)
+        {
+            if(baseline[i].first != name || baseline[i].second <= 0)
+                continue;
+
+            double change = result.medianNs / baseline[i].second - 1.0;
+            std::cout << std::setprecision(1) << std::showpos <<
+                std::setw(11) << 100.0 * change << "%" << std::noshowpos;
+            // A slowdown within the noise of the run is not flagged
+            if(change > options.threshold &&
+                    result.medianNs - baseline[i].second > 3.0 * result.madNs)
+            {
+                std::cout << " REGRESSION";
+                numRegressions ++;
+            }
+            break;
+        }
+        std::cout << std::endl;
+    }
+
+    if(!options.jsonFilename.empty())
+        writeJson(options.jsonFilename, results);
+
+    return numRegressions;
+}
+
+void Benchmark::writeJson(const std::string& filename,
+        const std::vector<Result>& results)
+{
+    std::ofstream fout(filename.c_str());
+    fout << std::setprecision(6) << std::fixed;
+    fout << "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n";
+    for(int i = 0; i < (int)results.size(); i ++)
+    {
+        const Result& result = results[i];
+        // One benchmark per line, readJson relies on it
+        fout << "    {\"name\": \"" << result.name << "\", " <<
+            "\"iterations\": " << result.iterations << ", " <<
+            "\"samples\": " << result.samples << ", " <<
+            "\"median_ns\": " << result.medianNs << ", " <<
+            "\"mad_ns\": " << result.madNs << ", " <<
+            "\"min_ns\": " << result.minNs << ", " <<
+            "\"max_ns\": " << result.maxNs << ", " <<
+            "\"mean_ns\": " << result.meanNs << ", " <<
+            "\"items_per_second\": " << result.itemsPerSecond << "}" <<
+            (i + 1 < (int)results.size() ? "," : "") << "\n";
+    }
+    fout << "  ]\n}\n";
+}
+
+void Benchmark::readJson(const std::string& filename,
+        std::vector<std::pair<std::string, double> >& medians)
+{
+    medians.clear();
+
+    std::ifstream fin(filename.c_str());
+    if(!fin.good())
+    {
+        std::cerr << "Cannot read the baseline " << filename << std::endl;
+        return;
+    }
+
+    const std::string nameKey("\"name\": \"");
+    const std::string medianKey("\"median_ns\": ");
+    std::string line;
+    while(getline(fin, line))
+    {
+        size_t namePos = line.find(nameKey);
+        size_t medianPos = line.find(medianKey);
+        if(namePos == std::string::npos || medianPos == std::string::npos)
+            continue;
+
+        namePos += nameKey.size();
+        size_t nameEnd = line.find('"', namePos);
+        if(nameEnd == std::string::npos)
+            continue;
+
+        medians.push_back(std::make_pair(line.substr(namePos, nameEnd - namePos),
+                    atof(line.c_str() + medianPos + medianKey.size())));
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef _INCLUDE_BENCHMARK_H_
+#define _INCLUDE_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// A small in-process benchmark harness. A benchmark is a body
+// which repeats the operation measured while keepRunning() is
+// true; what it does before the loop is not timed:
+//
+//   BENCHMARK(Duration, Parse)
+//   {
+//       std::string tenor("3M");
+//       while(state.keepRunning())
+//           Benchmark::doNotOptimize(Duration(tenor));
+//   }
+//
+// Every benchmark is calibrated to a number of iterations which
+// lasts at least the minimum sample time, warmed up, and then
+// sampled a number of times; the statistics are over the time
+// per iteration of the samples.
+namespace Benchmark
+{
+    class State
+    {
+        public:
+            explicit State(uint64_t iterations):
+                _iterations(iterations), _remaining(iterations),
+                _items(0), _start(0), _end(0){};
+
+            inline bool keepRunning()
+            {
+                if(_remaining > 0)
+                {
+                    if(_remaining -- == _iterations)
+                        _start = now();
+                    return true;
+                }
+
+                _end = now();
+                return false;
+            }
+
+            inline uint64_t iterations() const {return _iterations;}
+            // The items, e.g. paths or random numbers, processed
+            // by all the iterations, for the throughput
+            inline void setItemsProcessed(uint64_t items) {_items = items;}
+            inline uint64_t itemsProcessed() const {return _items;}
+            inline uint64_t elapsedNs() const {return _end - _start;}
+
+            // Monotonic clock in nanoseconds
+            static uint64_t now();
+
+        private:
+            uint64_t _iterations;
+            uint64_t _remaining;
+            uint64_t _items;
+            uint64_t _start;
+            uint64_t _end;
+    };
+
+    typedef void (*Function)(State& state);
+
+    // Register a benchmark, used by BENCHMARK
+    class Registrar
+    {
+        public:
+            Registrar(const char *name, Function function);
+    };
+
+    struct Options
+    {
+        Options();
+
+        // Run the benchmarks whose name contains it
+        std::string filter;
+        int warmups;
+        int repeats;
+        double minSampleMs;
+        std::string jsonFilename;
+        std::string baselineFilename;
+        // Relative slowdown of the median flagged as a regression
+        double threshold;
+    };
+
+    // The statistics of one benchmark, in nanoseconds per iteration
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations;
+        int samples;
+        double medianNs;
+        // median absolute deviation from the median
+        double madNs;
+        double minNs;
+        double maxNs;
+        double meanNs;
+        // 0 if the benchmark counts no items
+        double itemsPerSecond;
+    };
+
+    // Run the registered benchmarks, print a table and write the
+    // JSON report; return the number of regressions against the
+    // baseline
+    int runAll(const Options& options);
+
+    void computeStats(std::vector<double>& samplesNs, Result& result);
+
+    void writeJson(const std::string& filename,
+            const std::vector<Result>& results);
+    // The median of every benchmark of a JSON report
+    void readJson(const std::string& filename,
+            std::vector<std::pair<std::string, double> >& medians);
+
+    // Keep the compiler from optimizing the computation of the
+    // value away
+    template<class T>
+    inline void doNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+}
+
+#define BENCHMARK(group, name) \
+    void benchmark_##group##_##name(Benchmark::State& state); \
+    static Benchmark::Registrar registrar_##group##_##name( \
+            #group "/" #name, benchmark_##group##_##name); \
+    void benchmark_##group##_##name(Benchmark::State& state)
+
+#endif // _INCLUDE_BENCHMARK_H_
@@ -0,0 +1,47 @@
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Date.h"
+
+BENCHMARK(Duration, Parse)
+{
+    std::vector<std::string> tenors;
+    tenors.push_back("ON");
+    tenors.push_back("1W");
+    tenors.push_back("3M");
+    tenors.push_back("10Y");
+
+    while(state.keepRunning())
+        for(int i = 0; i < (int)tenors.size(); i ++)
+        {
+            Duration duration(tenors[i]);
+            Benchmark::doNotOptimize(duration);
+        }
+    state.setItemsProcessed(state.iterations() * tenors.size());
+}
+
+BENCHMARK(Date, Parse)
+{
+    const std::string dateStr("2013/01/22");
+
+    while(state.keepRunning())
+    {
+        Date date(dateStr);
+        Benchmark::doNotOptimize(date);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(Date, WorkDate)
+{
+    Date today = Date::today();
+    Duration day(1, Duration::DAY);
+
+    while(state.keepRunning())
+    {
+        Date date = WorkDate(today + day);
+        Benchmark::doNotOptimize(date);
+    }
+    state.setItemsProcessed(state.iterations());
+}
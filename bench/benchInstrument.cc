@@ -0,0 +1,26 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Instrument.h"
+
+BENCHMARK(InstrumentDefinition, ParseString)
+{
+    std::ifstream deffin("../data/curveSpec1.csv");
+    std::string line;
+    std::vector<std::string> lines;
+
+    getline(deffin, line);
+    while(getline(deffin, line))
+        if(!line.empty())
+            lines.push_back(line);
+
+    while(state.keepRunning())
+        for(int i = 0; i < (int)lines.size(); i ++)
+        {
+            InstrumentDefinition instrDef = InstrumentDefinition::parseString(lines[i]);
+            Benchmark::doNotOptimize(instrDef);
+        }
+    state.setItemsProcessed(state.iterations() * lines.size());
+}
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Benchmark.h"
+
+void
+printUsage()
+{
+    std::cout << "Usage: " << std::endl;
+    std::cout << "\t./benchEngine [-f <run the benchmarks whose name contains it>] " <<
+        "[-w <warm-up samples, 2 by default>] [-r <samples, 15 by default>] " <<
+        "[-t <minimum sample time in ms, 20 by default>] " <<
+        "[-o <JSON report filename>] [-c <baseline JSON report to compare with>] " <<
+        "[-T <slowdown of the median flagged as a regression, 0.10 by default>]" <<
+        std::endl;
+}
+
+int
+main(int argc, char * argv[])
+{
+    Benchmark::Options options;
+    int opt;
+    while((opt = getopt(argc, argv, "f:w:r:t:o:c:T:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'f':
+                options.filter = optarg;
+                break;
+            case 'w':
+                options.warmups = atoi(optarg);
+                break;
+            case 'r':
+                options.repeats = atoi(optarg) < 1 ? 1 : atoi(optarg);
+                break;
+            case 't':
+                options.minSampleMs = atof(optarg);
+                break;
+            case 'o':
+                options.jsonFilename = optarg;
+                break;
+            case 'c':
+                options.baselineFilename = optarg;
+                break;
+            case 'T':
+                options.threshold = atof(optarg);
+                break;
+            default:
+                printUsage();
+                exit(0);
+        }
+    }
+
+    int numRegressions = Benchmark::runAll(options);
+    if(numRegressions > 0)
+        std::cout << numRegressions << " regressions against the baseline" << std::endl;
+
+    return numRegressions > 0 ? 1 : 0;
+}
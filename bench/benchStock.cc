@@ -0,0 +1,62 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+#include "Utility.h"
+#include "Stock.h"
+
+using namespace Stock::PricePredictionModel;
+using namespace RandomNumberGenerator;
+
+// The Monte-Carlo paths of optionMCSim: 10 steps over a year
+BENCHMARK(MonteCarlo, Paths)
+{
+    std::ifstream deffin("../data/curveSpec1.csv");
+    std::string line;
+    std::vector<InstrumentDefinition> instrDefs;
+
+    getline(deffin, line);
+    while(deffin.good())
+    {
+        getline(deffin, line);
+        if(!deffin.good())
+            break;
+
+        instrDefs.push_back(InstrumentDefinition::parseString(line));
+    }
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    std::ifstream datafin("../data/curveDataInput1.csv");
+    InstrumentValues values;
+    getline(datafin, line);
+    while(datafin.good())
+    {
+        char comma;
+        int id;
+        double rate;
+        datafin >> id >> comma >> rate;
+        values.values.push_back(std::pair<int, double>(id, rate));
+    }
+
+    Date today = WorkDate(Date::today());
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+    Duration duration(1, Duration::YEAR);
+    Date last = ycDef.getPillarDates(today).back();
+    yci->getDf(last);
+
+    while(state.keepRunning())
+    {
+        std::vector<std::pair<Date, double> > prices =
+            MonteCarloSimulation<boxMullerM2RNG>(89.31, today, duration,
+                    10, *yci, 0.3, boxMullerM2RNG(boxMullerM2RNG::ANTITHETIC));
+        Benchmark::doNotOptimize(prices.back().second);
+    }
+    state.setItemsProcessed(state.iterations());
+
+    delete yci;
+}
@@ -0,0 +1,58 @@
+#include <stdexcept>
+
+#include "Benchmark.h"
+#include "Utility.h"
+
+using namespace RandomNumberGenerator;
+
+BENCHMARK(Volatility, ImpliedFromEuroCall)
+{
+    Volatility::VolatilityFromEuroCallPriceFormula formula(89.31, 95.0,
+            1.0, 0.03, 10.0);
+
+    // The solver starts from a random guess and a few of them do
+    // not converge, as in optionMCSim: they count in the time but
+    // not in the items
+    uint64_t numSolved = 0;
+    while(state.keepRunning())
+    {
+        try
+        {
+            double volatility = Volatility::NewtonRaphsonMethod()(formula, 1e-9);
+            Benchmark::doNotOptimize(volatility);
+            numSolved ++;
+        }
+        catch(std::runtime_error& e)
+        {
+        }
+    }
+    state.setItemsProcessed(numSolved);
+}
+
+BENCHMARK(RNG, BoxMullerAntithetic)
+{
+    boxMullerM2RNG rng(boxMullerM2RNG::ANTITHETIC);
+    const int batch = 1000;
+
+    while(state.keepRunning())
+        for(int i = 0; i < batch; i ++)
+        {
+            double number = rng.get();
+            Benchmark::doNotOptimize(number);
+        }
+    state.setItemsProcessed(state.iterations() * batch);
+}
+
+BENCHMARK(RNG, BoxMullerNonAntithetic)
+{
+    boxMullerM2RNG rng(boxMullerM2RNG::NONANTITHETIC);
+    const int batch = 1000;
+
+    while(state.keepRunning())
+        for(int i = 0; i < batch; i ++)
+        {
+            double number = rng.get();
+            Benchmark::doNotOptimize(number);
+        }
+    state.setItemsProcessed(state.iterations() * batch);
+}
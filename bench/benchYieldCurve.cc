@@ -0,0 +1,136 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+
+namespace
+{
+    void readCurveInput(std::vector<InstrumentDefinition>& instrDefs,
+            InstrumentValues& values)
+    {
+        std::ifstream deffin("../data/curveSpec1.csv");
+        std::string line;
+
+        getline(deffin, line);
+        while(deffin.good())
+        {
+            getline(deffin, line);
+            if(!deffin.good())
+                break;
+
+            instrDefs.push_back(InstrumentDefinition::parseString(line));
+        }
+
+        std::ifstream datafin("../data/curveDataInput1.csv");
+        getline(datafin, line);
+        while(datafin.good())
+        {
+            char comma;
+            int id;
+            double rate;
+            datafin >> id >> comma >> rate;
+            values.values.push_back(std::pair<int, double>(id, rate));
+        }
+    }
+
+    // Work dates spread over the first two years of the curve
+    void queryDates(const Date& today, int numDates, std::vector<Date>& dates)
+    {
+        for(int i = 0; i < numDates; i ++)
+            dates.push_back(WorkDate(today +
+                        Duration(1 + (i * 7919) % 730, Duration::DAY)));
+    }
+}
+
+BENCHMARK(YieldCurveDefinition, Construct)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    readCurveInput(instrDefs, values);
+
+    while(state.keepRunning())
+    {
+        YieldCurveDefinition ycDef(instrDefs, 4.0);
+        Benchmark::doNotOptimize(ycDef);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(YieldCurve, BindDataFull)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    readCurveInput(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+    Date today = WorkDate(Date::today());
+    Date last = ycDef.getPillarDates(today).back();
+
+    while(state.keepRunning())
+    {
+        YieldCurveInstance *yci = ycDef.bindData(&values,
+                YieldCurveDefinition::ZEROCOUPONRATE, today);
+        // Bootstrap every pillar
+        double df = yci->getDf(last);
+        Benchmark::doNotOptimize(df);
+        delete yci;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(YieldCurve, GetDf)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    readCurveInput(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+    Date today = WorkDate(Date::today());
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+
+    std::vector<Date> dates;
+    queryDates(today, 256, dates);
+    // Bootstrapped before the timing
+    yci->getDf(dates[0]);
+    Date last = ycDef.getPillarDates(today).back();
+    yci->getDf(last);
+
+    while(state.keepRunning())
+        for(int i = 0; i < (int)dates.size(); i ++)
+        {
+            double df = yci->getDf(dates[i]);
+            Benchmark::doNotOptimize(df);
+        }
+    state.setItemsProcessed(state.iterations() * dates.size());
+
+    delete yci;
+}
+
+BENCHMARK(YieldCurve, LookupBatch)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    readCurveInput(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+    Date today = WorkDate(Date::today());
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+
+    std::vector<Date> dates;
+    queryDates(today, 4096, dates);
+    std::vector<double> lookupValues, dfs;
+    std::vector<YieldCurveInstance::LOOKUPSTATUS> status;
+
+    while(state.keepRunning())
+    {
+        yci->lookup(dates, YieldCurveInstance::FLATFORWARD,
+                lookupValues, dfs, status);
+        Benchmark::doNotOptimize(dfs[0]);
+    }
+    state.setItemsProcessed(state.iterations() * dates.size());
+
+    delete yci;
+}
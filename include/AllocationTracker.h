@@ -0,0 +1,71 @@
+#ifndef _INCLUDE_ALLOCATIONTRACKER_H_
+#define _INCLUDE_ALLOCATIONTRACKER_H_
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+// Counts the allocations made through the global operator new and
+// delete, which are replaced by AllocationHook.o: only the programs
+// linked with it can track their allocations. Until enable() is
+// called the replacements only test a flag. The allocations are
+// charged to the innermost profiled scope of the thread (see
+// Profiler.h) or to no scope; a free is charged where it happens.
+// The live bytes are the usable sizes malloc gives, the bytes
+// allocated are the sizes asked for; what was allocated before
+// enable() and freed after lowers the live bytes.
+//
+// Building with -DNO_PROFILING leaves operator new and delete alone.
+namespace AllocationTracker
+{
+    // Start counting in all the threads; false if the tracking is
+    // compiled out or AllocationHook.o is not linked in
+    bool enable();
+    bool enabled();
+
+    // Used by the replaced operator new and delete
+    void *allocate(size_t size);
+    void release(void *ptr);
+    void hookLinked();
+
+    // Used by Profiler::ScopedTimer to charge the allocations of a
+    // scope to its timer
+    struct Scope
+    {
+        int outerStage;
+        int64_t baseBytes;
+        int64_t outerPeakBytes;
+    };
+    bool startScope(int timerId, Scope& scope);
+    void stopScope(int timerId, const Scope& scope);
+
+    // The allocations charged to one timer, merged over the threads
+    struct StageReport
+    {
+        // -1 for the allocations out of any scope
+        int timerId;
+        uint64_t scopes;
+        uint64_t allocations;
+        uint64_t frees;
+        uint64_t bytes;
+        // The most the live bytes of the thread grew within one scope
+        int64_t peakLiveBytes;
+        // The largest ru_maxrss seen at the end of a scope
+        long maxRssKb;
+    };
+
+    // The timers which allocated or freed, then those out of scope
+    void snapshot(std::vector<StageReport>& stages);
+
+    // Of the whole process, since enable()
+    int64_t liveBytes();
+    int64_t peakLiveBytes();
+    uint64_t allocations();
+    // ru_maxrss of the process now
+    long maxRssKb();
+
+    // Clear the counts, the peak starts again from the live bytes
+    void reset();
+}
+
+#endif // _INCLUDE_ALLOCATIONTRACKER_H_
@@ -0,0 +1,123 @@
+#ifndef _INCLUDE_CALENDAR_H_
+#define _INCLUDE_CALENDAR_H_
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include "Date.h"
+
+// Business day calendar: weekends plus a list of holidays.
+// The business days of a fixed range of dates are precomputed
+// into a bitmap, the number of business days before every
+// 64-day word (rank) and the position of every business day
+// (select), so that adjusting a date, adding business days and
+// counting business days are all constant time. Dates outside
+// of the range are only adjusted, by skipping weekends.
+class Calendar
+{
+    public:
+        enum ADJUSTMENT {FOLLOWING, MODIFIEDFOLLOWING, PRECEDING};
+
+        // The range covered by the tables, unless given otherwise
+        static const boost::gregorian::date defaultFirstDate;
+        static const boost::gregorian::date defaultLastDate;
+
+        // Weekends only
+        Calendar();
+        Calendar(const std::string& name,
+                const std::vector<Date>& holidays,
+                const boost::gregorian::date& firstDate = defaultFirstDate,
+                const boost::gregorian::date& lastDate = defaultLastDate);
+
+        ~Calendar();
+
+        // Load the holidays from a csv file, one date per line
+        // in the first column; lines whose first column is not
+        // a date (e.g. a header) are skipped
+        static Calendar fromCSV(const std::string& filename,
+                const std::string& name);
+
+        // A day is a business day of the joint calendar if it is
+        // one in both calendars; the range is the intersection
+        static Calendar joint(const Calendar& lhs, const Calendar& rhs);
+
+        inline const std::string& name() const {return _name;}
+        // Unique for every distinct set of tables, copies share it;
+        // used to key caches of dates adjusted with the calendar
+        inline unsigned long id() const {return _id;}
+        inline const std::vector<Date>& holidays() const {return _holidays;}
+
+        bool isBusinessDay(const Date& date) const;
+
+        Date adjust(const Date& date,
+                Calendar::ADJUSTMENT adjustment = FOLLOWING) const;
+
+        // The n-th business day after (n > 0) or before (n < 0)
+        // the date; for n == 0 the date adjusted to following
+        Date addBusinessDays(const Date& date, int n) const;
+
+        // Number of business days in [from, to), negative if
+        // to is earlier than from
+        long businessDaysBetween(const Date& from, const Date& to) const;
+
+        // The calendar WorkDate adjusts with, weekends only until
+        // set. Set it before starting any thread that uses dates.
+        static const Calendar& workCalendar();
+        static void setWorkCalendar(const Calendar& calendar);
+
+    private:
+        void _build();
+
+        inline bool _inRange(long index) const
+        {
+            return index >= 0 && index < _numDays;
+        }
+
+        inline long _index(const boost::gregorian::date& date) const
+        {
+            return (long)date.day_number() - _firstDayNumber;
+        }
+
+        inline bool _isBusinessDay(long index) const
+        {
+            return (_bits[index >> 6] >> (index & 63)) & 1;
+        }
+
+        // Number of business days in [0, index)
+        inline long _rank(long index) const
+        {
+            long word = index >> 6;
+            long bit = index & 63;
+            long rank = _wordRanks[word];
+            if(bit != 0)
+                rank += __builtin_popcountll(_bits[word] & ((~0ULL) >> (64 - bit)));
+            return rank;
+        }
+
+        std::string _name;
+        unsigned long _id;
+        std::vector<Date> _holidays;
+        boost::gregorian::date _firstDate;
+        boost::gregorian::date _lastDate;
+        long _firstDayNumber;
+        long _numDays;
+
+        std::vector<boost::uint64_t> _bits;
+        // business days before every word, one extra entry
+        // for the end of the range
+        std::vector<long> _wordRanks;
+        // day index of every business day
+        std::vector<int> _businessDays;
+};
+
+class CalendarException : public std::runtime_error
+{
+    public:
+        CalendarException(const std::string& errorStr):
+            std::runtime_error(errorStr){};
+};
+
+#endif // _INCLUDE_CALENDAR_H_
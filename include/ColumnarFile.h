@@ -0,0 +1,171 @@
+#ifndef _INCLUDE_COLUMNARFILE_H_
+#define _INCLUDE_COLUMNARFILE_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "Date.h"
+#include "OutputWriter.h"
+
+// Binary columnar result file, laid out so that a reader can
+// mmap() it and use the columns in place:
+//
+//   ColumnarFileHeader
+//   ColumnarColumnDesc x numColumns
+//   chunk 0: ColumnarChunkHeader, column buffers 0 .. numColumns-1
+//   chunk 1: ...
+//   chunk directory: uint64_t offset of every chunk
+//   ColumnarFileTrailer
+//
+// Everything is in the byte order of the host that wrote the file,
+// so that the columns can be used in place; byteOrder in the header
+// tells a reader on a host of the other order to reject the file.
+// Every header, descriptor and
+// column buffer starts at a multiple of 64 bytes, which is the
+// buffer alignment Arrow uses, and a column buffer is a plain
+// array of numRows fixed-width values without null bitmaps.
+namespace Columnar
+{
+    enum COLUMNTYPE {INT32 = 1,
+                     INT64 = 2,
+                     FLOAT64 = 3,
+                     // Days since 1970-01-01 as int32, like Arrow date32
+                     DATE32 = 4};
+
+    const size_t alignment = 64;
+    // Reads as 0x04030201 on a host of the other byte order
+    const uint32_t byteOrderMark = 0x01020304;
+
+    struct ColumnarFileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numColumns;
+        uint32_t headerSize;
+        uint32_t byteOrder;
+        uint32_t reserved[10];
+    };
+
+    struct ColumnarColumnDesc
+    {
+        char name[56];
+        uint32_t type;
+        uint32_t width;
+    };
+
+    struct ColumnarChunkHeader
+    {
+        char magic[8];
+        uint64_t numRows;
+        uint64_t chunkSize;
+        uint64_t reserved[5];
+    };
+
+    struct ColumnarFileTrailer
+    {
+        uint64_t numChunks;
+        uint64_t numRows;
+        uint64_t directoryOffset;
+        char magic[8];
+    };
+
+    typedef std::vector<std::pair<std::string, COLUMNTYPE> > Schema;
+
+    // Return the number of days from 1970-01-01 to the date
+    int32_t toDate32(const Date& date);
+    Date fromDate32(int32_t days);
+
+    // Append rows to a columnar file. Values are set column by
+    // column for the current row and endRow() completes it;
+    // every rowsPerChunk rows the chunk is written out.
+    class ColumnarWriter
+    {
+        public:
+            static const size_t defaultRowsPerChunk = 1 << 16;
+
+            ColumnarWriter(const std::string& filename,
+                    const Schema& schema,
+                    size_t rowsPerChunk = defaultRowsPerChunk);
+            // Calls close() if it has not been called
+            ~ColumnarWriter();
+
+            void setInt32(int column, int32_t value);
+            void setInt64(int column, int64_t value);
+            void setFloat64(int column, double value);
+            void setDate(int column, const Date& date);
+            void endRow();
+
+            // Write the last chunk, the directory and the trailer
+            void close();
+
+        private:
+            ColumnarWriter(const ColumnarWriter&);
+            ColumnarWriter& operator=(const ColumnarWriter&);
+
+            void _set(int column, COLUMNTYPE type, const void *value);
+            void _writeChunk();
+            void _pad();
+
+            Schema _schema;
+            std::vector<int> _widths;
+            std::vector<std::vector<char> > _columns;
+            std::vector<char> _rowSet;
+            size_t _rowsPerChunk;
+            size_t _numRowsInChunk;
+            uint64_t _numRows;
+            uint64_t _offset;
+            std::vector<uint64_t> _chunkOffsets;
+            BufferedWriter _writer;
+            bool _closed;
+    };
+
+    // Read-only, zero-copy view of a columnar file through mmap()
+    class ColumnarReader
+    {
+        public:
+            explicit ColumnarReader(const std::string& filename);
+            ~ColumnarReader();
+
+            inline int numColumns() const {return (int)_descs.size();}
+            inline uint64_t numRows() const {return _numRows;}
+            inline int numChunks() const {return (int)_chunks.size();}
+
+            std::string columnName(int column) const;
+            COLUMNTYPE columnType(int column) const;
+            // Return the column index of the name, -1 if not found
+            int findColumn(const std::string& name) const;
+
+            uint64_t chunkRows(int chunk) const;
+
+            // Pointers into the mapped file, valid as long as
+            // the reader is alive
+            const int32_t *int32Column(int chunk, int column) const;
+            const int64_t *int64Column(int chunk, int column) const;
+            const double *float64Column(int chunk, int column) const;
+
+        private:
+            ColumnarReader(const ColumnarReader&);
+            ColumnarReader& operator=(const ColumnarReader&);
+
+            const void *_column(int chunk, int column,
+                    COLUMNTYPE type) const;
+
+            const char *_data;
+            size_t _size;
+            std::vector<const ColumnarColumnDesc *> _descs;
+            std::vector<const ColumnarChunkHeader *> _chunks;
+            uint64_t _numRows;
+    };
+
+    class ColumnarFileException : public std::runtime_error
+    {
+        public:
+            ColumnarFileException(const std::string& errorStr):
+                std::runtime_error(errorStr){};
+    };
+}
+
+#endif // _INCLUDE_COLUMNARFILE_H_
@@ -0,0 +1,412 @@
+#ifndef _INCLUDE_CONCURRENCY_H_
+#define _INCLUDE_CONCURRENCY_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdexcept>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+namespace Concurrency
+{
+    // Return the number of online processors, at least 1
+    int hardwareConcurrency();
+
+    // A unit of work executed by the worker threads
+    class Runnable
+    {
+        public:
+            virtual ~Runnable(){};
+            virtual void run() = 0;
+    };
+
+    // Execute all the jobs using at most numThreads threads
+    // and return after every job is finished. The jobs are
+    // handed out in order, one at a time, to the next idle
+    // thread. If a job throws, the first error message is
+    // rethrown as ConcurrencyException after all threads
+    // are joined.
+    void runAll(std::vector<Runnable *>& jobs, int numThreads);
+
+    // A thread running one Runnable, started on construction
+    // and joined by join() or at the latest by the destructor
+    class Thread
+    {
+        public:
+            explicit Thread(Runnable& runnable);
+            ~Thread();
+
+            void join();
+
+        private:
+            Thread(const Thread&);
+            Thread& operator=(const Thread&);
+
+            pthread_t _thread;
+            bool _joinable;
+    };
+
+    // Spin for a while, then give up the processor, then sleep
+    // briefly; used by the lock-free waits instead of blocking
+    // on a mutex
+    inline void backoff(int& spins)
+    {
+        if(spins < 64)
+        {
+            spins ++;
+        }
+        else if(spins < 1024)
+        {
+            spins ++;
+            sched_yield();
+        }
+        else
+        {
+            struct timespec pause = {0, 50000};
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    // Bounded single-producer single-consumer ring buffer. It is
+    // lock-free: exactly one thread may push and exactly one
+    // (other) thread may pop, and they only synchronize through
+    // the head and tail indices. The capacity is rounded up to
+    // a power of two.
+    template<class T>
+    class BoundedSPSCQueue
+    {
+        public:
+            explicit BoundedSPSCQueue(size_t capacity);
+
+            bool tryPush(const T& item);
+            bool tryPop(T& item);
+
+            // Wait until there is room / an item
+            void push(const T& item);
+            T pop();
+
+        private:
+            BoundedSPSCQueue(const BoundedSPSCQueue&);
+            BoundedSPSCQueue& operator=(const BoundedSPSCQueue&);
+
+            std::vector<T> _items;
+            size_t _mask;
+            // Keep the indices written by the consumer and the
+            // producer on different cache lines
+            char _pad0[64];
+            volatile size_t _head;
+            char _pad1[64];
+            volatile size_t _tail;
+            char _pad2[64];
+    };
+
+    // Run tasks on a pool of threads as soon as all the tasks
+    // they depend on are finished. Tasks may be added while the
+    // graph is running, also from inside a running task, so a
+    // task can expand the graph as it discovers more work. The
+    // tasks are not owned by the graph and must stay alive until
+    // run() returns.
+    class TaskGraph
+    {
+        public:
+            typedef int TaskId;
+
+            TaskGraph();
+            ~TaskGraph();
+
+            // Add a task depending on the given tasks, which may
+            // already be finished; return the id of the new task
+            TaskId addTask(Runnable& task);
+            TaskId addTask(Runnable& task, TaskId dependency);
+            TaskId addTask(Runnable& task,
+                    const std::vector<TaskId>& dependencies);
+
+            // Execute the tasks using numThreads threads, including
+            // the calling one, and return when no task is left. If
+            // a task throws, no further task is started and the
+            // first error message is rethrown as
+            // ConcurrencyException once the running tasks finish.
+            void run(int numThreads);
+
+        private:
+            TaskGraph(const TaskGraph&);
+            TaskGraph& operator=(const TaskGraph&);
+
+            struct Node
+            {
+                Runnable *task;
+                int numPendingDependencies;
+                bool finished;
+                std::vector<TaskId> dependents;
+            };
+
+            static void *_workerMain(void *arg);
+            void _work();
+
+            // Both guarded by _lock
+            std::deque<Node> _nodes;
+            std::deque<TaskId> _readyTasks;
+
+            int _numUnfinished;
+            bool _hasError;
+            std::string _errorMessage;
+            pthread_mutex_t _lock;
+            pthread_cond_t _changed;
+    };
+
+    // Publication of immutable snapshots to concurrent readers
+    // (epoch-based reclamation). A writer builds a new object and
+    // publish()es it with an atomic pointer swap; a reader pins
+    // the current snapshot with a Pin, which announces the epoch
+    // it started in and never blocks on writers. A replaced
+    // snapshot is deleted once every reader pinned in its epoch
+    // or before has unpinned. Writers are serialized by a mutex.
+    // At most maxReaders pins may be held at once, more pins wait
+    // for a free slot.
+    template<class T>
+    class SnapshotHolder
+    {
+        public:
+            explicit SnapshotHolder(T *initial = NULL,
+                    int maxReaders = 64);
+            // No pin may be alive
+            ~SnapshotHolder();
+
+            // Take ownership of snapshot and make it the current
+            // one, then delete what no reader can see any more
+            void publish(T *snapshot);
+
+            // Number of replaced snapshots not deleted yet
+            size_t numRetired();
+
+            class Pin
+            {
+                public:
+                    explicit Pin(SnapshotHolder& holder);
+                    ~Pin();
+
+                    // NULL if nothing was published yet
+                    inline const T *get() const {return _snapshot;}
+                    inline const T& operator*() const {return *_snapshot;}
+                    inline const T *operator->() const {return _snapshot;}
+
+                private:
+                    Pin(const Pin&);
+                    Pin& operator=(const Pin&);
+
+                    SnapshotHolder& _holder;
+                    int _slot;
+                    const T *_snapshot;
+            };
+
+        private:
+            SnapshotHolder(const SnapshotHolder&);
+            SnapshotHolder& operator=(const SnapshotHolder&);
+
+            // An announced epoch + 1, 0 if free; one per cache line
+            struct Slot
+            {
+                volatile unsigned long epoch;
+                char pad[64 - sizeof(unsigned long)];
+            };
+
+            // With _lock held
+            void _reclaim();
+
+            T * volatile _current;
+            volatile unsigned long _epoch;
+            std::vector<Slot> _slots;
+
+            // Both guarded by _lock
+            std::vector<T *> _retired;
+            std::vector<unsigned long> _retiredEpochs;
+            pthread_mutex_t _lock;
+    };
+
+    class ConcurrencyException : public std::runtime_error
+    {
+        public:
+            ConcurrencyException(const std::string& errorStr):
+                std::runtime_error(errorStr){};
+    };
+}
+
+template<class T>
+Concurrency::BoundedSPSCQueue<T>::BoundedSPSCQueue(size_t capacity):
+    _head(0), _tail(0)
+{
+    size_t size = 2;
+    while(size < capacity)
+        size <<= 1;
+
+    _items.resize(size);
+    _mask = size - 1;
+}
+
+template<class T>
+bool Concurrency::BoundedSPSCQueue<T>::tryPush(const T& item)
+{
+    size_t tail = _tail;
+    if(tail - _head > _mask)
+        return false;
+
+    _items[tail & _mask] = item;
+    // Publish the item before the new tail
+    __sync_synchronize();
+    _tail = tail + 1;
+    return true;
+}
+
+template<class T>
+bool Concurrency::BoundedSPSCQueue<T>::tryPop(T& item)
+{
+    size_t head = _head;
+    if(head == _tail)
+        return false;
+
+    // Read the item only after seeing the tail that published it
+    __sync_synchronize();
+    item = _items[head & _mask];
+    __sync_synchronize();
+    _head = head + 1;
+    return true;
+}
+
+template<class T>
+void Concurrency::BoundedSPSCQueue<T>::push(const T& item)
+{
+    int spins = 0;
+    while(!tryPush(item))
+        backoff(spins);
+}
+
+template<class T>
+T Concurrency::BoundedSPSCQueue<T>::pop()
+{
+    T item;
+    int spins = 0;
+    while(!tryPop(item))
+        backoff(spins);
+
+    return item;
+}
+
+template<class T>
+Concurrency::SnapshotHolder<T>::SnapshotHolder(T *initial, int maxReaders):
+    _current(initial), _epoch(0), _slots(maxReaders > 0 ? maxReaders : 1)
+{
+    for(int i = 0; i < (int)_slots.size(); i ++)
+        _slots[i].epoch = 0;
+    pthread_mutex_init(&_lock, NULL);
+}
+
+template<class T>
+Concurrency::SnapshotHolder<T>::~SnapshotHolder()
+{
+    for(int i = 0; i < (int)_retired.size(); i ++)
+        delete _retired[i];
+    delete _current;
+    pthread_mutex_destroy(&_lock);
+}
+
+template<class T>
+void Concurrency::SnapshotHolder<T>::publish(T *snapshot)
+{
+    pthread_mutex_lock(&_lock);
+
+    // The swap is a full barrier: a reader announcing an epoch
+    // after the increment below reads the new snapshot
+    T *previous = __sync_lock_test_and_set(&_current, snapshot);
+    __sync_synchronize();
+    unsigned long epoch = _epoch;
+    if(previous != NULL)
+    {
+        _retired.push_back(previous);
+        _retiredEpochs.push_back(epoch);
+    }
+    __sync_fetch_and_add(&_epoch, 1);
+
+    _reclaim();
+    pthread_mutex_unlock(&_lock);
+}
+
+template<class T>
+size_t Concurrency::SnapshotHolder<T>::numRetired()
+{
+    pthread_mutex_lock(&_lock);
+    _reclaim();
+    size_t numRetired = _retired.size();
+    pthread_mutex_unlock(&_lock);
+    return numRetired;
+}
+
+template<class T>
+void Concurrency::SnapshotHolder<T>::_reclaim()
+{
+    // The oldest epoch still announced by a reader
+    unsigned long oldest = _epoch;
+    for(int i = 0; i < (int)_slots.size(); i ++)
+    {
+        unsigned long announced = _slots[i].epoch;
+        if(announced != 0 && announced - 1 < oldest)
+            oldest = announced - 1;
+    }
+
+    // A snapshot retired in epoch e may still be read by the
+    // readers that announced e or earlier
+    size_t kept = 0;
+    for(size_t i = 0; i < _retired.size(); i ++)
+    {
+        if(_retiredEpochs[i] < oldest)
+        {
+            delete _retired[i];
+        }
+        else
+        {
+            _retired[kept] = _retired[i];
+            _retiredEpochs[kept] = _retiredEpochs[i];
+            kept ++;
+        }
+    }
+    _retired.resize(kept);
+    _retiredEpochs.resize(kept);
+}
+
+template<class T>
+Concurrency::SnapshotHolder<T>::Pin::Pin(SnapshotHolder& holder):
+    _holder(holder)
+{
+    int numSlots = (int)holder._slots.size();
+    // Start at a slot of our own, most of the time it is free
+    _slot = (int)(((unsigned long)pthread_self() >> 6) % numSlots);
+
+    int spins = 0;
+    while(true)
+    {
+        // Announcing an epoch older than the current one is
+        // only conservative
+        unsigned long epoch = holder._epoch;
+        if(__sync_bool_compare_and_swap(&holder._slots[_slot].epoch,
+                    0UL, epoch + 1))
+            break;
+
+        _slot = (_slot + 1) % numSlots;
+        if(_slot == 0)
+            backoff(spins);
+    }
+
+    // The compare and swap is a full barrier, the snapshot is
+    // read after the epoch is announced
+    _snapshot = holder._current;
+}
+
+template<class T>
+Concurrency::SnapshotHolder<T>::Pin::~Pin()
+{
+    __sync_synchronize();
+    _holder._slots[_slot].epoch = 0;
+}
+
+#endif // _INCLUDE_CONCURRENCY_H_
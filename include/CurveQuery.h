@@ -0,0 +1,63 @@
+#ifndef _INCLUDE_CURVEQUERY_H_
+#define _INCLUDE_CURVEQUERY_H_
+
+#include <vector>
+#include <boost/tuple/tuple.hpp>
+
+#include "Date.h"
+#include "YieldCurve.h"
+
+// (work date, discount factor, curve value) of a query
+typedef boost::tuple<Date, double, double> CurveQueryResult;
+
+// Receive the results of StreamingCurveQuery batch by batch
+class CurveQuerySink
+{
+    public:
+        virtual ~CurveQuerySink(){};
+        virtual void consume(const std::vector<CurveQueryResult>& results) = 0;
+};
+
+// Bounded-memory pipeline for query streams of any length,
+// including pipes. A reader thread cuts the input into batches,
+// numEvaluators threads parse and resolve the batches, each with
+// one sorted sweep over the curve points, and the calling thread
+// passes the results to the sink in input order.
+// The stages are connected by bounded lock-free queues and a
+// fixed pool of batches is recycled, so the memory used does
+// not depend on the size of the input. The curve is solved
+// completely when the query is made.
+class StreamingCurveQuery
+{
+    public:
+        static const size_t defaultBatchBytes = 1 << 18;
+
+        StreamingCurveQuery(const YieldCurveInstance& instYC,
+                int numEvaluators,
+                size_t batchBytes = defaultBatchBytes,
+                YieldCurveInstance::EXTRAPOLATION extrapolation =
+                    YieldCurveInstance::NOEXTRAPOLATION);
+        ~StreamingCurveQuery();
+
+        // Read the whitespace separated query dates from the
+        // file descriptor until the end of file. If skipHeader
+        // is true the first line is ignored. Dates that cannot be
+        // parsed, or are out of the range of the curve and not
+        // extrapolated, are dropped.
+        void run(int fd, bool skipHeader, CurveQuerySink& sink) const;
+
+        // Parse a date of the form yyyy/mm/dd or yyyy-mm-dd
+        // without going through the generic date parser, other
+        // forms fall back to Date(const std::string&).
+        // Return false if the text is not a valid date.
+        static bool parseDate(const char *begin, const char *end,
+                Date& date);
+
+    private:
+        const YieldCurveInstance& _instYC;
+        int _numEvaluators;
+        size_t _batchBytes;
+        YieldCurveInstance::EXTRAPOLATION _extrapolation;
+};
+
+#endif // _INCLUDE_CURVEQUERY_H_
@@ -0,0 +1,164 @@
+#ifndef _INCLUDE_CURVESTORE_H_
+#define _INCLUDE_CURVESTORE_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "Date.h"
+#include "YieldCurve.h"
+
+// Curves shared between processes through POSIX shared memory.
+// A manager builds a named set of curves once and publishes it
+// as an immutable snapshot; any number of worker processes map
+// the snapshot read-only and take its curves as they are, with
+// no bootstrap of their own.
+//
+// A store is a small directory segment /<store> holding the
+// version of the current snapshot, and one segment per snapshot,
+// /<store>.<version>:
+//
+//   CurveStoreHeader
+//   CurveStoreEntry x numCurves, sorted by name
+//   curve 0: int32 dates (days since 1970-01-01), double values,
+//            double deltaTs, numPoints of each
+//   curve 1: ...
+//
+// Every entry and array starts at a multiple of 64 bytes. A
+// snapshot is never modified: publishing writes a new segment,
+// switches the directory to it and unlinks the previous one,
+// which stays mapped by the readers still attached to it.
+
+struct CurveStoreDirectory
+{
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t reserved0;
+    // The version of the current snapshot, 0 before the first
+    volatile uint64_t version;
+    uint64_t reserved[5];
+};
+
+struct CurveStoreHeader
+{
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t numCurves;
+    uint64_t version;
+    uint64_t size;
+    uint64_t reserved[4];
+};
+
+struct CurveStoreEntry
+{
+    char name[64];
+    uint32_t type;
+    int32_t startDate;
+    uint32_t numPoints;
+    uint32_t reserved0;
+    double compoundFreq;
+    // of the dates from the start of the segment, the values and
+    // the deltaTs follow at 64-byte boundaries
+    uint64_t offset;
+    uint64_t reserved[4];
+};
+
+// Build a snapshot and publish it. There is one writer per store.
+class CurveStoreWriter
+{
+    public:
+        explicit CurveStoreWriter(const std::string& storeName);
+        ~CurveStoreWriter();
+
+        // Copy the points of a curve, bootstrapping it completely,
+        // into the next snapshot; a name added twice is replaced
+        void add(const std::string& curveName, const YieldCurveInstance& curve);
+
+        // Write the curves added so far as the new snapshot and
+        // make it current; return its version. The curves stay
+        // added for the next snapshot.
+        uint64_t publish();
+
+        // Unlink the directory and the current snapshot
+        static void remove(const std::string& storeName);
+
+    private:
+        CurveStoreWriter(const CurveStoreWriter&);
+        CurveStoreWriter& operator=(const CurveStoreWriter&);
+
+        struct Curve
+        {
+            std::string name;
+            YieldCurveDefinition::CURVETYPE type;
+            double compoundFreq;
+            Date startDate;
+            std::vector<int32_t> dates;
+            std::vector<double> values;
+            std::vector<double> deltaTs;
+        };
+
+        std::string _storeName;
+        std::map<std::string, Curve> _curves;
+        CurveStoreDirectory *_directory;
+};
+
+// Attach to the current snapshot of a store, read-only. The
+// snapshot stays mapped while the reader is attached to it, and
+// its curves are complete views of the storage policies they were
+// published with, reading their points in place: they are used
+// like the curves bindData returns, with no copy of any point.
+class CurveStoreReader
+{
+    public:
+        explicit CurveStoreReader(const std::string& storeName);
+        ~CurveStoreReader();
+
+        inline uint64_t version() const {return _version;}
+        inline int numCurves() const {return (int)_curves.size();}
+        inline const std::string& curveName(int i) const {return _names[i];}
+        inline const YieldCurveInstance& curve(int i) const {return *_curves[i];}
+
+        // NULL if there is no curve of the name
+        const YieldCurveInstance *find(const std::string& curveName) const;
+
+        // Whether a newer snapshot was published since attaching
+        bool isStale() const;
+        // Attach to the current snapshot if it is newer, return
+        // whether it was; the curves of the previous snapshot are
+        // deleted and it is unmapped
+        bool refresh();
+
+    private:
+        CurveStoreReader(const CurveStoreReader&);
+        CurveStoreReader& operator=(const CurveStoreReader&);
+
+        // Map the current snapshot and make views of its curves
+        // into names and curves; the caller owns the curves and
+        // the mapping of snapshotSize bytes at snapshot
+        uint64_t _load(std::vector<std::string>& names,
+                std::vector<YieldCurveInstance *>& curves, void *& snapshot,
+                size_t& snapshotSize) const;
+        // Delete the curves and unmap their snapshot
+        void _clear();
+
+        std::string _storeName;
+        const CurveStoreDirectory *_directory;
+        uint64_t _version;
+        // sorted by name
+        std::vector<std::string> _names;
+        std::vector<YieldCurveInstance *> _curves;
+        // The mapping the curves read
+        void *_snapshot;
+        size_t _snapshotSize;
+};
+
+class CurveStoreException : public std::runtime_error
+{
+    public:
+        CurveStoreException(const std::string& errorStr):
+            std::runtime_error(errorStr){};
+};
+
+#endif // _INCLUDE_CURVESTORE_H_
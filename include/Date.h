@@ -6,6 +6,65 @@
 #include <stdexcept>
 #include <boost/date_time/gregorian/gregorian.hpp>
 
+// A tenor as the exact number of months and days it adds to a
+// date, e.g. 1Y is (12, 0) and 2W is (0, 14). Tenors compare by
+// an integer sort key which orders months against days with the
+// 30.42 days per month of Duration, ties between different pairs
+// are broken by the months. The operations are inline functions
+// rather than constexpr, the code base is C++03.
+class Tenor
+{
+    public:
+        Tenor():_months(0), _days(0){};
+        Tenor(int months, int days):
+            _months(months), _days(days){};
+
+        inline int months() const {return _months;}
+        inline int days() const {return _days;}
+
+        // Hundredths of a day
+        inline long sortKey() const
+        {
+            return _months * 3042L + _days * 100L;
+        }
+
+        inline bool operator==(const Tenor& rhs) const
+        {
+            return _months == rhs._months && _days == rhs._days;
+        }
+
+        inline bool operator!=(const Tenor& rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+        inline bool operator<(const Tenor& rhs) const
+        {
+            long key = sortKey();
+            long rhsKey = rhs.sortKey();
+            return key < rhsKey || (key == rhsKey && _months < rhs._months);
+        }
+
+        inline Tenor operator+(const Tenor& rhs) const
+        {
+            return Tenor(_months + rhs._months, _days + rhs._days);
+        }
+
+        inline Tenor operator-(const Tenor& rhs) const
+        {
+            return Tenor(_months - rhs._months, _days - rhs._days);
+        }
+
+        inline Tenor operator*(int rhs) const
+        {
+            return Tenor(_months * rhs, _days * rhs);
+        }
+
+    private:
+        int _months;
+        int _days;
+};
+
 class Duration
 {
     public:
@@ -16,13 +75,15 @@ class Duration
                    YEAR = 4,
                    INVALID = -1};
 
-        Duration():_duration(-1), _type(INVALID){};
+        Duration():_type(INVALID), _duration(-1), _tenor(){};
         explicit Duration(std::string& durStr);
         Duration(double duration, Duration::TYPE type):
-            _duration(duration), _type(type){};
+            _type(type), _duration(duration),
+            _tenor(_toTenor(duration, type)){};
         Duration(const Duration& rDur):
+            _type(rDur._type),
             _duration(rDur._duration),
-            _type(rDur._type){};
+            _tenor(rDur._tenor){};
 
         ~Duration();
 
@@ -30,20 +91,40 @@ class Duration
 
         double getDuration(Duration::TYPE type) const;
         inline Duration::TYPE type() const {return _type;}
+        // What the duration adds to a date, durations compare by
+        // it: whole months, or the whole days of days and weeks,
+        // dropping a part of a day. Scaled durations such as
+        // 1Y / 12 * 7 are taken to the nearest month, a real
+        // fraction of a month to the nearest day, e.g. 1.5M is
+        // 1M 15D. Worked out once, when the duration is made.
+        inline Tenor tenor() const {return _tenor;}
+        // The number of whole periods in the duration, counted on
+        // the tenors when both are months or both are days
+        int periods(const Duration& period) const;
         std::string toString(bool literal = false, bool hasUnit = true) const ;
         std::string toString(Duration::TYPE type,
                 bool literal = false, bool hasUnit = true) const;
         
-        bool operator==(const Duration& ths) const;
-        bool operator<(const Duration& rhs) const;
+        inline bool operator==(const Duration& rhs) const
+        {
+            return _tenor == rhs._tenor;
+        }
+
+        inline bool operator<(const Duration& rhs) const
+        {
+            return _tenor < rhs._tenor;
+        }
         
         Duration operator/(double rhs) const;
         double operator/(const Duration& rhs) const;
         Duration operator*(double rhs) const;
         Duration operator-(const Duration& rhs) const;
     private:
+        static Tenor _toTenor(double duration, Duration::TYPE type);
+
         Duration::TYPE _type;
         double _duration;
+        Tenor _tenor;
 };
 
 class DurationException : public std::runtime_error
@@ -71,6 +152,9 @@ class Date
         // Return the nearest next working day after a given
         // Duration
         Date operator+(const Duration& rhs) const;
+        // Add the months first, keeping the day in the month
+        // where possible, then the days
+        Date operator+(const Tenor& rhs) const;
 
         // Return the duration between two dates
         Duration operator-(const Date& rhs) const;
@@ -91,7 +175,7 @@ class Date
 
 // Calculate normlized difference of the date
 // according to given Date time standard
-double normDiffDate(Date&, Date&, Date::TYPE);
+double normDiffDate(const Date&, const Date&, Date::TYPE);
 
 class DateException : public std::runtime_error
 {
@@ -100,6 +184,9 @@ class DateException : public std::runtime_error
             std::runtime_error(e){};
 };
 
+// The date moved to the following business day of
+// Calendar::workCalendar(), which only skips weekends unless
+// a holiday calendar is set
 class WorkDate : public Date
 {
     public:
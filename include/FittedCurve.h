@@ -0,0 +1,88 @@
+#ifndef _INCLUDE_FITTEDCURVE_H_
+#define _INCLUDE_FITTEDCURVE_H_
+
+#include <vector>
+
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+
+// The parameters of a Nelson-Siegel-Svensson curve: the
+// continuously compounded zero rate at a year fraction t is
+//   beta0 + beta1 * f(t / tau1) + beta2 * g(t / tau1)
+//         + beta3 * g(t / tau2)
+// with f(x) = (1 - exp(-x)) / x and g(x) = f(x) - exp(-x).
+// The betas are rates in decimal, the taus are in years.
+struct NSSParameters
+{
+    double beta0;
+    double beta1;
+    double beta2;
+    double beta3;
+    double tau1;
+    double tau2;
+};
+
+// A smooth curve fitted to the quotes of a curve definition
+// instead of bootstrapped through them. It does not reprice the
+// quotes exactly, but the df and the zero rate of any date are
+// closed-form: no search and no interpolation, which is cheaper
+// for discounting many cash flows. Compare it with the
+// bootstrapped curve with residuals() to decide which to use.
+class NelsonSiegelSvenssonCurve
+{
+    public:
+        NelsonSiegelSvenssonCurve(const NSSParameters& params,
+                const Date& startDate);
+
+        // Fit the parameters as of the work day of asOf by
+        // Levenberg-Marquardt, minimizing the squared differences
+        // of the par rates of the instruments, priced the way the
+        // bootstrap prices them, and their quotes
+        static NelsonSiegelSvenssonCurve fit(const YieldCurveDefinition& ycDef,
+                const InstrumentValues& instrVals, const Date& asOf,
+                int maxIterations = 200);
+
+        inline const NSSParameters& parameters() const {return _params;}
+        inline Date startDate() const {return _startDate;}
+
+        // The model minus the quoted rate of every quote of the
+        // fit, in percent, in the order of InstrumentValues::values
+        inline const std::vector<double>& quoteResiduals() const
+            {return _quoteResiduals;}
+        inline int numIterations() const {return _numIterations;}
+
+        // At a year fraction from the start date
+        double zeroRate(double t) const;
+        inline double df(double t) const {return exp(-zeroRate(t) * t);}
+
+        // At a date, in closed form
+        double zeroRate(const Date& date) const;
+        double getDf(const Date& date) const;
+
+        // The same over arrays of dates, in any order
+        void getZeroRates(const std::vector<Date>& dates,
+                std::vector<double>& rates) const;
+        void getDfs(const std::vector<Date>& dates,
+                std::vector<double>& dfs) const;
+
+        // The fitted minus the bootstrapped continuously
+        // compounded zero rates at the dates, in percent; return
+        // the largest absolute residual. The dates must be in the
+        // range of the bootstrapped curve.
+        double residuals(const YieldCurveInstance& curve,
+                const std::vector<Date>& dates,
+                std::vector<double>& residuals) const;
+
+    private:
+        // The year fractions of the dates from the start date
+        void _yearFractions(const std::vector<Date>& dates,
+                std::vector<double>& ts) const;
+
+        NSSParameters _params;
+        Date _startDate;
+        std::vector<double> _quoteResiduals;
+        int _numIterations;
+};
+
+#endif // _INCLUDE_FITTEDCURVE_H_
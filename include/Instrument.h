@@ -2,22 +2,38 @@
 #define _INCLUDE_INSTRUMENT_H_
 
 #include <string>
+#include <vector>
 #include <functional>
 #include <stdexcept>
 
 #include "Date.h"
 
 // Classes
+
+// An instrument definition is a small tagged value: the type,
+// the maturity tenor, the start tenor of a FRA and the id.
+// Definitions are stored by value in contiguous vectors, so
+// a curve definition needs no allocation per instrument.
 class InstrumentDefinition
 {
     public:
-        ~InstrumentDefinition();
-
         enum TYPE {CASH = 0,
                    FRA  = 1,
                    SWAP = 2,
                    FAKE = 3};
-        static InstrumentDefinition* parseString(
+
+        // The default unit of FRA tenors given without unit
+        static const Duration::TYPE defaultFRADurationType;
+
+        InstrumentDefinition():_index(-1), _type(FAKE){};
+        // CASH, SWAP and FAKE definitions
+        InstrumentDefinition(InstrumentDefinition::TYPE type,
+                const Duration& maturity, int index);
+        // FRA definitions
+        InstrumentDefinition(const Duration& startDuration,
+                const Duration& maturity, int index);
+
+        static InstrumentDefinition parseString(
                 std::string& instrDefStr);
         static std::string typeToString(
                 InstrumentDefinition::TYPE type);
@@ -25,18 +41,19 @@ class InstrumentDefinition
 
         inline enum TYPE type() const {return _type;}
         inline Duration maturity() const {return _maturity;}
+        // The exact maturity, definitions are ordered by it
+        inline const Tenor& maturityTenor() const {return _maturityTenor;}
 
-        virtual std::string subtype() const = 0;
+        // Only meaningful for FRA definitions
+        inline Duration startDuration() const {return _startDuration;}
 
-        InstrumentDefinition* clone();
+        std::string subtype() const;
 
     protected:
-        InstrumentDefinition(const Duration& maturity,
-                const int index);
-        InstrumentDefinition(const InstrumentDefinition& rhs);
-
         int _index;
         Duration  _maturity;
+        Tenor     _maturityTenor;
+        Duration  _startDuration;
         enum TYPE _type;
 };
 
@@ -46,9 +63,6 @@ struct InstrumentDefinitionCompare:
 {
     bool operator()(const InstrumentDefinition& lhs,
             const InstrumentDefinition& rhs) const;
-
-    bool operator()(const InstrumentDefinition* ptrlhs,
-            const InstrumentDefinition* ptrrhs) const;
 };
 
 struct InstrumentDefinitionDurationCompare:
@@ -58,86 +72,10 @@ struct InstrumentDefinitionDurationCompare:
     bool operator()(const InstrumentDefinition& lhs,
             const Duration& rhs) const;
 
-    bool operator()(const InstrumentDefinition* ptrlhs,
-            const Duration* ptrrhs) const;
-
     bool operator()(const Duration& lhs,
             const InstrumentDefinition& rhs) const;
-
-    bool operator()(const Duration* ptrlhs,
-            const InstrumentDefinition* ptrrhs) const;
-};
-
-
-class CASHInstrDefinition:
-    public InstrumentDefinition
-{
-    public:
-        CASHInstrDefinition(Duration& maturity, int index);
-        explicit CASHInstrDefinition(const CASHInstrDefinition& rhs):
-            InstrumentDefinition(rhs){};
-
-        ~CASHInstrDefinition();
-
-        virtual std::string subtype() const;
 };
 
-class FRAInstrDefinition:
-    public InstrumentDefinition
-{
-    public:
-        static const Duration::TYPE defaultDurationType;
-        FRAInstrDefinition(Duration& startDuration, Duration& maturity, int index);
-        explicit FRAInstrDefinition(const FRAInstrDefinition& rhs):
-            _startDuration(rhs._startDuration), 
-            InstrumentDefinition(rhs){};
-
-        ~FRAInstrDefinition();
-
-        virtual std::string subtype() const;
-
-        inline Duration startDuration() const
-        {return _startDuration;}
-    protected:
-        Duration _startDuration;
-};
-
-class SWAPInstrDefinition:
-    public InstrumentDefinition
-
-{
-    public:
-        SWAPInstrDefinition(Duration& maturity, int index);
-        explicit SWAPInstrDefinition(const SWAPInstrDefinition& rhs):
-            InstrumentDefinition(rhs){};
-
-        ~SWAPInstrDefinition();
-
-        virtual std::string subtype() const;
-};
-
-// These instrument definition are not given 
-// by user, but generated by system for
-// assisting building the yield curve
-class FAKEInstrDefinition:
-    public InstrumentDefinition
-{
-    public:
-        FAKEInstrDefinition(Duration& maturity, int index):
-            InstrumentDefinition(maturity, index)
-        {
-            _type = InstrumentDefinition::FAKE;
-        };
-        explicit FAKEInstrDefinition(const FAKEInstrDefinition& rhs):
-            InstrumentDefinition(rhs){};
-
-        ~FAKEInstrDefinition();
-
-        virtual std::string subtype() const;
-};
-
-
-
 class InstrumentValues
 {
     public:
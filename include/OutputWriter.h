@@ -0,0 +1,102 @@
+#ifndef _INCLUDE_OUTPUTWRITER_H_
+#define _INCLUDE_OUTPUTWRITER_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+#include "Date.h"
+
+// Writer with a large reusable buffer for bulk text results.
+// Numbers and dates are formatted straight into the buffer,
+// and the buffer is handed to the kernel with one write()
+// call when it is full or flushed, never line by line.
+class BufferedWriter
+{
+    public:
+        static const size_t defaultBufferSize = 1 << 20;
+
+        // Write to an already opened file descriptor,
+        // which is not closed by the writer
+        explicit BufferedWriter(int fd,
+                size_t bufferSize = defaultBufferSize);
+        // Create (or truncate) the file and write to it
+        explicit BufferedWriter(const std::string& filename,
+                size_t bufferSize = defaultBufferSize);
+
+        ~BufferedWriter();
+
+        inline BufferedWriter& put(char c)
+        {
+            if(_size == _buffer.size())
+                flush();
+            _buffer[_size ++] = c;
+            return *this;
+        }
+
+        inline BufferedWriter& write(const char *str, size_t length)
+        {
+            if(_size + length > _buffer.size())
+            {
+                flush();
+                if(length > _buffer.size())
+                {
+                    _writeAll(str, length);
+                    return *this;
+                }
+            }
+            memcpy(&_buffer[_size], str, length);
+            _size += length;
+            return *this;
+        }
+
+        inline BufferedWriter& write(const std::string& str)
+            {return write(str.data(), str.size());}
+
+        BufferedWriter& writeInt(long long value);
+
+        // Same digits as printf("%.*f"), e.g. std::fixed with
+        // std::setprecision(precision)
+        BufferedWriter& writeFixed(double value, int precision);
+        // Same digits as printf("%.*g"), i.e. the default
+        // floating point format of the iostreams
+        BufferedWriter& writeGeneral(double value, int precision);
+        // The shortest decimal form that reads back to
+        // exactly the same double
+        BufferedWriter& writeShortest(double value);
+
+        // Same text as Date::toString(), e.g. 2013-Jan-22
+        BufferedWriter& writeDate(const Date& date);
+
+        // Write all the buffered bytes to the file
+        void flush();
+
+    private:
+        BufferedWriter(const BufferedWriter&);
+        BufferedWriter& operator=(const BufferedWriter&);
+
+        // Make sure there are at least length free bytes
+        inline char *_reserve(size_t length)
+        {
+            if(_size + length > _buffer.size())
+                flush();
+            return &_buffer[_size];
+        }
+
+        void _writeAll(const char *data, size_t length);
+
+        int _fd;
+        bool _ownFd;
+        std::vector<char> _buffer;
+        size_t _size;
+};
+
+class OutputException : public std::runtime_error
+{
+    public:
+        OutputException(const std::string& errorStr):
+            std::runtime_error(errorStr){};
+};
+
+#endif // _INCLUDE_OUTPUTWRITER_H_
@@ -0,0 +1,50 @@
+#ifndef _INCLUDE_PERFCOUNTERS_H_
+#define _INCLUDE_PERFCOUNTERS_H_
+
+#include <string>
+#include <stdint.h>
+
+// Hardware performance counters of the calling thread, read with
+// perf_event_open on Linux. The counters are often unavailable:
+// in virtual machines without a PMU, under a restrictive
+// kernel.perf_event_paranoid, or on other systems; a group which
+// cannot be opened tells why and reads nothing.
+namespace PerfCounters
+{
+    enum EVENT {CYCLES, INSTRUCTIONS, CACHEMISSES, BRANCHMISSES, NUMEVENTS};
+
+    const char *eventName(int event);
+
+    // The events counted in user space by the thread which opened
+    // the group, over the same intervals. Only the thread which
+    // opened it may read it.
+    class CounterGroup
+    {
+        public:
+            CounterGroup();
+            ~CounterGroup();
+
+            // False if not even the cycles can be counted
+            inline bool isOpen() const {return _fds[CYCLES] >= 0;}
+            // Some events may be missing while the others count
+            inline bool hasEvent(int event) const {return _fds[event] >= 0;}
+            inline const std::string& error() const {return _error;}
+
+            // The counts since the group was opened, scaled up if the
+            // kernel multiplexed the counters; the missing events
+            // read 0. False if the group is not open or cannot be read.
+            bool read(uint64_t values[NUMEVENTS]) const;
+
+        private:
+            CounterGroup(const CounterGroup&);
+            CounterGroup& operator=(const CounterGroup&);
+
+            int _fds[NUMEVENTS];
+            // The position of the event in the group read
+            int _positions[NUMEVENTS];
+            int _numOpen;
+            std::string _error;
+    };
+}
+
+#endif // _INCLUDE_PERFCOUNTERS_H_
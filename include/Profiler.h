@@ -0,0 +1,214 @@
+#ifndef _INCLUDE_PROFILER_H_
+#define _INCLUDE_PROFILER_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <signal.h>
+#include <stdint.h>
+
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+
+// Scoped timers and named counters for the hot paths. The code
+// is instrumented with the macros below:
+//
+//   PROFILE_SCOPE("bindData");
+//   PROFILE_COUNT("pathsSimulated", rounds);
+//
+// Every thread records into its own buffer, without locking;
+// the buffers are merged when the report is taken. Every timer
+// keeps a latency histogram besides the count and the total.
+//
+// The hardware counters of the thread, cycles, instructions, cache
+// and branch misses, and the allocations can be counted over every
+// timed scope too.
+//
+// Building with -DNO_PROFILING removes the instrumentation: the
+// macros expand to nothing, and the timers declared by
+// PROFILE_TIMER read 0.
+namespace Profiler
+{
+    // At most this many distinct timers and counters, the names
+    // registered after are ignored
+    const int maxTimers = 32;
+    const int maxCounters = 32;
+
+    // Monotonic clock in nanoseconds
+    uint64_t now();
+
+    // The id of the name, registered on the first call. The
+    // macros call it once per call site.
+    int timerId(const char *name);
+    int counterId(const char *name);
+
+    // Add to the buffer of the calling thread; the items, e.g.
+    // paths or lookups, are what the time was spent on
+    void record(int timerId, uint64_t ns, uint64_t items = 0);
+    void count(int counterId, uint64_t n);
+
+    // Count the hardware events over the timed scopes as well,
+    // from now on. Return false, with the reason, if the counters
+    // are not available; only the times are recorded then.
+    bool enableHardwareCounters(std::string& error);
+    bool hardwareCountersEnabled();
+
+    // Used by ScopedTimer: read the counters of the thread at the
+    // start of the scope, false if they are not counted, and add
+    // the events since the start at the end
+    bool startHardwareCounters(uint64_t values[PerfCounters::NUMEVENTS]);
+    void stopHardwareCounters(int timerId, uint64_t items,
+            const uint64_t values[PerfCounters::NUMEVENTS]);
+
+    // Record the time from the construction to the destruction,
+    // or to stop() if it is called before
+    class ScopedTimer
+    {
+        public:
+            explicit ScopedTimer(int timerId):
+                _timerId(timerId), _running(true), _items(0),
+                _counting(startHardwareCounters(_events)),
+                _tracking(AllocationTracker::startScope(timerId, _allocations)),
+                _start(now()){};
+            ~ScopedTimer() {stop();}
+
+            inline void stop()
+            {
+                if(_running)
+                {
+                    _running = false;
+                    uint64_t ns = now() - _start;
+                    if(_tracking)
+                        AllocationTracker::stopScope(_timerId, _allocations);
+                    record(_timerId, ns, _items);
+                    if(_counting)
+                        stopHardwareCounters(_timerId, _items, _events);
+                }
+            }
+
+            inline void addItems(uint64_t n) {_items += n;}
+
+            // The time so far
+            inline uint64_t elapsedNs() const {return now() - _start;}
+
+        private:
+            ScopedTimer(const ScopedTimer&);
+            ScopedTimer& operator=(const ScopedTimer&);
+
+            int _timerId;
+            bool _running;
+            uint64_t _items;
+            uint64_t _events[PerfCounters::NUMEVENTS];
+            bool _counting;
+            AllocationTracker::Scope _allocations;
+            bool _tracking;
+            uint64_t _start;
+    };
+
+    // Stands in for ScopedTimer when the profiling is compiled out
+    class NullTimer
+    {
+        public:
+            inline void stop() {}
+            inline void addItems(uint64_t) {}
+            inline uint64_t elapsedNs() const {return 0;}
+    };
+
+    // A timer merged over all the threads, the percentiles are
+    // the upper bounds of their histogram buckets
+    struct TimerReport
+    {
+        std::string name;
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t minNs;
+        uint64_t maxNs;
+        uint64_t p50Ns;
+        uint64_t p90Ns;
+        uint64_t p99Ns;
+        uint64_t items;
+    };
+
+    // The hardware events of the scopes of one timer, in one
+    // thread or, if thread is -1, in all of them. The items are
+    // those of the scopes counted.
+    struct HardwareReport
+    {
+        std::string name;
+        int thread;
+        uint64_t scopes;
+        uint64_t items;
+        uint64_t events[PerfCounters::NUMEVENTS];
+    };
+
+    struct CounterReport
+    {
+        std::string name;
+        uint64_t value;
+    };
+
+    // Merge the buffers of all the threads, in the order the names
+    // were registered. The threads may still be recording, their
+    // latest updates may then be missed.
+    void snapshot(std::vector<TimerReport>& timers,
+            std::vector<CounterReport>& counters);
+
+    // The hardware events of every timer merged, followed by those
+    // of every thread, numbered in the order they started counting;
+    // the timers without any event counted are left out. Empty if
+    // the hardware counters are not enabled.
+    void hardwareSnapshot(std::vector<HardwareReport>& reports);
+    // Whether the event is counted, the others read 0
+    bool hasHardwareEvent(int event);
+
+    // The merged total of one timer or counter, 0 if it has not
+    // been registered
+    uint64_t totalNs(const char *timerName);
+    uint64_t counter(const char *counterName);
+
+    // Clear all the buffers, the names stay registered
+    void reset();
+
+    void writeJson(std::ostream& out);
+    void writeCsv(std::ostream& out);
+    // CSV if the filename ends with .csv, JSON otherwise
+    void writeReport(const std::string& filename);
+
+    // Write the report to the file when the program exits, and
+    // every time the signal is received. Call it before any other
+    // thread is started: the signal is blocked in the threads
+    // created after it and handled by a thread of its own.
+    void dumpOnExit(const std::string& filename, int signalNumber = SIGUSR1);
+}
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+
+#ifndef NO_PROFILING
+
+// Time the enclosing scope with a timer the code can read
+#define PROFILE_TIMER(timer, name) \
+    static const int PROFILER_CONCAT(timer, _profilerId) = \
+        Profiler::timerId(name); \
+    Profiler::ScopedTimer timer(PROFILER_CONCAT(timer, _profilerId))
+
+// Time the enclosing scope
+#define PROFILE_SCOPE(name) \
+    PROFILE_TIMER(PROFILER_CONCAT(profilerScope, __LINE__), name)
+
+#define PROFILE_COUNT(name, n) \
+    do \
+    { \
+        static const int profilerId = Profiler::counterId(name); \
+        Profiler::count(profilerId, (n)); \
+    } while(0)
+
+#else
+
+#define PROFILE_TIMER(timer, name) Profiler::NullTimer timer
+#define PROFILE_SCOPE(name) do {} while(0)
+#define PROFILE_COUNT(name, n) do {} while(0)
+
+#endif
+
+#endif // _INCLUDE_PROFILER_H_
@@ -0,0 +1,147 @@
+#ifndef _INCLUDE_SCENARIOCURVE_H_
+#define _INCLUDE_SCENARIOCURVE_H_
+
+#include <vector>
+
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+
+// The quotes of many scenarios of the same instruments. The
+// matrix is scenario-major: the values of one quote for all the
+// scenarios are contiguous, so every bootstrap step is a loop
+// over contiguous rows.
+class ScenarioQuotes
+{
+    public:
+        // numScenarios copies of the base quotes
+        ScenarioQuotes(const InstrumentValues& base, int numScenarios);
+
+        inline int numQuotes() const {return (int)_quoteIds.size();}
+        inline int numScenarios() const {return _numScenarios;}
+
+        // The instrument ids, in the order of the base values
+        inline const std::vector<int>& quoteIds() const {return _quoteIds;}
+
+        inline double& at(int quote, int scenario)
+            {return _values[quote * _numScenarios + scenario];}
+        inline double at(int quote, int scenario) const
+            {return _values[quote * _numScenarios + scenario];}
+
+        inline const double *row(int quote) const
+            {return &_values[quote * _numScenarios];}
+
+        // Add the same shift to every quote of a scenario
+        void parallelShift(int scenario, double shift);
+        // Add shifts[j] to quote j of a scenario, e.g. a twist or
+        // a historical change
+        void shift(int scenario, const std::vector<double>& shifts);
+
+    private:
+        std::vector<int> _quoteIds;
+        int _numScenarios;
+        std::vector<double> _values;
+};
+
+// A curve definition bootstrapped under every scenario at once.
+// The pillar dates, the schedules and the interpolation weights
+// do not depend on the quotes, so they are resolved once into a
+// plan of steps; the steps are then run in lock-step over all
+// the scenarios, each as loops over contiguous rows that the
+// compiler can vectorize. The result is a pillar-by-scenario
+// matrix of the stored curve values, interpolated the same way
+// as the curve bindData would return.
+class ScenarioCurveSet
+{
+    public:
+        // Bootstrapped as of the work day of asOf, like bindData
+        ScenarioCurveSet(const YieldCurveDefinition& ycDef,
+                const ScenarioQuotes& quotes,
+                YieldCurveDefinition::CURVETYPE type,
+                const Date& asOf);
+        ~ScenarioCurveSet();
+
+        inline int numScenarios() const {return _numScenarios;}
+        inline const std::vector<Date>& pillarDates() const
+            {return _pillarDates;}
+
+        // The df of a pillar for every scenario
+        inline const double *pillarDfs(int pillar) const
+            {return &_dfs[pillar * _numScenarios];}
+
+        // The dfs of a batch of dates for every scenario, the df
+        // of date i under scenario s at i * numScenarios() + s.
+        // found[i] is set to 0 for the dates out of the range of
+        // the curves, no exception is thrown for them.
+        void getDfs(const std::vector<Date>& dates,
+                std::vector<double>& dfs, std::vector<char>& found) const;
+
+    private:
+        ScenarioCurveSet(const ScenarioCurveSet&);
+        ScenarioCurveSet& operator=(const ScenarioCurveSet&);
+
+        // The df of a date from the points known so far: the
+        // stored values of the points lower and upper are
+        // interpolated with upperWeight
+        struct Lookup
+        {
+            int lower;
+            int upper;
+            double upperWeight;
+            double deltaT;
+            // the weight of the df in the sum of a swap
+            double accrual;
+        };
+
+        struct Step
+        {
+            InstrumentDefinition::TYPE type;
+            // rate = the sum of weight * quote, at most two quotes
+            int rateQuotes[2];
+            double rateWeights[2];
+            // the accrual of the last period
+            double deltaT;
+            double deltaTToMaturity;
+            int firstLookup;
+            int numLookups;
+            // the point written, -1 if the point of the same date
+            // already there has priority
+            int point;
+        };
+
+        void _plan(const YieldCurveDefinition& ycDef,
+                const ScenarioQuotes& quotes);
+        // Locate a date among the first numPoints points
+        bool _locate(const Date& date, int numPoints,
+                Lookup& lookup) const;
+        // The same, throw YieldCurveException if the date is out
+        // of the range of the points
+        void _lookup(const Date& date, int numPoints,
+                Lookup& lookup) const;
+
+        template<class POLICY>
+        void _bootstrap(const POLICY& policy, const ScenarioQuotes& quotes);
+        template<class POLICY>
+        void _lookupDfs(const POLICY& policy, const Lookup& lookup,
+                double *dfs) const;
+        template<class POLICY>
+        void _getDfs(const POLICY& policy, const std::vector<Date>& dates,
+                std::vector<double>& dfs, std::vector<char>& found) const;
+
+        YieldCurveDefinition::CURVETYPE _type;
+        double _compoundFreq;
+        int _numScenarios;
+        Date _today;
+
+        std::vector<Step> _steps;
+        std::vector<Lookup> _lookups;
+
+        std::vector<Date> _pillarDates;
+        std::vector<double> _pillarDeltaTs;
+        // pillar-major matrices, a row of all the scenarios for
+        // every pillar: the stored values and the dfs
+        std::vector<double> _values;
+        std::vector<double> _dfs;
+};
+
+#endif // _INCLUDE_SCENARIOCURVE_H_
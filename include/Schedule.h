@@ -0,0 +1,70 @@
+#ifndef _INCLUDE_SCHEDULE_H_
+#define _INCLUDE_SCHEDULE_H_
+
+#include <vector>
+
+#include "Date.h"
+#include "Calendar.h"
+
+// Adjusted date schedules shared by the bootstrap, the par rates
+// and the reports. A schedule is the as-of date plus every tenor
+// of a list, moved to the following business day of a calendar;
+// it is generated once for every (as-of date, tenors, calendar)
+// and then returned from the cache. The tenors are keyed by
+// their exact Tenor, so 12M and 1Y share their dates.
+// The cache is bounded: once full, the schedule used least
+// recently is dropped. It is split in shards of their own lock,
+// so that threads looking up different schedules seldom wait
+// for each other, and a hit does not allocate.
+class Schedule
+{
+    public:
+        // A schedule of the cache, counted by reference: the dates
+        // stay valid as long as a copy of it is alive, also after
+        // the cache dropped them
+        class Dates
+        {
+            public:
+                // Defined by the cache
+                struct Shared;
+
+                // Takes over a reference to shared
+                explicit Dates(Shared *shared);
+                Dates(const Dates& rhs);
+                Dates& operator=(const Dates& rhs);
+                ~Dates();
+
+                inline const std::vector<Date>& get() const {return *_dates;}
+                inline const Date& operator[](int i) const {return (*_dates)[i];}
+                inline size_t size() const {return _dates->size();}
+                inline const Date& front() const {return _dates->front();}
+                inline const Date& back() const {return _dates->back();}
+
+            private:
+                Shared *_shared;
+                const std::vector<Date> *_dates;
+        };
+
+        // asOf + tenors[i] for every tenor
+        static Dates tenorDates(const Date& asOf,
+                const std::vector<Duration>& tenors,
+                const Calendar& calendar = Calendar::workCalendar());
+
+        // asOf + period.tenor() * i for i = 1 ... n, e.g. the
+        // coupon dates of a swap with n periods
+        static Dates periodicDates(const Date& asOf,
+                const Duration& period, int n,
+                const Calendar& calendar = Calendar::workCalendar());
+
+        static Date tenorDate(const Date& asOf, const Duration& tenor,
+                const Calendar& calendar = Calendar::workCalendar());
+
+        // Number of cached schedules, at most capacity()
+        static size_t size();
+        static size_t capacity();
+
+        // Drop every schedule from the cache
+        static void clear();
+};
+
+#endif // _INCLUDE_SCHEDULE_H_
@@ -17,7 +17,7 @@ namespace Stock
         std::vector<std::pair<Date, double> >
             MonteCarloSimulation(double startPrice,
                     Date& startDate, Duration& duration,
-                    int numSteps, YieldCurveInstance& instYC,
+                    int numSteps, const YieldCurveInstance& instYC,
                     double volatility, RNG instRNG); 
 
     }
@@ -36,7 +36,7 @@ template<class RNG>
 std::vector<std::pair<Date, double> > Stock::PricePredictionModel::
 MonteCarloSimulation(double startPrice, Date& startDate,
         Duration& duration, int numSteps, 
-        YieldCurveInstance& instYC, double volatility, RNG instRNG)
+        const YieldCurveInstance& instYC, double volatility, RNG instRNG)
 {
     std::vector<std::pair<Date, double> > predictions(numSteps + 1);
     Date curveStartDate = instYC.startDate();
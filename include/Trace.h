@@ -0,0 +1,95 @@
+#ifndef _INCLUDE_TRACE_H_
+#define _INCLUDE_TRACE_H_
+
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+#include "Profiler.h"
+
+// A timeline of the work of every thread, exported as Chrome
+// trace events for chrome://tracing or Perfetto:
+//
+//   TRACE_SCOPE("bindData");
+//   TRACE_SCOPE_ARG("solveVolatility", "option", optIndex);
+//
+// A scope is recorded as one complete event, its begin and its
+// duration, when it ends. Every thread writes its events to a
+// ring buffer of its own without locking, and keeps the latest
+// ones when the ring is full. While the tracing is not enabled
+// a scope reads the flag once and tests its copy at either end.
+// The names must be string literals, only the pointers are kept.
+//
+// Building with -DNO_PROFILING removes the scopes as well.
+namespace Trace
+{
+    // Set by enable(), read by every scope
+    extern volatile bool tracing;
+
+    // Start recording, every thread keeping at most the given
+    // number of its latest events, rounded up to a power of two
+    void enable(size_t eventsPerThread = 1 << 16);
+    inline bool enabled() {return tracing;}
+
+    // Record an event of the calling thread which began at the
+    // given Profiler::now() time
+    void complete(const char *name, uint64_t beginNs, uint64_t endNs,
+            const char *argName, int64_t arg);
+
+    class ScopedEvent
+    {
+        public:
+            ScopedEvent(const char *name, const char *argName = NULL,
+                    int64_t arg = 0):
+                _recording(tracing), _name(name), _argName(argName),
+                _arg(arg), _beginNs(0)
+            {
+                if(_recording)
+                    _beginNs = Profiler::now();
+            }
+
+            ~ScopedEvent()
+            {
+                if(_recording)
+                    complete(_name, _beginNs, Profiler::now(), _argName, _arg);
+            }
+
+        private:
+            ScopedEvent(const ScopedEvent&);
+            ScopedEvent& operator=(const ScopedEvent&);
+
+            // tracing when the scope began, so that it ends the
+            // same way even if the tracing is enabled meanwhile
+            const bool _recording;
+            const char *_name;
+            const char *_argName;
+            int64_t _arg;
+            uint64_t _beginNs;
+    };
+
+    // The events of all the threads in the trace event format,
+    // the times in microseconds since enable(). The threads may
+    // still be recording: an event overwritten while it is read
+    // is left out.
+    void writeJson(std::ostream& out);
+    void writeJson(const std::string& filename);
+
+    // Write the trace to the file when the program exits
+    void writeOnExit(const std::string& filename);
+}
+
+#ifndef NO_PROFILING
+
+#define TRACE_SCOPE(name) \
+    Trace::ScopedEvent PROFILER_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, arg) \
+    Trace::ScopedEvent PROFILER_CONCAT(traceScope, __LINE__)(name, argName, arg)
+
+#else
+
+#define TRACE_SCOPE(name) do {} while(0)
+#define TRACE_SCOPE_ARG(name, argName, arg) do {} while(0)
+
+#endif
+
+#endif // _INCLUDE_TRACE_H_
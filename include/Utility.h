@@ -3,6 +3,8 @@
 
 #include <utility>
 #include <functional>
+#include <vector>
+#include <cstdlib>
 
 #include "Date.h"
 
@@ -123,14 +125,19 @@ namespace RandomNumberGenerator
     // The generated RNGs ~ N(0,1)
     // The algorithm each time returns two
     // RNGs
+    // Given a seed, the uniform numbers come from rand_r() on it
+    // and every copy of the generator advances the same state, so
+    // a thread can own its sequence; otherwise they come from
+    // the process-wide rand().
     class boxMullerM2RNG
     {
         public:
             enum MODE {ANTITHETIC, NONANTITHETIC};
 
-            boxMullerM2RNG(boxMullerM2RNG::MODE mode):
+            boxMullerM2RNG(boxMullerM2RNG::MODE mode,
+                    unsigned int *seed = NULL):
                 _mode(mode), _numItemInBuf(-1),
-                _buffer(2){};
+                _buffer(2), _seed(seed){};
             ~boxMullerM2RNG(){};
 
             inline double get()
@@ -163,7 +170,12 @@ namespace RandomNumberGenerator
             MODE _mode;
             std::vector<double> _buffer;
             int _numItemInBuf;
+            unsigned int *_seed;
 
+            inline int _uniform()
+            {
+                return _seed == NULL ? rand() : rand_r(_seed);
+            }
             void _genNumbers();
     };
 
@@ -7,8 +7,12 @@
 #include <cmath>
 #include <functional>
 #include <stdexcept>
+#include <stdint.h>
 
 #include "Instrument.h"
+#include "Date.h"
+#include "Concurrency.h"
+#include "Schedule.h"
 class Date; // Forward Declaration of Date class in "Date.h"
 struct DateCompare;
 //class InstrumentDefinition; // Forward Declaration of InstrumentDefinition class in "Instrument.h"
@@ -17,34 +21,90 @@ struct DateCompare;
 typedef std::pair<Date, double> CurveDataType;
 
 class YieldCurveInstance;
+struct CurveJacobian;
+class CurveBootstrap;
 
 class YieldCurveDefinition
 {
     public:
         YieldCurveDefinition(
-                std::vector<InstrumentDefinition *>& instrDefs,
+                const std::vector<InstrumentDefinition>& instrDefs,
                 double compoundFreq);
         ~YieldCurveDefinition();
 
         // Section about Instrument Definitions
-        std::vector<InstrumentDefinition *> getAllDefinitions() const;
+        // All the definitions sorted by maturity, including the
+        // generated FAKE ones; the view lives as long as the
+        // curve definition
+        inline const std::vector<InstrumentDefinition>& getAllDefinitions() const
+            {return _instrDefs;}
+
+        // The maturity dates of all the definitions seen from
+        // asOf, shared through the schedule cache
+        Schedule::Dates getPillarDates(const Date& asOf) const;
 
         // Section about Instrument Values
-        enum CURVETYPE {ZEROCOUPONRATE};
+        // The quantity the curve stores and interpolates
+        // linearly between its points, see the storage policies
+        enum CURVETYPE {ZEROCOUPONRATE,
+                        DISCOUNTFACTOR,
+                        CONTINUOUSRATE,
+                        LOGDISCOUNTFACTOR};
+        // Bootstrap the curve of the values as of the work day
+        // of asOf; the curve keeps the date and measures all its
+        // year fractions from it. bindData may be called from
+        // several threads at once.
+        // The pillars are solved lazily: the curve returned has
+        // none yet, and every query solves them in order up to
+        // the first pillar after the date queried, so short-dated
+        // users never pay for the long swaps.
+        // If jacobian is not NULL, the whole curve is bootstrapped
+        // at once and the derivatives of the pillar discount
+        // factors to the quotes are propagated through it (forward
+        // mode) and stored in the jacobian
         YieldCurveInstance* bindData(InstrumentValues *instrVals,
-                YieldCurveDefinition::CURVETYPE type);
-
-        InstrumentDefinition *getDefinitionByID(int id);
+                YieldCurveDefinition::CURVETYPE type,
+                const Date& asOf,
+                CurveJacobian *jacobian = NULL);
+        // As of today
+        YieldCurveInstance* bindData(InstrumentValues *instrVals,
+                YieldCurveDefinition::CURVETYPE type,
+                CurveJacobian *jacobian = NULL);
+
+        // Build the curves of a range of historical dates, e.g.
+        // for backtests, using numThreads threads: curves[i] is
+        // bound to values[i] as of asOfs[i]. The caller owns the
+        // curves; if any binding fails none is returned and
+        // YieldCurveException is thrown.
+        void bindHistory(std::vector<InstrumentValues>& values,
+                const std::vector<Date>& asOfs,
+                YieldCurveDefinition::CURVETYPE type, int numThreads,
+                std::vector<YieldCurveInstance *>& curves);
+
+        const InstrumentDefinition& getDefinitionByID(int id) const;
     protected:
+        friend class ScenarioCurveSet;
+        friend class CurveBootstrap;
+        friend class NelsonSiegelSvenssonCurve;
+
         void _insertFakeInstrumentDefs();
 
-        // map from the instrument id to the vector index
-        // of the instrument definition
-        std::map<int, int> _instrDefIndicesMap;
+        // Throw YieldCurveException unless every id is defined
+        // and at least O/N and 3M are among at least three values
+        void _checkInstrumentIds(const InstrumentValues& instrVals) const;
+
+        // The vector index of the instrument definition of an
+        // id, -1 if the id is not defined
+        int _definitionIndex(int id) const;
 
-        // FIX: we need a way to better manage the pointers
-        // maybe by using shared_ptr
-        std::vector<InstrumentDefinition *> _instrDefs;
+        // (instrument id, vector index of the instrument
+        // definition) sorted by id
+        std::vector<std::pair<int, int> > _instrDefIndices;
+
+        std::vector<InstrumentDefinition> _instrDefs;
+        // the maturities of _instrDefs, the tenors of the pillar
+        // schedule
+        std::vector<Duration> _maturities;
         double _compoundFreq;
 };
 
@@ -64,87 +124,475 @@ struct CurvePointDesc
 };
 typedef struct CurvePointDesc CurvePoint_t;
 
+// The points of a read-only curve kept in place elsewhere, e.g.
+// in a curve store segment: the dates in days since 1970-01-01,
+// the values and the deltaTs of numPoints points in the order of
+// the curve. The arrays must outlive the curves reading them.
+struct CurvePointArrays
+{
+    CurvePointArrays():
+        numPoints(0), dates(NULL), values(NULL), deltaTs(NULL){};
+
+    int numPoints;
+    const int32_t *dates;
+    const double *values;
+    const double *deltaTs;
+};
+
 class YieldCurveInstance
 {
     public:
         explicit YieldCurveInstance(const YieldCurveInstance& rhs);
         virtual YieldCurveInstance& operator=(const YieldCurveInstance& rhs);
 
-        virtual ~YieldCurveInstance(){};
-
-        // return the start Date of the curve
+        virtual ~YieldCurveInstance();
+
+        // An empty curve of the storage policy of type, as of the
+        // work day startDate; the caller owns it
+        static YieldCurveInstance* create(YieldCurveDefinition::CURVETYPE type,
+                double compoundFreq, const Date& startDate);
+        // A complete curve of the storage policy of type reading
+        // its points in place, which cannot be inserted into; a
+        // copy of it holds its own points. The caller owns it.
+        static YieldCurveInstance* createView(
+                YieldCurveDefinition::CURVETYPE type, double compoundFreq,
+                const Date& startDate, const CurvePointArrays& points);
+
+        // return the start Date of the curve, the as-of work
+        // day it was bound at
         inline Date startDate() const {return _startDate;};
 
-        // insert the data to the curve
-        void insert(CurvePointDesc& data);
+        // The number of points bootstrapped and readable so far,
+        // all of them once the curve is complete
+        inline int numSolvedPoints() const {return _numVisiblePoints;};
+        // Bootstrap every pillar left. A curve bound lazily is
+        // solved under its lock when a reader queries past the
+        // points solved so far; call this before the curve is
+        // shared across threads so that none of them waits.
+        void solveAll() const;
+
+        // The quantity the points store and its compounding
+        // frequency, see the storage policies
+        virtual YieldCurveDefinition::CURVETYPE curveType() const = 0;
+        virtual double compoundFreq() const = 0;
+
+        // insert the data to the curve, return false if a point
+        // of the same date and a higher priority type is kept;
+        // YieldCurveException is thrown for a view
+        bool insert(CurvePointDesc& data);
+
+        // The dates of all the points, the curve is solved first
+        void getPointDates(std::vector<Date>& dates) const;
 
         // This return the actually point value on the curve
         double operator[](Date& date) const;
-        double getDf(Date& date) const;
+        virtual double getDf(Date& date) const;
+
+        // The derivatives of getDf(date) to the discount factors
+        // of the curve points it interpolates between, as
+        // (date of the point, derivative) pairs
+        void getDfWeights(Date& date,
+                std::vector<std::pair<Date, double> >& weights) const;
+
+        // Evaluate the curve value and the df of a batch of
+        // work dates sorted in ascending order, by sweeping the
+        // curve points once instead of searching for every date.
+        // found[i] is set to 0 for the dates out of the range of
+        // the curve, no exception is thrown for them.
+        virtual void sweepSorted(const std::vector<Date>& sortedDates,
+                std::vector<double>& values, std::vector<double>& dfs,
+                std::vector<char>& found) const;
+
+        // How the batch lookups treat the dates after the last
+        // point, or from the start date to the first point:
+        // NOEXTRAPOLATION leaves them out of range, FLATZERO holds
+        // the zero rate of the nearest point, FLATFORWARD the
+        // forward rate of the last segment (of today to the first
+        // point at the short end) and CLAMP takes the value and
+        // the df of the nearest point
+        enum EXTRAPOLATION {NOEXTRAPOLATION = 0,
+                            FLATZERO = 1,
+                            FLATFORWARD = 2,
+                            CLAMP = 3};
+        enum LOOKUPSTATUS {INRANGE = 0,
+                           EXTRAPOLATED = 1,
+                           OUTOFRANGE = 2};
+
+        // Evaluate a batch of work dates, with a status for every
+        // date instead of an exception: the value and the df of
+        // the dates OUTOFRANGE, including the ones before the
+        // start date, are NaN. The dates must be sorted in
+        // ascending order for lookupSorted, any order for lookup.
+        void lookupSorted(const std::vector<Date>& sortedDates,
+                EXTRAPOLATION extrapolation, std::vector<double>& values,
+                std::vector<double>& dfs,
+                std::vector<LOOKUPSTATUS>& status) const;
+        void lookup(const std::vector<Date>& dates,
+                EXTRAPOLATION extrapolation, std::vector<double>& values,
+                std::vector<double>& dfs,
+                std::vector<LOOKUPSTATUS>& status) const;
+
+        // The curve as of a later work date under unchanged
+        // forwards: the points after the new start date are
+        // rebased to df(point) / df(new start date), in one pass
+        // over the points and without bootstrapping again. The new
+        // start date must be before the last point; the short end
+        // is held at a flat zero rate if it is before the first.
+        // The caller owns the curve returned.
+        YieldCurveInstance* rollForward(const Date& newStartDate) const;
+        // The same to many horizons, e.g. a theta ladder, with the
+        // dfs of the points converted once for all of them
+        void rollForward(const std::vector<Date>& newStartDates,
+                std::vector<YieldCurveInstance *>& curves) const;
     protected:
+        friend class CurveBootstrap;
+        friend class CurveStoreWriter;
+        friend class CurveStoreReader;
+
         explicit YieldCurveInstance(const Date& startDate);
 
+        // The number of leading points to read to evaluate the
+        // curve at a work date: every point up to the first one
+        // after the date is solved first if the curve is still
+        // being bootstrapped. The points returned never change.
+        int _solvedPoints(const Date& workDate) const;
+
+        // The lookups on the first numPoints points
+        double _value(const Date& workDate, int numPoints) const;
+        void _dfWeights(const Date& workDate, int numPoints,
+                std::vector<std::pair<Date, double> >& weights) const;
+
+        // The part of sweepSorted() shared by all the curves: the
+        // interpolated values and the year fractions from today
+        void _sweepValues(const std::vector<Date>& sortedDates,
+                std::vector<double>& values, std::vector<double>& deltaTs,
+                std::vector<char>& found) const;
+        // The value and the df of a work date out of the range of
+        // the first numPoints points, not before the start date
+        void _extrapolate(const Date& workDate, EXTRAPOLATION extrapolation,
+                int numPoints, double& value, double& df) const;
+
+        // The functions above on either the points of _curveData
+        // or the ones of a view; POINTS reads one of them
+        template<class POINTS> double _valueOf(const POINTS& points,
+                const Date& workDate, int numPoints) const;
+        template<class POINTS> void _dfWeightsOf(const POINTS& points,
+                const Date& workDate, int numPoints,
+                std::vector<std::pair<Date, double> >& weights) const;
+        template<class POINTS> void _sweepValuesOf(const POINTS& points,
+                const std::vector<Date>& sortedDates,
+                std::vector<double>& values, std::vector<double>& deltaTs,
+                std::vector<char>& found) const;
+        template<class POINTS> void _extrapolateOf(const POINTS& points,
+                const Date& workDate, EXTRAPOLATION extrapolation,
+                int numPoints, double& value, double& df) const;
+        template<class POINTS> void _getPointDatesOf(const POINTS& points,
+                std::vector<Date>& dates) const;
+        template<class POINTS> void _rollForwardOf(const POINTS& points,
+                const std::vector<Date>& newStartDates,
+                std::vector<YieldCurveInstance *>& curves) const;
+
+        // A curve of the same storage policy without any point
+        virtual YieldCurveInstance* _newCurve(const Date& startDate) const = 0;
+
         // void insert() will call this when it
         // inserts the df to the curve, and
         // this function will change the df to
         // the corresponding value
         virtual double _convertDfToSpecific(double df, double deltaT) const = 0;
         virtual double _convertSpecificToDf(double specVal, double deltaT) const = 0; 
+        // and their derivatives
+        virtual double _dDfToSpecific(double df, double deltaT) const = 0;
+        virtual double _dSpecificToDf(double specVal, double deltaT) const = 0;
 
 
-        // Store the Points on the curve
+        // Store the Points on the curve, sorted by date
         std::vector<CurvePoint_t> _curveData;
-
-        // FIX: It seems we do not need this
-        // map from the Date to the vector index of 
-        // _curveDate
-        std::map<Date, int> _curveDataIndicesMap;
+        // The points of a view, read instead of _curveData; no
+        // dates for a curve holding its own points
+        CurvePointArrays _view;
         Date _startDate;
+
+        // The pillars not solved yet, NULL once complete; guarded
+        // by _bootstrapLock
+        mutable CurveBootstrap *_bootstrap;
+        mutable pthread_mutex_t _bootstrapLock;
+        // Points published to the readers: the first
+        // _numVisiblePoints of _curveData, which no later pillar
+        // moves or replaces. Readers take them without locking.
+        mutable volatile int _numVisiblePoints;
+        mutable volatile int _complete;
 };
 
-class ZeroCouponRateCurve:
+// Storage policies of the curves. A policy converts the
+// discount factor at a year fraction deltaT to the stored
+// value and back; the conversions are inline so the curves
+// can be instantiated without any virtual call in the lookup.
+// dFromDf and dToDf are the derivatives of the conversions.
+
+// Periodically compounded zero coupon rate
+struct ZeroCouponRatePolicy
+{
+    static const YieldCurveDefinition::CURVETYPE curveType =
+        YieldCurveDefinition::ZEROCOUPONRATE;
+
+    explicit ZeroCouponRatePolicy(double compoundFreq):
+        _compoundFreq(compoundFreq){};
+
+    inline double fromDf(double df, double deltaT) const
+    {
+        return _compoundFreq * (
+                exp(-log(df) / (_compoundFreq * deltaT)) - 1.0f);
+    };
+    inline double toDf(double Z, double deltaT) const
+    {
+        return exp(-1.0f * deltaT * _compoundFreq *
+                log(1.0f + Z / _compoundFreq));
+    };
+    inline double dFromDf(double df, double deltaT) const
+    {
+        return -exp(-log(df) / (_compoundFreq * deltaT)) / (deltaT * df);
+    };
+    inline double dToDf(double Z, double deltaT) const
+    {
+        return -deltaT * toDf(Z, deltaT) / (1.0f + Z / _compoundFreq);
+    };
+
+    double _compoundFreq;
+};
+
+// The discount factor itself, no conversion at all
+struct DiscountFactorPolicy
+{
+    static const YieldCurveDefinition::CURVETYPE curveType =
+        YieldCurveDefinition::DISCOUNTFACTOR;
+
+    explicit DiscountFactorPolicy(double){};
+
+    inline double fromDf(double df, double) const {return df;};
+    inline double toDf(double df, double) const {return df;};
+    inline double dFromDf(double, double) const {return 1.0;};
+    inline double dToDf(double, double) const {return 1.0;};
+};
+
+// Continuously compounded zero rate
+struct ContinuousRatePolicy
+{
+    static const YieldCurveDefinition::CURVETYPE curveType =
+        YieldCurveDefinition::CONTINUOUSRATE;
+
+    explicit ContinuousRatePolicy(double){};
+
+    inline double fromDf(double df, double deltaT) const
+        {return -log(df) / deltaT;};
+    inline double toDf(double r, double deltaT) const
+        {return exp(-r * deltaT);};
+    inline double dFromDf(double df, double deltaT) const
+        {return -1.0 / (df * deltaT);};
+    inline double dToDf(double r, double deltaT) const
+        {return -deltaT * exp(-r * deltaT);};
+};
+
+// Log of the discount factor, interpolating it linearly gives
+// piecewise flat forward rates and getDf costs a single exp
+struct LogDiscountFactorPolicy
+{
+    static const YieldCurveDefinition::CURVETYPE curveType =
+        YieldCurveDefinition::LOGDISCOUNTFACTOR;
+
+    explicit LogDiscountFactorPolicy(double){};
+
+    inline double fromDf(double df, double) const {return log(df);};
+    inline double toDf(double logDf, double) const {return exp(logDf);};
+    inline double dFromDf(double df, double) const {return 1.0 / df;};
+    inline double dToDf(double logDf, double) const {return exp(logDf);};
+};
+
+template<class POLICY>
+class PolicyYieldCurve:
     public YieldCurveInstance
 {
     public:
-        friend YieldCurveInstance* YieldCurveDefinition::bindData(
-                InstrumentValues*,
-                YieldCurveDefinition::CURVETYPE);
+        friend class YieldCurveInstance;
+
+        explicit PolicyYieldCurve(const PolicyYieldCurve& rhs):
+            YieldCurveInstance(rhs), _policy(rhs._policy),
+            _compoundFreq(rhs._compoundFreq){};
+        PolicyYieldCurve& operator=(const PolicyYieldCurve& rhs);
+
+        virtual ~PolicyYieldCurve(){};
 
-        explicit ZeroCouponRateCurve(const ZeroCouponRateCurve& rhs);
-        virtual YieldCurveInstance& operator=(YieldCurveInstance& rhs);
-        ZeroCouponRateCurve& operator=(ZeroCouponRateCurve& rhs);
+        virtual YieldCurveDefinition::CURVETYPE curveType() const
+            {return POLICY::curveType;};
+        virtual double compoundFreq() const {return _compoundFreq;};
 
-        virtual ~ZeroCouponRateCurve();
+        // Same as YieldCurveInstance, but the conversion is
+        // resolved at compile time
+        virtual double getDf(Date& date) const;
+        virtual void sweepSorted(const std::vector<Date>& sortedDates,
+                std::vector<double>& values, std::vector<double>& dfs,
+                std::vector<char>& found) const;
 
     private:
-        ZeroCouponRateCurve(double compoundFreq, const Date& startDate);
+        PolicyYieldCurve(double compoundFreq, const Date& startDate):
+            YieldCurveInstance(startDate), _policy(compoundFreq),
+            _compoundFreq(compoundFreq){};
 
-        // Section about Curve Data
-        inline double _dfToZ(double df, double deltaT) const
-        {
-            return _compoundFreq * (
-                    exp(-log(df) / (_compoundFreq * deltaT)) - 1.0f);
-        };
-        inline double _ZTodf(double Z, double deltaT) const
-        {
-            return exp(-1.0f * deltaT * _compoundFreq *
-                    log(1.0f + Z / _compoundFreq));
-        };
+        virtual YieldCurveInstance* _newCurve(const Date& startDate) const
+            {return new PolicyYieldCurve<POLICY>(_compoundFreq, startDate);};
 
         virtual double _convertDfToSpecific(double df, double deltaT) const
-            {return _dfToZ(df, deltaT);};
+            {return _policy.fromDf(df, deltaT);};
 
         virtual double _convertSpecificToDf(double specVal, double deltaT) const 
-            {return _ZTodf(specVal, deltaT);};
+            {return _policy.toDf(specVal, deltaT);};
+
+        virtual double _dDfToSpecific(double df, double deltaT) const
+            {return _policy.dFromDf(df, deltaT);};
 
+        virtual double _dSpecificToDf(double specVal, double deltaT) const
+            {return _policy.dToDf(specVal, deltaT);};
+
+        POLICY _policy;
         double _compoundFreq;
 };
 
+typedef PolicyYieldCurve<ZeroCouponRatePolicy> ZeroCouponRateCurve;
+typedef PolicyYieldCurve<DiscountFactorPolicy> DiscountFactorCurve;
+typedef PolicyYieldCurve<ContinuousRatePolicy> ContinuousRateCurve;
+typedef PolicyYieldCurve<LogDiscountFactorPolicy> LogDiscountFactorCurve;
+
+// A live curve shared with pricing threads: rebuilt curves are
+// published to it and readers pin one without locking. A curve
+// is solved completely before it is published, and must not be
+// modified any more.
+class CurveSnapshotHolder :
+    public Concurrency::SnapshotHolder<YieldCurveInstance>
+{
+    public:
+        explicit CurveSnapshotHolder(YieldCurveInstance *initial = NULL,
+                int maxReaders = 64):
+            Concurrency::SnapshotHolder<YieldCurveInstance>(
+                    _solved(initial), maxReaders){};
+
+        void publish(YieldCurveInstance *curve)
+            {Concurrency::SnapshotHolder<YieldCurveInstance>::publish(
+                    _solved(curve));};
+
+    private:
+        static YieldCurveInstance *_solved(YieldCurveInstance *curve)
+        {
+            if(curve != NULL)
+                curve->solveAll();
+            return curve;
+        };
+};
+
+// The sensitivities of a bootstrapped curve to its quotes
+struct CurveJacobian
+{
+    // The dates of the curve points, in the order of the curve
+    std::vector<Date> pillarDates;
+    // The instrument ids of the quotes, in the order of
+    // InstrumentValues::values
+    std::vector<int> quoteIds;
+    // d(df of pillar i) / d(quote j) at i * quoteIds.size() + j,
+    // the quotes in percent as they are input
+    std::vector<double> dDfdQuote;
+
+    inline double derivative(int pillar, int quote) const
+        {return dDfdQuote[pillar * quoteIds.size() + quote];};
+
+    // Bucketed rho of the df of a date on the curve the
+    // jacobian was produced with: rho[j] = d df / d(quote j)
+    void bucketedRho(const YieldCurveInstance& instYC, Date& date,
+            std::vector<double>& rho) const;
+};
+
+// An instrument of a curve definition with its dates resolved
+// as of a work day: the schedule conventions of the bootstrap,
+// shared by the scenario sets and the fitted curves
+struct ResolvedInstrument
+{
+    // What the instrument is priced as, a FAKE definition is the
+    // CASH, FRA or SWAP of its maturity
+    InstrumentDefinition::TYPE type;
+    Date maturityDate;
+    // From today to the maturity
+    double deltaTToMaturity;
+    // The accrual of the (last) period
+    double accrual;
+    // FRA: the start of the period
+    Date startDate;
+    // SWAP: the coupons before the maturity and their accruals
+    std::vector<Date> couponDates;
+    std::vector<double> couponAccruals;
+};
+
+// Resolve an instrument definition maturing at maturityDate, its
+// pillar date seen from today; the swaps pay compoundFreq coupons
+// a year. instr is overwritten, its vectors keep their capacity.
+void resolveInstrument(const InstrumentDefinition& instrDef,
+        const Date& today, const Date& maturityDate, double compoundFreq,
+        ResolvedInstrument& instr);
+
+// The quotes of the instruments and the dfs they imply, the rates
+// as fractions. The accrual is the one of the (last) period and
+// the annuity of a swap is the sum of accrual x df over its
+// coupons before the maturity.
+namespace InstrumentPricing
+{
+    // The df at the maturity quoted at rate
+    inline double cashDf(double rate, double accrual)
+        {return 1.0 / (1.0 + rate * accrual);}
+    inline double fraDf(double rate, double accrual, double dfStart)
+        {return dfStart / (1.0 + rate * accrual);}
+    inline double swapDf(double rate, double accrual, double annuity)
+        {return (1.0 - rate * annuity) / (1.0 + rate * accrual);}
+
+    // The par rate of the df at the maturity
+    inline double cashRate(double df, double accrual)
+        {return (1.0 / df - 1.0) / accrual;}
+    inline double fraRate(double df, double accrual, double dfStart)
+        {return (dfStart / df - 1.0) / accrual;}
+    inline double swapRate(double df, double accrual, double annuity)
+        {return (1.0 - df) / (annuity + accrual * df);}
+}
+
 // calculate the compound rate of specified Instrument
 // type and the given Date from the yield curve
 double getCompoundRate(YieldCurveInstance&, Date&,
         InstrumentDefinition::TYPE, double);
 
+// The par rates of every instrument type at a strip of
+// maturities, the same rates getCompoundRate returns, in percent.
+// A rate whose dates are out of the range of the curve is NaN,
+// as is the swap rate of a maturity shorter than one coupon.
+struct ParRateStrip
+{
+    std::vector<Date> maturityDates;
+    std::vector<double> cashRates;
+    std::vector<double> fraRates;
+    std::vector<double> swapRates;
+};
+
+// The strip of work dates sorted in ascending order, in one pass:
+// the swaps share one coupon schedule out to the longest maturity
+// and a running annuity, and the dfs are swept off the curve
+// instead of searched for date by date
+void getParRateStrip(const YieldCurveInstance& instYC,
+        const std::vector<Date>& maturityDates, double compoundFreq,
+        ParRateStrip& strip);
+// The strip of every period up to maxMaturity
+void getParRateStrip(const YieldCurveInstance& instYC,
+        const Duration& maxMaturity, const Duration& period,
+        double compoundFreq, ParRateStrip& strip);
+// The strips of the same tenors on several curves, seen from
+// the start date of each, using numThreads threads
+void getParRateStrips(const std::vector<YieldCurveInstance *>& curves,
+        const std::vector<Duration>& tenors, double compoundFreq,
+        int numThreads, std::vector<ParRateStrip>& strips);
+
 class YieldCurveException:
     public std::runtime_error
 {
@@ -153,4 +601,41 @@ class YieldCurveException:
             std::runtime_error(message){};
 };
 
+template<class POLICY>
+PolicyYieldCurve<POLICY>& PolicyYieldCurve<POLICY>::operator=(
+        const PolicyYieldCurve<POLICY>& rhs)
+{
+    YieldCurveInstance::operator=(rhs);
+    _policy = rhs._policy;
+    _compoundFreq = rhs._compoundFreq;
+
+    return *this;
+}
+
+template<class POLICY>
+double PolicyYieldCurve<POLICY>::getDf(Date& date) const
+{
+    double value = this->operator[](date);
+
+    Date workDate = WorkDate(date);
+    double deltaT = normDiffDate(_startDate, workDate, Date::ACT365);
+
+    return _policy.toDf(value, deltaT);
+}
+
+template<class POLICY>
+void PolicyYieldCurve<POLICY>::sweepSorted(
+        const std::vector<Date>& sortedDates, std::vector<double>& values,
+        std::vector<double>& dfs, std::vector<char>& found) const
+{
+    std::vector<double> deltaTs;
+    _sweepValues(sortedDates, values, deltaTs, found);
+
+    int numDates = (int)sortedDates.size();
+    dfs.resize(numDates);
+    for(int i = 0; i < numDates; i ++)
+        if(found[i])
+            dfs[i] = _policy.toDf(values[i], deltaTs[i]);
+}
+
 #endif //_INCLUDE_YIELDCURVE_H_
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "Instrument.h"
+#include "YieldCurve.h"
+#include "CurveStore.h"
+#include "Calendar.h"
+
+void
+printUsage()
+{
+    std::cout << "Usage: " << std::endl;
+    std::cout << "\t./curveStoreManager [-H <holiday csv filename>] " <<
+        "[-d <as-of date, today by default>] [-r] <store name> " <<
+        "[<curve name> <input curve definition csv filename> " <<
+        "<input curve data csv filename>] ..." << std::endl;
+    std::cout << "\tBuild the zero coupon rate curves and publish them " <<
+        "to the shared memory curve store, -r removes the store" << std::endl;
+}
+
+YieldCurveInstance *
+buildCurve(const std::string& defFilename, const std::string& dataFilename,
+        const Date& asOf)
+{
+    std::ifstream finCVDef(defFilename.c_str());
+    std::string line;
+    std::vector<InstrumentDefinition> instrDefs;
+
+    getline(finCVDef, line);
+    while(finCVDef.good())
+    {
+        getline(finCVDef, line);
+        if(!finCVDef.good())
+            break;
+
+        instrDefs.push_back(InstrumentDefinition::parseString(line));
+    }
+    finCVDef.close();
+
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    InstrumentValues values;
+    std::ifstream finCVData(dataFilename.c_str());
+    getline(finCVData, line);
+    while(finCVData.good())
+    {
+        char comma;
+        int id;
+        double rate;
+
+        finCVData >> id >> comma >> rate;
+        values.values.push_back(std::pair<int, double>(id, rate));
+    }
+    finCVData.close();
+
+    return ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE, asOf);
+}
+
+int
+main(int argc, char * argv[])
+{
+    std::string holidayFilename;
+    std::string asOfString;
+    bool removeStore = false;
+    int opt;
+    while((opt = getopt(argc, argv, "H:d:r")) != -1)
+    {
+        switch(opt)
+        {
+            case 'H':
+                holidayFilename = optarg;
+                break;
+            case 'd':
+                asOfString = optarg;
+                break;
+            case 'r':
+                removeStore = true;
+                break;
+            default:
+                printUsage();
+                exit(1);
+        }
+    }
+
+    if(argc - optind < 1 || (argc - optind - 1) % 3 != 0 ||
+            (!removeStore && argc - optind == 1))
+    {
+        printUsage();
+        exit(1);
+    }
+
+    std::string storeName(argv[optind]);
+
+    try
+    {
+        if(removeStore)
+        {
+            std::cout << "Removing the curve store " << storeName << " ..." << std::endl;
+            CurveStoreWriter::remove(storeName);
+            if(argc - optind == 1)
+                return 0;
+        }
+
+        if(!holidayFilename.empty())
+            Calendar::setWorkCalendar(Calendar::fromCSV(holidayFilename, "HOLIDAYS"));
+        Date asOf = WorkDate(asOfString.empty() ? Date::today() : Date(asOfString));
+
+        CurveStoreWriter writer(storeName);
+        for(int i = optind + 1; i < argc; i += 3)
+        {
+            std::string curveName(argv[i]);
+            std::cout << "Building the curve " << curveName << " ..." << std::endl;
+            YieldCurveInstance *yci = buildCurve(argv[i + 1], argv[i + 2], asOf);
+            writer.add(curveName, *yci);
+            delete yci;
+        }
+
+        std::cout << "Publishing to the curve store " << storeName << " ..." << std::endl;
+        std::cout << "Published version " << writer.publish() << std::endl;
+
+        std::cout << "Program finished successfully." << std::endl;
+    }
+    catch(std::fstream::failure& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(InstrumentException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(YieldCurveException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(CurveStoreException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(CalendarException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    // A bad as-of date
+    catch(std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,146 +2,343 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstdlib>
+#include <memory>
 
-#include <boost/tuple/tuple.hpp>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include "Instrument.h"
 #include "YieldCurve.h"
+#include "CurveQuery.h"
+#include "CurveStore.h"
+#include "Concurrency.h"
+#include "OutputWriter.h"
+#include "ColumnarFile.h"
+#include "Calendar.h"
+#include "Profiler.h"
+#include "Trace.h"
 
 void 
 printUsage()
 {
     std::cout << "Usage: " << std::endl;
-    std::cout << "\t./generateYieldCurve <input curve definition csv filename> " <<
-        "<input curve data csv filename> <input query csv file> <output csv filename>" << std::endl;
+    std::cout << "\t./generateYieldCurve [-j <number of query threads, 0 for all cores>] " <<
+        "[-b <binary columnar output filename>] " <<
+        "[-H <holiday csv filename>] [-d <as-of date, today by default>] " <<
+        "[-x <extrapolation of the queries out of the curve: none (dropped, by default), " <<
+        "flatzero, flatforward or clamp>] " <<
+        "[-p <profile report filename, .csv or JSON, also written on SIGUSR1>] " <<
+        "[-e (count the hardware events of the stages in the profile report)] " <<
+        "[-t <Chrome trace event JSON filename>] " <<
+        "[-m (count the allocations and the peak memory of the stages in the profile report)] " <<
+        "[-a <curve store name>/<curve name> (take the curve from the curve store " <<
+        "instead of the csv files)] " <<
+        "[<input curve definition csv filename> <input curve data csv filename>] " <<
+        "<input query csv file, - for stdin> <output csv filename>" << std::endl;
 }
 
+// Write the query results to the csv output file and,
+// if requested, to the binary columnar file
+class QueryResultWriter : public CurveQuerySink
+{
+    public:
+        QueryResultWriter(BufferedWriter& fout, Columnar::ColumnarWriter *binOut):
+            _fout(fout), _binOut(binOut){};
+
+        virtual void consume(const std::vector<CurveQueryResult>& results)
+        {
+            PROFILE_TIMER(writeTimer, "writeResults");
+            TRACE_SCOPE("writeResults");
+            writeTimer.addItems(results.size());
+            for(int i = 0; i < (int)results.size(); i ++)
+            {
+                _fout.put('"').writeDate(results[i].get<0>()).write("\",\"", 3);
+                _fout.writeFixed(results[i].get<1>(), 4).write("\",\"", 3);
+                _fout.writeFixed(results[i].get<2>(), 4).write("\"\n", 2);
+
+                if(_binOut != NULL)
+                {
+                    _binOut->setDate(0, results[i].get<0>());
+                    _binOut->setFloat64(1, results[i].get<1>());
+                    _binOut->setFloat64(2, results[i].get<2>());
+                    _binOut->endRow();
+                }
+            }
+        }
+
+    private:
+        BufferedWriter& _fout;
+        Columnar::ColumnarWriter *_binOut;
+};
+
 int 
 main(int argc, char * argv[])
 {
-    if(argc != 5)
+    int numThreads = 1;
+    std::string outBinaryFilename;
+    std::string holidayFilename;
+    std::string asOfString;
+    std::string profileFilename;
+    bool hardwareCounters = false;
+    std::string traceFilename;
+    bool trackAllocations = false;
+    std::string storeCurve;
+    YieldCurveInstance::EXTRAPOLATION extrapolation =
+        YieldCurveInstance::NOEXTRAPOLATION;
+    int opt;
+    while((opt = getopt(argc, argv, "j:b:H:d:x:p:et:ma:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'j':
+                numThreads = atoi(optarg);
+                if(numThreads <= 0)
+                    numThreads = Concurrency::hardwareConcurrency();
+                break;
+            case 'b':
+                outBinaryFilename = optarg;
+                break;
+            case 'H':
+                holidayFilename = optarg;
+                break;
+            case 'd':
+                asOfString = optarg;
+                break;
+            case 'x':
+                if(std::string(optarg) == "none")
+                    extrapolation = YieldCurveInstance::NOEXTRAPOLATION;
+                else if(std::string(optarg) == "flatzero")
+                    extrapolation = YieldCurveInstance::FLATZERO;
+                else if(std::string(optarg) == "flatforward")
+                    extrapolation = YieldCurveInstance::FLATFORWARD;
+                else if(std::string(optarg) == "clamp")
+                    extrapolation = YieldCurveInstance::CLAMP;
+                else
+                {
+                    printUsage();
+                    exit(0);
+                }
+                break;
+            case 'p':
+                profileFilename = optarg;
+                break;
+            case 'e':
+                hardwareCounters = true;
+                break;
+            case 't':
+                traceFilename = optarg;
+                break;
+            case 'm':
+                trackAllocations = true;
+                break;
+            case 'a':
+                storeCurve = optarg;
+                break;
+            default:
+                printUsage();
+                exit(0);
+        }
+    }
+
+    // The curve store names cannot contain a slash
+    size_t slash = storeCurve.find('/');
+    if(argc - optind != (storeCurve.empty() ? 4 : 2) ||
+            (!storeCurve.empty() && slash == std::string::npos))
     {
         printUsage();
         exit(0);
     }
 
-    std::string inCVDefFilename(argv[1]); 
-    std::string inCVDataFilename(argv[2]);
-    std::string inQueryFilename(argv[3]);
-    std::string outFilename(argv[4]);
+    // A bad as-of date is a usage error, found before anything is read
+    Date asOfDate = Date::today();
+    if(!asOfString.empty())
+    {
+        try
+        {
+            asOfDate = Date(asOfString);
+        }
+        catch(std::exception& e)
+        {
+            std::cerr << "Invalid as-of date " << asOfString << " (" <<
+                e.what() << ")" << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::string inCVDefFilename;
+    std::string inCVDataFilename;
+    if(storeCurve.empty())
+    {
+        inCVDefFilename = argv[optind];
+        inCVDataFilename = argv[optind + 1];
+    }
+    std::string inQueryFilename(argv[argc - 2]);
+    std::string outFilename(argv[argc - 1]);
+
+    if(!profileFilename.empty())
+        Profiler::dumpOnExit(profileFilename);
+    std::string counterError;
+    if(hardwareCounters && !Profiler::enableHardwareCounters(counterError))
+        std::cerr << "Hardware counters are not available (" << counterError <<
+            "), only the times are profiled" << std::endl;
+    else if(hardwareCounters && !counterError.empty())
+        std::cerr << "Some hardware events are not counted (" << counterError <<
+            ")" << std::endl;
+    if(!traceFilename.empty())
+    {
+        Trace::enable();
+        Trace::writeOnExit(traceFilename);
+    }
+    if(trackAllocations && !AllocationTracker::enable())
+        std::cerr << "Allocation tracking is compiled out" << std::endl;
 
     try
     {
-        std::cout << "Parsing Yield Curve Definitions ..." << std::endl;
-        std::ifstream finCVDef(inCVDefFilename.c_str());
-        std::string line;
-        std::vector<InstrumentDefinition *> instrDefs;
+        // Work dates skip the holidays as well as the weekends
+        if(!holidayFilename.empty())
+            Calendar::setWorkCalendar(Calendar::fromCSV(holidayFilename, "HOLIDAYS"));
+        // The curve is built as of the work day of the as-of date
+        Date asOf = WorkDate(asOfDate);
 
-        getline(finCVDef, line);
-        while(finCVDef.good())
+        // The curve is either bound here and owned, or read from
+        // the curve store; both are freed however the run ends
+        std::auto_ptr<CurveStoreReader> store;
+        std::auto_ptr<YieldCurveInstance> boundCurve;
+        const YieldCurveInstance *yci;
+        std::vector<Date> pillarDates;
+        if(storeCurve.empty())
         {
+            std::cout << "Parsing Yield Curve Definitions ..." << std::endl;
+            PROFILE_TIMER(parseTimer, "parseDefinitions");
+            std::ifstream finCVDef(inCVDefFilename.c_str());
+            std::string line;
+            std::vector<InstrumentDefinition> instrDefs;
+
             getline(finCVDef, line);
-            if(!finCVDef.good())
-                break;
+            while(finCVDef.good())
+            {
+                getline(finCVDef, line);
+                if(!finCVDef.good())
+                    break;
 
-            InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
-            instrDefs.push_back(instrDef);
-        }
-        finCVDef.close();
+                instrDefs.push_back(InstrumentDefinition::parseString(line));
+            }
+            finCVDef.close();
 
-        YieldCurveDefinition ycDef(instrDefs, 4.0);
-        std::vector<InstrumentDefinition *> generatedInstrDefs = ycDef.getAllDefinitions();
-        std::vector<InstrumentDefinition *>& gdefs = generatedInstrDefs;
+            YieldCurveDefinition ycDef(instrDefs, 4.0);
+            parseTimer.addItems(instrDefs.size());
+            parseTimer.stop();
 
-        std::cout << "Binding Yield Curve Data to the definition ..." << std::endl;
-        InstrumentValues values;
-        std::ifstream finCVData(inCVDataFilename.c_str());
-        getline(finCVData, line);
-        while(finCVData.good())
-        {
-            char comma;
-            int id;
-            double rate;
+            std::cout << "Binding Yield Curve Data to the definition ..." << std::endl;
+            PROFILE_TIMER(readTimer, "readCurveData");
+            InstrumentValues values;
+            std::ifstream finCVData(inCVDataFilename.c_str());
+            getline(finCVData, line);
+            while(finCVData.good())
+            {
+                char comma;
+                int id;
+                double rate;
+
+                finCVData >> id >> comma >> rate;
+                values.values.push_back(std::pair<int, double>(id, rate));
+            }
+            finCVData.close();
+            readTimer.stop();
 
-            finCVData >> id >> comma >> rate;
-            values.values.push_back(std::pair<int, double>(id, rate));
+            PROFILE_TIMER(bindTimer, "bindData");
+            {
+                TRACE_SCOPE("bindData");
+                boundCurve.reset(ycDef.bindData(&values,
+                            YieldCurveDefinition::ZEROCOUPONRATE, asOf));
+            }
+            bindTimer.addItems(values.values.size());
+            bindTimer.stop();
+            yci = boundCurve.get();
+            pillarDates = ycDef.getPillarDates(WorkDate(yci->startDate())).get();
+        }
+        else
+        {
+            std::string storeName = storeCurve.substr(0, slash);
+            std::string curveName = storeCurve.substr(slash + 1);
+            std::cout << "Attaching to the curve " << curveName <<
+                " of the curve store " << storeName << " ..." << std::endl;
+            PROFILE_TIMER(attachTimer, "attachCurveStore");
+            TRACE_SCOPE("attachCurveStore");
+            store.reset(new CurveStoreReader(storeName));
+            yci = store->find(curveName);
+            if(yci == NULL)
+                throw CurveStoreException("No curve " + curveName +
+                        " in the curve store " + storeName);
+            yci->getPointDates(pillarDates);
         }
-        finCVData.close();
-        YieldCurveInstance *yci = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE);
 
         std::cout << "Dumping the curve data to the output file " << outFilename << " ..." << std::endl;
-        std::vector<boost::tuple<Date, double, double> > queryResults;
-        Date startDate = WorkDate(yci->startDate());
+        BufferedWriter fout(outFilename);
+        fout.write("\"Date\",\"Discount Factor\",\"Zero Coupon Rate\"\n");
+
+        std::auto_ptr<Columnar::ColumnarWriter> binOut;
+        if(!outBinaryFilename.empty())
+        {
+            Columnar::Schema schema;
+            schema.push_back(std::make_pair(std::string("Date"), Columnar::DATE32));
+            schema.push_back(std::make_pair(std::string("Discount Factor"), Columnar::FLOAT64));
+            schema.push_back(std::make_pair(std::string("Zero Coupon Rate"), Columnar::FLOAT64));
+            binOut.reset(new Columnar::ColumnarWriter(outBinaryFilename, schema));
+        }
 
-        for(int i = 0; i < (int)gdefs.size(); i ++)
+        QueryResultWriter resultWriter(fout, binOut.get());
+        PROFILE_TIMER(pillarTimer, "pillarRates");
+        std::vector<CurveQueryResult> curveResults;
+        for(int i = 0; i < (int)pillarDates.size(); i ++)
         {
-            Date maturityDate = WorkDate(startDate + gdefs[i]->maturity());
+            Date maturityDate = pillarDates[i];
             double df = yci->getDf(maturityDate);
             double rate = (*yci)[maturityDate];
 
-            queryResults.push_back(boost::tuple<Date, double, double>(maturityDate, df, rate));
+            curveResults.push_back(CurveQueryResult(maturityDate, df, rate));
 
         }
+        PROFILE_COUNT("curveLookups", 2 * pillarDates.size());
+        pillarTimer.addItems(2 * pillarDates.size());
+        pillarTimer.stop();
+        resultWriter.consume(curveResults);
 
         std::cout << "Querying the zero coupon rate ..." << std::endl;
-        std::ifstream finQuery(inQueryFilename.c_str());
-        getline(finQuery, line);
-        while(finQuery.good())
-        {
-            std::string dateStr;
-            finQuery >> dateStr;
-            if(!finQuery.good())
-                break;
+        int queryFd = STDIN_FILENO;
+        if(inQueryFilename != "-")
+            queryFd = open(inQueryFilename.c_str(), O_RDONLY);
 
+        // The queries are read, resolved and written in a
+        // pipeline, so the input can be of any size. As before,
+        // a missing query file only leaves out the query rows.
+        if(queryFd >= 0)
+        {
+            PROFILE_SCOPE("queries");
+            TRACE_SCOPE("queries");
+            StreamingCurveQuery query(*yci, numThreads,
+                    StreamingCurveQuery::defaultBatchBytes, extrapolation);
             try
             {
-                Date dateUnModified(dateStr);
-                Date date = WorkDate(dateUnModified);
-                double df = yci->getDf(date);
-                double rate = (*yci)[date];
-                queryResults.push_back(boost::tuple<Date, double, double>(date, df, rate));
+                query.run(queryFd, true, resultWriter);
             }
-            catch(DateException& e)
+            catch(...)
             {
+                if(queryFd != STDIN_FILENO)
+                    close(queryFd);
+                throw;
             }
-            catch(YieldCurveException& e)
-            {
-            }
-
-        }
-        finQuery.close();
-
-        
-
-        std::cout << "Writing the query result to the output file " << outFilename << " ..." << std::endl; 
-        std::ofstream fout(outFilename.c_str());
-        fout << "\"Date\",\"Discount Factor\",\"Zero Coupon Rate\"" << std::endl;
-        for(int i = 0; i < (int)queryResults.size(); i ++)
-        {
-            Date& date = (Date&)queryResults[i].get<0>();
-            fout << "\"" << date.toString() << "\",\"";
-            
-            fout.setf(std::ios::fixed);
-            fout << std::setprecision(4) << queryResults[i].get<1>() << "\",\"" 
-                << queryResults[i].get<2>() << "\"" << std::endl;
-            fout.unsetf(std::ios::fixed);
-        }
-        fout.close();
-
-        delete yci;
-
-        while(!gdefs.empty())
-        {
-            InstrumentDefinition * ptrInstrDef = gdefs.back();
-            gdefs.pop_back();
-            delete ptrInstrDef;
+            if(queryFd != STDIN_FILENO)
+                close(queryFd);
         }
 
-        while(!instrDefs.empty())
+        fout.flush();
+        if(binOut.get() != NULL)
         {
-            InstrumentDefinition * ptrInstrDef = instrDefs.back();
-            instrDefs.pop_back();
-            delete ptrInstrDef;
+            std::cout << "Closing the binary output file " << outBinaryFilename << " ..." << std::endl;
+            binOut->close();
         }
 
         std::cout << "Program finished successfully." << std::endl;
@@ -155,6 +352,26 @@ main(int argc, char * argv[])
     catch(YieldCurveException& e)
     {
     }
+    catch(OutputException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(Columnar::ColumnarFileException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(CalendarException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    catch(CurveStoreException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
 }
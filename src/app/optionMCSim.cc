@@ -3,16 +3,22 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include <cstring>
 
-#include <sys/times.h>
-#include <sys/resource.h>
-#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "Instrument.h"
 #include "YieldCurve.h"
+#include "CurveStore.h"
 #include "Utility.h"
 #include "Stock.h"
+#include "OutputWriter.h"
+#include "ColumnarFile.h"
+#include "Calendar.h"
+#include "Concurrency.h"
+#include "Profiler.h"
+#include "Trace.h"
 
 using namespace Stock::PricePredictionModel;
 using namespace RandomNumberGenerator;
@@ -21,8 +27,19 @@ void
 printUsage()
 {
     std::cout << "Usage: " << std::endl;
-    std::cout << "\t./optionMCSim <input curve definition csv filename> " <<
-        "<input curve data csv filename> <input option description csv file>" << std::endl;
+    std::cout << "\t./optionMCSim [-j <number of threads, 0 for all cores>] " <<
+        "[-b <binary columnar output filename>] " <<
+        "[-H <holiday csv filename>] " <<
+        "[-d <as-of date, today by default>] " <<
+        "[-p <profile report filename, .csv or JSON, also written on SIGUSR1>] " <<
+        "[-e (count the hardware events of the stages in the profile report)] " <<
+        "[-t <Chrome trace event JSON filename>] " <<
+        "[-m (count the allocations and the peak memory of the stages in the profile report)] " <<
+        "[-s <random seed, the time by default>] " <<
+        "[-a <curve store name>/<curve name> (take the curve from the curve store, " <<
+        "as of its own date by default, instead of the csv files)] " <<
+        "[<input curve definition csv filename> <input curve data csv filename>] " <<
+        "<input option description csv file>" << std::endl;
 }
 
 double payOutFuncBenchmark(std::vector<std::pair<Date, double> >& prices, double strike)
@@ -69,291 +86,788 @@ double payOutFunc2(std::vector<std::pair<Date, double> >& prices)
         return 0;
 }
 
-int 
-main(int argc, char * argv[])
+// Print the result of one Monte-Carlo pricing run, the whole
+// report goes to the kernel in one write
+void writeOptionReport(BufferedWriter& writer, const char *rngName,
+        int optIndex, uint64_t rounds, uint64_t steps,
+        double currTradePrice, double strike, Date& expireDate,
+        double expireTradePrice, std::vector<std::pair<Date, double> >& prices,
+        double dfAtExpire, double avgPayoutBenchmark, double avgPayout1,
+        double avgPayout2)
 {
-    if(argc != 4)
+    writer.write("Using ").write(rngName, strlen(rngName))
+        .write(" Random Number Generator\n");
+    writer.write("Option ").writeInt(optIndex).put('\n');
+    writer.write("Rounds: ").writeInt(rounds).put('\n');
+    writer.write("Steps: ").writeInt(steps).put('\n');
+    writer.write("Current Trading Price: ").writeGeneral(currTradePrice, 4).put('\n');
+    writer.write("Strike: ").writeGeneral(strike, 4).put('\n');
+    writer.write("Expire Date: ").writeDate(expireDate).put('\n');
+    writer.write("Expire Trading price: ").writeGeneral(expireTradePrice, 4).put('\n');
+    writer.write("One Group of Price Predictions:\n");
+    for(int i = 0; i < (int)prices.size(); i ++)
     {
-        printUsage();
-        exit(0);
+        writer.put('\t').writeDate(prices[i].first).put('\t')
+            .writeFixed(prices[i].second, 4).put('\n');
     }
 
-    srand((unsigned int)time(NULL));
+    writer.write("Discount factor at expiration: ").writeFixed(dfAtExpire, 4).put('\n');
+    writer.write("Average pay out of Benchmark Option: ")
+        .writeFixed(avgPayoutBenchmark, 4).put('\n');
+    writer.write("Average pay out according to Method 1 (Option A): ")
+        .writeFixed(avgPayout1, 4).put('\n');
+    writer.write("Average pay out according to Method 2 (Option B): ")
+        .writeFixed(avgPayout2, 4).put('\n');
+    writer.put('\n');
+    writer.flush();
+}
 
-    std::string inCVDefFilename(argv[1]); 
-    std::string inCVDataFilename(argv[2]);
-    std::string inOptionDescFilename(argv[3]);
+// Columns of the binary columnar output, one row per option
+// and kind of random number generator
+Columnar::Schema optionResultSchema()
+{
+    Columnar::Schema schema;
+    schema.push_back(std::make_pair(std::string("Option"), Columnar::INT32));
+    schema.push_back(std::make_pair(std::string("Antithetic"), Columnar::INT32));
+    schema.push_back(std::make_pair(std::string("Rounds"), Columnar::INT64));
+    schema.push_back(std::make_pair(std::string("Steps"), Columnar::INT64));
+    schema.push_back(std::make_pair(std::string("Current Trading Price"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Strike"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Expire Date"), Columnar::DATE32));
+    schema.push_back(std::make_pair(std::string("Expire Trading Price"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Volatility"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Discount Factor"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Benchmark Payout"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Option A Payout"), Columnar::FLOAT64));
+    schema.push_back(std::make_pair(std::string("Option B Payout"), Columnar::FLOAT64));
+
+    return schema;
+}
 
-    // Variables for measuring the cpu time cost
-    struct rusage usage;
-    unsigned long t1, t2;
+void appendOptionResult(Columnar::ColumnarWriter& binOut, int optIndex,
+        bool antithetic, uint64_t rounds, uint64_t steps,
+        double currTradePrice, double strike, Date& expireDate,
+        double expireTradePrice, double volatility, double dfAtExpire,
+        double avgPayoutBenchmark, double avgPayout1, double avgPayout2)
+{
+    binOut.setInt32(0, optIndex);
+    binOut.setInt32(1, antithetic ? 1 : 0);
+    binOut.setInt64(2, rounds);
+    binOut.setInt64(3, steps);
+    binOut.setFloat64(4, currTradePrice);
+    binOut.setFloat64(5, strike);
+    binOut.setDate(6, expireDate);
+    binOut.setFloat64(7, expireTradePrice);
+    binOut.setFloat64(8, volatility);
+    binOut.setFloat64(9, dfAtExpire);
+    binOut.setFloat64(10, avgPayoutBenchmark);
+    binOut.setFloat64(11, avgPayout1);
+    binOut.setFloat64(12, avgPayout2);
+    binOut.endRow();
+}
 
-    try
-    {
-        std::cout << "Parsing Yield Curve Definitions ...";
-        getrusage(RUSAGE_SELF, &usage);
-        t1 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-            (unsigned long long)usage.ru_utime.tv_usec;
-        t1 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-            (unsigned long long)usage.ru_stime.tv_usec;
-        
-        std::ifstream finCVDef(inCVDefFilename.c_str());
-        std::string line;
-        std::vector<InstrumentDefinition *> instrDefs;
-
-        getline(finCVDef, line);
-        while(finCVDef.good())
+// Mix the run seed with the position of a chunk, so that the
+// chunks draw different sequences and a run can be repeated
+unsigned int chunkSeed(unsigned int runSeed, int optIndex, int kind,
+        uint64_t chunk)
+{
+    const unsigned int multiplier = 2654435761u;
+    unsigned int seed = runSeed;
+    seed = seed * multiplier + (unsigned int)optIndex;
+    seed = seed * multiplier + (unsigned int)kind;
+    seed = seed * multiplier + (unsigned int)chunk;
+    return seed;
+}
+
+//////////////////////////////////////////
+// The work of the program is a task graph: the curve is built
+// while the option rows are read, the volatility of an option
+// is solved as soon as both its row and the curve are ready,
+// the simulations of an option run in parallel chunks while
+// the next options are solved, and a chain of writer tasks
+// prints the results in the order of the input.
+//////////////////////////////////////////
+
+// State shared by all the tasks of the graph
+struct SimulationContext
+{
+    std::string inCVDefFilename;
+    std::string inCVDataFilename;
+    std::string inOptionDescFilename;
+    // The curve store the curve is taken from, NULL if it is
+    // built from the csv files
+    CurveStoreReader *store;
+    int numThreads;
+    // Every chunk of simulations draws from its own sequence,
+    // derived from this seed
+    unsigned int seed;
+
+    Concurrency::TaskGraph graph;
+    Concurrency::TaskGraph::TaskId bindTask;
+    Concurrency::TaskGraph::TaskId curveReportTask;
+
+    std::vector<InstrumentDefinition> instrDefs;
+    YieldCurveDefinition *ycDef;
+    InstrumentValues values;
+    const YieldCurveInstance *yci;
+    Date today;
+    // Wall-clock times of the curve stages in microseconds, read
+    // from the clock also when the profiling is compiled out
+    unsigned long long parseTime, bindTime, attachTime;
+
+    BufferedWriter *writer;
+    Columnar::ColumnarWriter *binOut;
+    // Set by the writer chain at the first option that fails,
+    // nothing is printed after it
+    volatile bool stopped;
+};
+
+class ParseDefinitionTask : public Concurrency::Runnable
+{
+    public:
+        ParseDefinitionTask(SimulationContext& context):_context(context){};
+
+        virtual void run()
         {
+            uint64_t start = Profiler::now();
+            PROFILE_TIMER(parseTimer, "parseDefinitions");
+            TRACE_SCOPE("parseDefinitions");
+            std::ifstream finCVDef(_context.inCVDefFilename.c_str());
+            std::string line;
+
             getline(finCVDef, line);
-            if(!finCVDef.good())
-                break;
+            while(finCVDef.good())
+            {
+                getline(finCVDef, line);
+                if(!finCVDef.good())
+                    break;
+
+                _context.instrDefs.push_back(InstrumentDefinition::parseString(line));
+            }
+            finCVDef.close();
 
-            InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
-            instrDefs.push_back(instrDef);
+            _context.ycDef = new YieldCurveDefinition(_context.instrDefs, 4.0);
+            parseTimer.addItems(_context.instrDefs.size());
+            _context.parseTime = (Profiler::now() - start) / 1000;
         }
-        finCVDef.close();
-
-        YieldCurveDefinition ycDef(instrDefs, 4.0);
-
-        getrusage(RUSAGE_SELF, &usage);
-        t2 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-            (unsigned long long)usage.ru_utime.tv_usec;
-        t2 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-            (unsigned long long)usage.ru_stime.tv_usec;
-        std::cout << " Time used " << t2 - t1 << "us" << std::endl;
-
-        std::cout << "Binding Yield Curve Data to the definition ...";
-        getrusage(RUSAGE_SELF, &usage);
-        t1 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-            (unsigned long long)usage.ru_utime.tv_usec;
-        t1 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-            (unsigned long long)usage.ru_stime.tv_usec;
-        InstrumentValues values;
-        std::ifstream finCVData(inCVDataFilename.c_str());
-        getline(finCVData, line);
-        while(finCVData.good())
+
+    private:
+        SimulationContext& _context;
+};
+
+class ReadCurveDataTask : public Concurrency::Runnable
+{
+    public:
+        ReadCurveDataTask(SimulationContext& context):_context(context){};
+
+        virtual void run()
         {
-            char comma;
-            int id;
-            double rate;
+            uint64_t start = Profiler::now();
+            PROFILE_SCOPE("readCurveData");
+            TRACE_SCOPE("readCurveData");
+            std::ifstream finCVData(_context.inCVDataFilename.c_str());
+            std::string line;
+            getline(finCVData, line);
+            while(finCVData.good())
+            {
+                char comma;
+                int id;
+                double rate;
 
-            finCVData >> id >> comma >> rate;
-            values.values.push_back(std::pair<int, double>(id, rate));
+                finCVData >> id >> comma >> rate;
+                _context.values.values.push_back(std::pair<int, double>(id, rate));
+            }
+            finCVData.close();
+            _context.bindTime = (Profiler::now() - start) / 1000;
         }
-        finCVData.close();
-        YieldCurveInstance *yci = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE);
-
-        getrusage(RUSAGE_SELF, &usage);
-        t2 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-            (unsigned long long)usage.ru_utime.tv_usec;
-        t2 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-            (unsigned long long)usage.ru_stime.tv_usec;
-        std::cout << " Time used " << t2 - t1 << "us" << std::endl;
-
-        std::cout << "Reading and processing options ..." << std::endl;
-        Date today = WorkDate(Date::today());
-        std::ifstream finOptionDesc(inOptionDescFilename.c_str());
-        getline(finOptionDesc, line);
-        while(finOptionDesc.good())
+
+    private:
+        SimulationContext& _context;
+};
+
+class BindCurveTask : public Concurrency::Runnable
+{
+    public:
+        BindCurveTask(SimulationContext& context):_context(context){};
+
+        virtual void run()
         {
-            double strike, expireTradePrice, currTradePrice;
-            uint64_t rounds, steps;
-            int optIndex;
-            std::string expireDateStr;
-            char comma;
+            uint64_t start = Profiler::now();
+            PROFILE_TIMER(bindTimer, "bindData");
+            TRACE_SCOPE("bindData");
+            YieldCurveInstance *yci = _context.ycDef->bindData(&_context.values,
+                    YieldCurveDefinition::ZEROCOUPONRATE, _context.today);
+            // The simulations read the curve from all the threads
+            yci->solveAll();
+            _context.yci = yci;
+            bindTimer.addItems(_context.values.values.size());
+            _context.bindTime += (Profiler::now() - start) / 1000;
+        }
 
-            finOptionDesc >> optIndex >> comma >> steps >> comma >> rounds >>
-                comma >> currTradePrice >> comma >> strike >> comma >>
-                expireTradePrice >> comma >> expireDateStr;
+    private:
+        SimulationContext& _context;
+};
 
-            if(!finOptionDesc.good())
-                break;
+class CurveReportTask : public Concurrency::Runnable
+{
+    public:
+        CurveReportTask(SimulationContext& context):_context(context){};
 
+        virtual void run()
+        {
+            if(_context.store != NULL)
+            {
+                std::cout << "Attaching to the curve store ... Time used " <<
+                    _context.attachTime << "us" << std::endl;
+            }
+            else
+            {
+                std::cout << "Parsing Yield Curve Definitions ... Time used " <<
+                    _context.parseTime << "us" << std::endl;
+                std::cout << "Binding Yield Curve Data to the definition ... Time used " <<
+                    _context.bindTime << "us" << std::endl;
+            }
+            std::cout << "Reading and processing options ..." << std::endl;
+        }
 
-            // Calculate Volatility
-            std::cout << "Calculating volatility ...";
-            getrusage(RUSAGE_SELF, &usage);
-            t1 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-                (unsigned long long)usage.ru_utime.tv_usec;
-            t1 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-                (unsigned long long)usage.ru_stime.tv_usec;
-
-            Date expireDateUnModified(expireDateStr);
-            Date expireDate = WorkDate(expireDateUnModified);
-
-            double deltaT = normDiffDate(today, expireDate, Date::ACT365); 
-            double dfAtExpire = yci->getDf(expireDate);
-            double crfRate = - log(dfAtExpire) / deltaT; // continuous time risk free rate
-
-            Volatility::FormulaClass *formula = new Volatility::VolatilityFromEuroCallPriceFormula(
-                    currTradePrice, strike, deltaT, crfRate, expireTradePrice); 
-            double volatility = Volatility::NewtonRaphsonMethod()(*formula, 1e-9);
-
-            delete formula;
-            getrusage(RUSAGE_SELF, &usage);
-            t2 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-                (unsigned long long)usage.ru_utime.tv_usec;
-            t2 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-                (unsigned long long)usage.ru_stime.tv_usec;
-            std::cout << " Time used " << t2 - t1 << "us" << std::endl;
-            std::cout << "Volatility: " << std::setprecision(4) << 
-                volatility << std::endl;
-
-            
-            // Forecast the price using Monte-Carlo Method
-            // Antithetice method
-            std::cout << "Pricing the option using Monte-Carlo Simulation ...";
-            getrusage(RUSAGE_SELF, &usage);
-            t1 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-                (unsigned long long)usage.ru_utime.tv_usec;
-            t1 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-                (unsigned long long)usage.ru_stime.tv_usec;
-            Duration duration = expireDate - today;
-            double sumPayout1 = 0;
-            double sumPayout2 = 0;
-            double sumPayout3 = 0;
+    private:
+        SimulationContext& _context;
+};
+
+// Partial sums of one chunk of the Monte-Carlo rounds
+struct SimulationChunk
+{
+    uint64_t rounds;
+    double sumPayout1, sumPayout2, sumPayout3;
+    std::vector<std::pair<Date, double> > lastPrices;
+    // The start of the random number sequence of the chunk
+    unsigned int seed;
+    // Profiler::now() when the chunk started and finished, 0 if
+    // it did not run
+    uint64_t start, end;
+};
+
+// One option row and all the intermediate results of its tasks
+struct OptionJob
+{
+    double strike, expireTradePrice, currTradePrice;
+    uint64_t rounds, steps;
+    int optIndex;
+    std::string expireDateStr;
+
+    bool failed;
+    // Why the option failed
+    std::string error;
+    Date expireDate;
+    double dfAtExpire;
+    double volatility;
+    // Wall-clock time in microseconds
+    unsigned long long volTime;
+
+    // [0] antithetic, [1] non-antithetic
+    std::vector<SimulationChunk> chunks[2];
+};
+
+class SolveVolatilityTask : public Concurrency::Runnable
+{
+    public:
+        SolveVolatilityTask(SimulationContext& context, OptionJob& job):
+            _context(context), _job(job){};
 
-            // Use this to copy one group of price prediction as output
-            std::vector<std::pair<Date, double> > tFuturePrices;
-            for(uint64_t i = 0; i < rounds; i ++)
+        virtual void run()
+        {
+            uint64_t start = Profiler::now();
+            PROFILE_TIMER(volTimer, "solveVolatility");
+            TRACE_SCOPE_ARG("solveVolatility", "option", _job.optIndex);
+            try
+            {
+                const YieldCurveInstance *yci = _context.yci;
+                Date expireDateUnModified(_job.expireDateStr);
+                _job.expireDate = WorkDate(expireDateUnModified);
+
+                double deltaT = normDiffDate(_context.today, _job.expireDate, Date::ACT365);
+                _job.dfAtExpire = yci->getDf(_job.expireDate);
+                double crfRate = - log(_job.dfAtExpire) / deltaT; // continuous time risk free rate
+
+                Volatility::FormulaClass *formula = new Volatility::VolatilityFromEuroCallPriceFormula(
+                        _job.currTradePrice, _job.strike, deltaT, crfRate,
+                        _job.expireTradePrice);
+                _job.volatility = Volatility::NewtonRaphsonMethod()(*formula, 1e-9);
+                delete formula;
+            }
+            catch(std::exception& e)
             {
-                std::vector<std::pair<Date, double> > futurePrices;
+                // Reported by the writer chain, in the input order
+                _job.failed = true;
+                _job.error = e.what();
+            }
+            volTimer.addItems(1);
+            _job.volTime = (Profiler::now() - start) / 1000;
+        }
 
-                futurePrices = MonteCarloSimulation<boxMullerM2RNG>(currTradePrice, today,
-                        duration, steps, *yci, volatility,
-                        boxMullerM2RNG(boxMullerM2RNG::ANTITHETIC));
+    private:
+        SimulationContext& _context;
+        OptionJob& _job;
+};
 
+class SimulationTask : public Concurrency::Runnable
+{
+    public:
+        // The paths are generated and then priced this many at a
+        // time, so the two stages can be profiled apart
+        static const uint64_t batchRounds = 256;
 
-                double payout1 = payOutFunc1(futurePrices);
-                double payout2 = payOutFunc2(futurePrices);
-                double payout3 = payOutFuncBenchmark(futurePrices, strike);
-                sumPayout1 += payout1;
-                sumPayout2 += payout2;
-                sumPayout3 += payout3;
+        SimulationTask(SimulationContext& context, OptionJob& job,
+                bool antithetic, int chunk):
+            _context(context), _job(job), _antithetic(antithetic),
+            _chunk(chunk){};
 
-                if(i == (rounds - 1))
-                    tFuturePrices = futurePrices;
+        virtual void run()
+        {
+            if(_job.failed || _context.stopped)
+                return;
+
+            uint64_t start = Profiler::now();
+            PROFILE_SCOPE("simulationChunk");
+            TRACE_SCOPE_ARG(_antithetic ? "simulationChunk antithetic" :
+                    "simulationChunk", "option", _job.optIndex);
+            SimulationChunk& chunk = _job.chunks[_antithetic ? 0 : 1][_chunk];
+            boxMullerM2RNG::MODE mode = _antithetic ?
+                boxMullerM2RNG::ANTITHETIC : boxMullerM2RNG::NONANTITHETIC;
+            // Kept on the stack, the chunks next to this one are
+            // written by other threads
+            unsigned int seed = chunk.seed;
+            Duration duration = _job.expireDate - _context.today;
+
+            std::vector<std::vector<std::pair<Date, double> > > paths;
+            for(uint64_t done = 0; done < chunk.rounds; done += paths.size())
+            {
+                uint64_t remaining = chunk.rounds - done;
+                paths.resize(remaining < batchRounds ? remaining : batchRounds);
+                {
+                    PROFILE_TIMER(pathTimer, "pathGeneration");
+                    for(int i = 0; i < (int)paths.size(); i ++)
+                        paths[i] = MonteCarloSimulation<boxMullerM2RNG>(
+                                _job.currTradePrice, _context.today, duration,
+                                _job.steps, *_context.yci, _job.volatility,
+                                boxMullerM2RNG(mode, &seed));
+                    pathTimer.addItems(paths.size());
+                }
+
+                PROFILE_TIMER(payoffTimer, "payoff");
+                for(int i = 0; i < (int)paths.size(); i ++)
+                {
+                    chunk.sumPayout1 += payOutFunc1(paths[i]);
+                    chunk.sumPayout2 += payOutFunc2(paths[i]);
+                    chunk.sumPayout3 += payOutFuncBenchmark(paths[i], _job.strike);
+                }
+                payoffTimer.addItems(paths.size());
             }
-            getrusage(RUSAGE_SELF, &usage);
-            t2 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-                (unsigned long long)usage.ru_utime.tv_usec;
-            t2 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-                (unsigned long long)usage.ru_stime.tv_usec;
-            std::cout << " Time used " << t2 - t1 << "us" << std::endl;
-
-            std::cout << "Using Antithetic Random Number Generator" << std::endl;
-            std::cout << "Option "  << optIndex << std::endl;
-            std::cout << "Rounds: " << rounds << std::endl;
-            std::cout << "Steps: " << steps << std::endl;
-            std::cout << "Current Trading Price: " << currTradePrice << std::endl;
-            std::cout << "Strike: " << strike << std::endl;
-            std::cout << "Expire Date: " << expireDate.toString() << std::endl;
-            std::cout << "Expire Trading price: " << expireTradePrice << std::endl;
-            std::cout << "One Group of Price Predictions:" << std::endl; 
-            std::cout.setf(std::ios::fixed);
-            for(int i = 0; i < (int) tFuturePrices.size(); i ++)
+            if(!paths.empty())
+                chunk.lastPrices = paths.back();
+            chunk.start = start;
+            chunk.end = Profiler::now();
+            PROFILE_COUNT("pathsSimulated", chunk.rounds);
+            PROFILE_COUNT("curveLookups", chunk.rounds * _job.steps);
+        }
+
+    private:
+        SimulationContext& _context;
+        OptionJob& _job;
+        bool _antithetic;
+        int _chunk;
+};
+
+class WriteOptionTask : public Concurrency::Runnable
+{
+    public:
+        WriteOptionTask(SimulationContext& context, OptionJob& job):
+            _context(context), _job(job){};
+
+        virtual void run()
+        {
+            if(_context.stopped)
+                return;
+
+            std::cout << "Calculating volatility ...";
+            if(_job.failed)
             {
-                std::cout << "\t" << tFuturePrices[i].first.toString() << "\t"
-                    << std::setprecision(4) << tFuturePrices[i].second << std::endl;
+                std::cout << std::endl;
+                std::cerr << "Option " << _job.optIndex << " expiring " <<
+                    _job.expireDateStr << ": " << _job.error << std::endl;
+                _context.stopped = true;
+                return;
             }
+            std::cout << " Time used " << _job.volTime << "us" << std::endl;
+            std::cout << "Volatility: " << std::setprecision(4) <<
+                _job.volatility << std::endl;
+
+            _writeResult(true, "Antithetic", _job.chunks[0]);
+            _writeResult(false, "Non-Antithetic", _job.chunks[1]);
+        }
 
-            std::cout << "Discount factor at expiration: " << 
-                std::setprecision(4) << dfAtExpire << std::endl;
-            std::cout << "Average pay out of Benchmark Option: " << 
-                std::setprecision(4) << sumPayout3 / (double)rounds << std::endl; 
-            std::cout << "Average pay out according to Method 1 (Option A): " << 
-                std::setprecision(4) << sumPayout1 / (double)rounds << std::endl; 
-            std::cout << "Average pay out according to Method 2 (Option B): " << 
-                std::setprecision(4) << sumPayout2 / (double)rounds << std::endl; 
-            std::cout << std::endl;
-            std::cout.unsetf(std::ios::fixed);
-
-            // Forecast the price using Monte-Carlo Method
-            // NonAntithetice method
-            std::cout << "Pricing the option using Monte-Carlo Simulation ...";
-            getrusage(RUSAGE_SELF, &usage);
-            t1 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-                (unsigned long long)usage.ru_utime.tv_usec;
-            t1 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-                (unsigned long long)usage.ru_stime.tv_usec;
-            sumPayout1 = 0;
-            sumPayout2 = 0;
-            sumPayout3 = 0;
-            for(uint64_t i = 0; i < rounds; i ++)
+    private:
+        void _writeResult(bool antithetic, const char *rngName,
+                std::vector<SimulationChunk>& chunks)
+        {
+            // Sum up the chunks in order, the sample paths come
+            // from the last round of the last chunk. The chunks run
+            // at the same time, the stage takes from the start of
+            // the first to the end of the last.
+            double sumPayout1 = 0;
+            double sumPayout2 = 0;
+            double sumPayout3 = 0;
+            uint64_t start = 0;
+            uint64_t end = 0;
+            for(int i = 0; i < (int)chunks.size(); i ++)
             {
-                std::vector<std::pair<Date, double> > futurePrices;
+                sumPayout1 += chunks[i].sumPayout1;
+                sumPayout2 += chunks[i].sumPayout2;
+                sumPayout3 += chunks[i].sumPayout3;
+                if(chunks[i].end == 0)
+                    continue;
+                if(start == 0 || chunks[i].start < start)
+                    start = chunks[i].start;
+                if(chunks[i].end > end)
+                    end = chunks[i].end;
+            }
 
-                futurePrices = MonteCarloSimulation<boxMullerM2RNG>(currTradePrice, today,
-                        duration, steps, *yci, volatility,
-                        boxMullerM2RNG(boxMullerM2RNG::NONANTITHETIC));
+            std::cout << "Pricing the option using Monte-Carlo Simulation ... Time used " <<
+                (end - start) / 1000 << "us" << std::endl;
+
+            PROFILE_TIMER(writeTimer, "writeOption");
+            TRACE_SCOPE_ARG("writeOption", "option", _job.optIndex);
+            writeTimer.addItems(1);
+            double rounds = (double)_job.rounds;
+            writeOptionReport(*_context.writer, rngName, _job.optIndex,
+                    _job.rounds, _job.steps, _job.currTradePrice, _job.strike,
+                    _job.expireDate, _job.expireTradePrice, chunks.back().lastPrices,
+                    _job.dfAtExpire, sumPayout3 / rounds, sumPayout1 / rounds,
+                    sumPayout2 / rounds);
+            if(_context.binOut != NULL)
+                appendOptionResult(*_context.binOut, _job.optIndex, antithetic,
+                        _job.rounds, _job.steps, _job.currTradePrice, _job.strike,
+                        _job.expireDate, _job.expireTradePrice, _job.volatility,
+                        _job.dfAtExpire, sumPayout3 / rounds, sumPayout1 / rounds,
+                        sumPayout2 / rounds);
+        }
 
+        SimulationContext& _context;
+        OptionJob& _job;
+};
 
-                double payout1 = payOutFunc1(futurePrices);
-                double payout2 = payOutFunc2(futurePrices);
-                double payout3 = payOutFuncBenchmark(futurePrices, strike);
-                sumPayout1 += payout1;
-                sumPayout2 += payout2;
-                sumPayout3 += payout3;
+// Read the option rows and add the tasks of every option to
+// the graph as soon as its row is parsed
+class ReadOptionsTask : public Concurrency::Runnable
+{
+    public:
+        // Do not split the simulations finer than this
+        static const uint64_t minChunkRounds = 1000;
 
-                if(i == (rounds - 1))
-                    tFuturePrices = futurePrices;
-            }
-            getrusage(RUSAGE_SELF, &usage);
-            t2 = (unsigned long long)usage.ru_utime.tv_sec * 1000000ULL +  // this is user time
-                (unsigned long long)usage.ru_utime.tv_usec;
-            t2 += (unsigned long long)usage.ru_stime.tv_sec * 1000000ULL + // this is system time
-                (unsigned long long)usage.ru_stime.tv_usec;
-            std::cout << " Time used " << t2 - t1 << "us" << std::endl;
-
-            std::cout << "Using Non-Antithetic Random Number Generator" << std::endl;
-            std::cout << "Option "  << optIndex << std::endl;
-            std::cout << "Rounds: " << rounds << std::endl;
-            std::cout << "Steps: " << steps << std::endl;
-            std::cout << "Current Trading Price: " << currTradePrice << std::endl;
-            std::cout << "Strike: " << strike << std::endl;
-            std::cout << "Expire Date: " << expireDate.toString() << std::endl;
-            std::cout << "Expire Trading price: " << expireTradePrice << std::endl;
-            std::cout << "One Group of Price Predictions:" << std::endl; 
-            std::cout.setf(std::ios::fixed);
-            for(int i = 0; i < (int) tFuturePrices.size(); i ++)
+        ReadOptionsTask(SimulationContext& context):_context(context){};
+
+        ~ReadOptionsTask()
+        {
+            for(int i = 0; i < (int)_tasks.size(); i ++)
+                delete _tasks[i];
+            for(int i = 0; i < (int)_jobs.size(); i ++)
+                delete _jobs[i];
+        }
+
+        virtual void run()
+        {
+            Concurrency::TaskGraph& graph = _context.graph;
+            Concurrency::TaskGraph::TaskId lastWriteTask = _context.curveReportTask;
+            std::ifstream finOptionDesc(_context.inOptionDescFilename.c_str());
+            std::string line;
+            getline(finOptionDesc, line);
+            while(finOptionDesc.good())
             {
-                std::cout << "\t" << tFuturePrices[i].first.toString() << "\t"
-                    << std::setprecision(4) << tFuturePrices[i].second << std::endl;
+                OptionJob *job = new OptionJob();
+                char comma;
+
+                finOptionDesc >> job->optIndex >> comma >> job->steps >> comma >>
+                    job->rounds >> comma >> job->currTradePrice >> comma >>
+                    job->strike >> comma >> job->expireTradePrice >> comma >>
+                    job->expireDateStr;
+
+                if(!finOptionDesc.good())
+                {
+                    delete job;
+                    break;
+                }
+                job->failed = false;
+                _jobs.push_back(job);
+
+                Concurrency::TaskGraph::TaskId volTask =
+                    graph.addTask(_newTask(new SolveVolatilityTask(_context, *job)),
+                            _context.bindTask);
+
+                std::vector<Concurrency::TaskGraph::TaskId> writeDependencies;
+                writeDependencies.push_back(lastWriteTask);
+                uint64_t numChunks = job->rounds / minChunkRounds;
+                if(numChunks > (uint64_t)_context.numThreads)
+                    numChunks = _context.numThreads;
+                if(numChunks < 1)
+                    numChunks = 1;
+
+                for(int kind = 0; kind < 2; kind ++)
+                {
+                    job->chunks[kind].resize(numChunks);
+                    for(uint64_t i = 0; i < numChunks; i ++)
+                    {
+                        SimulationChunk& chunk = job->chunks[kind][i];
+                        chunk.rounds = job->rounds / numChunks +
+                            (i < job->rounds % numChunks ? 1 : 0);
+                        chunk.sumPayout1 = chunk.sumPayout2 = chunk.sumPayout3 = 0;
+                        chunk.seed = chunkSeed(_context.seed, job->optIndex,
+                                kind, i);
+                        chunk.start = chunk.end = 0;
+
+                        writeDependencies.push_back(graph.addTask(
+                                    _newTask(new SimulationTask(_context, *job,
+                                            kind == 0, (int)i)), volTask));
+                    }
+                }
+
+                lastWriteTask = graph.addTask(
+                        _newTask(new WriteOptionTask(_context, *job)),
+                        writeDependencies);
             }
+            finOptionDesc.close();
+        }
+
+    private:
+        Concurrency::Runnable& _newTask(Concurrency::Runnable *task)
+        {
+            _tasks.push_back(task);
+            return *task;
+        }
+
+        SimulationContext& _context;
+        // Only touched by this task and after the graph is done
+        std::vector<OptionJob *> _jobs;
+        std::vector<Concurrency::Runnable *> _tasks;
+};
+
+int 
+main(int argc, char * argv[])
+{
+    std::string outBinaryFilename;
+    std::string holidayFilename;
+    std::string asOfString;
+    std::string profileFilename;
+    bool hardwareCounters = false;
+    std::string traceFilename;
+    bool trackAllocations = false;
+    unsigned int seed = (unsigned int)time(NULL);
+    std::string storeCurve;
+    int numThreads = Concurrency::hardwareConcurrency();
+    int opt;
+    while((opt = getopt(argc, argv, "j:b:H:d:p:et:ms:a:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'j':
+                numThreads = atoi(optarg);
+                if(numThreads <= 0)
+                    numThreads = Concurrency::hardwareConcurrency();
+                break;
+            case 'b':
+                outBinaryFilename = optarg;
+                break;
+            case 'H':
+                holidayFilename = optarg;
+                break;
+            case 'd':
+                asOfString = optarg;
+                break;
+            case 'p':
+                profileFilename = optarg;
+                break;
+            case 'e':
+                hardwareCounters = true;
+                break;
+            case 't':
+                traceFilename = optarg;
+                break;
+            case 'm':
+                trackAllocations = true;
+                break;
+            case 's':
+                seed = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'a':
+                storeCurve = optarg;
+                break;
+            default:
+                printUsage();
+                exit(0);
+        }
+    }
+
+    // The curve store names cannot contain a slash
+    size_t slash = storeCurve.find('/');
+    if(argc - optind != (storeCurve.empty() ? 3 : 1) ||
+            (!storeCurve.empty() && slash == std::string::npos))
+    {
+        printUsage();
+        exit(0);
+    }
+
+    srand(seed);
+    if(!profileFilename.empty())
+        Profiler::dumpOnExit(profileFilename);
+    std::string counterError;
+    if(hardwareCounters && !Profiler::enableHardwareCounters(counterError))
+        std::cerr << "Hardware counters are not available (" << counterError <<
+            "), only the times are profiled" << std::endl;
+    else if(hardwareCounters && !counterError.empty())
+        std::cerr << "Some hardware events are not counted (" << counterError <<
+            ")" << std::endl;
+    if(!traceFilename.empty())
+    {
+        Trace::enable();
+        Trace::writeOnExit(traceFilename);
+    }
+    if(trackAllocations && !AllocationTracker::enable())
+        std::cerr << "Allocation tracking is compiled out" << std::endl;
+
+    // A bad as-of date is a usage error, found before anything is read
+    Date asOfDate = Date::today();
+    if(!asOfString.empty())
+    {
+        try
+        {
+            asOfDate = Date(asOfString);
+        }
+        catch(std::exception& e)
+        {
+            std::cerr << "Invalid as-of date " << asOfString << " (" <<
+                e.what() << ")" << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    SimulationContext context;
+    if(storeCurve.empty())
+    {
+        context.inCVDefFilename = argv[optind];
+        context.inCVDataFilename = argv[optind + 1];
+    }
+    context.inOptionDescFilename = argv[argc - 1];
+    context.store = NULL;
+    context.numThreads = numThreads;
+    context.seed = seed;
+    context.ycDef = NULL;
+    context.yci = NULL;
+    context.parseTime = context.bindTime = context.attachTime = 0;
+    context.writer = NULL;
+    context.binOut = NULL;
+    context.stopped = false;
+    int status = 0;
 
-            std::cout << "Discount factor at expiration: " << 
-                std::setprecision(4) << dfAtExpire << std::endl;
-            std::cout << "Average pay out of Benchmark Option: " << 
-                std::setprecision(4) << sumPayout3 / (double)rounds << std::endl; 
-            std::cout << "Average pay out according to Method 1 (Option A): " << 
-                std::setprecision(4) << sumPayout1 / (double)rounds << std::endl; 
-            std::cout << "Average pay out according to Method 2 (Option B): " << 
-                std::setprecision(4) << sumPayout2 / (double)rounds << std::endl; 
-            std::cout << std::endl;
-            std::cout.unsetf(std::ios::fixed);
+    try
+    {
+        // Work dates skip the holidays as well as the weekends
+        if(!holidayFilename.empty())
+            Calendar::setWorkCalendar(Calendar::fromCSV(holidayFilename, "HOLIDAYS"));
+        // The curve and the options are valued as of the work
+        // day of the as-of date
+        context.today = WorkDate(asOfDate);
+
+        if(!storeCurve.empty())
+        {
+            uint64_t start = Profiler::now();
+            PROFILE_SCOPE("attachCurveStore");
+            TRACE_SCOPE("attachCurveStore");
+            std::string storeName = storeCurve.substr(0, slash);
+            std::string curveName = storeCurve.substr(slash + 1);
+            context.store = new CurveStoreReader(storeName);
+            context.yci = context.store->find(curveName);
+            if(context.yci == NULL)
+                throw CurveStoreException("No curve " + curveName +
+                        " in the curve store " + storeName);
+            if(asOfString.empty())
+                context.today = context.yci->startDate();
+            context.attachTime = (Profiler::now() - start) / 1000;
         }
-        finOptionDesc.close();
 
-        delete yci;
+        BufferedWriter writer(STDOUT_FILENO);
+        context.writer = &writer;
+        if(!outBinaryFilename.empty())
+            context.binOut = new Columnar::ColumnarWriter(outBinaryFilename,
+                    optionResultSchema());
 
-        while(!instrDefs.empty())
+        ParseDefinitionTask parseDefinition(context);
+        ReadCurveDataTask readCurveData(context);
+        BindCurveTask bindCurve(context);
+        CurveReportTask curveReport(context);
+        ReadOptionsTask readOptions(context);
+
+        Concurrency::TaskGraph& graph = context.graph;
+        if(context.store != NULL)
+        {
+            // The curve is ready
+            context.bindTask = graph.addTask(curveReport);
+            context.curveReportTask = context.bindTask;
+        }
+        else
         {
-            InstrumentDefinition * ptrInstrDef = instrDefs.back();
-            instrDefs.pop_back();
-            delete ptrInstrDef;
+            std::vector<Concurrency::TaskGraph::TaskId> curveInputs;
+            curveInputs.push_back(graph.addTask(parseDefinition));
+            curveInputs.push_back(graph.addTask(readCurveData));
+            context.bindTask = graph.addTask(bindCurve, curveInputs);
+            context.curveReportTask = graph.addTask(curveReport, context.bindTask);
         }
+        graph.addTask(readOptions);
 
-        std::cout << "Program finished successfully." << std::endl;
+        try
+        {
+            graph.run(numThreads);
+        }
+        catch(Concurrency::ConcurrencyException& e)
+        {
+            // The first task which failed
+            std::cerr << e.what() << std::endl;
+            status = 1;
+        }
+
+        if(context.binOut != NULL)
+            context.binOut->close();
+
+        if(context.stopped)
+            status = 1;
+        if(status == 0 && context.yci != NULL)
+            std::cout << "Program finished successfully." << std::endl;
+    }
+    catch(OutputException& e)
+    {
+        std::cerr << e.what() << std::endl;
+        status = 1;
     }
-    catch(std::fstream::failure& e)
+    catch(Columnar::ColumnarFileException& e)
     {
+        std::cerr << e.what() << std::endl;
+        status = 1;
     }
-    catch(InstrumentException& e)
+    catch(CalendarException& e)
     {
+        std::cerr << e.what() << std::endl;
+        status = 1;
     }
-    catch(YieldCurveException& e)
+    catch(CurveStoreException& e)
     {
+        std::cerr << e.what() << std::endl;
+        status = 1;
     }
 
-    return 0;
+    delete context.binOut;
+    if(context.store == NULL)
+        delete context.yci;
+    delete context.store;
+    delete context.ycDef;
+
+    return status;
 }
@@ -0,0 +1,87 @@
+#include <new>
+#include <cstddef>
+
+#include "AllocationTracker.h"
+
+// The global operator new and delete replaced for AllocationTracker.
+// Linked as an object of its own into the programs that track their
+// allocations, so that the other programs keep those of the library.
+
+#ifndef NO_PROFILING
+
+#if __cplusplus >= 201103L
+#define ALLOCATION_THROW
+#define ALLOCATION_NOTHROW noexcept
+#else
+#define ALLOCATION_THROW throw(std::bad_alloc)
+#define ALLOCATION_NOTHROW throw()
+#endif
+
+namespace
+{
+    struct HookLinked
+    {
+        HookLinked(){AllocationTracker::hookLinked();}
+    };
+
+    HookLinked hookLinked;
+}
+
+void *operator new(size_t size) ALLOCATION_THROW
+{
+    void *ptr = AllocationTracker::allocate(size);
+    if(ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) ALLOCATION_THROW
+{
+    void *ptr = AllocationTracker::allocate(size);
+    if(ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    return AllocationTracker::allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    return AllocationTracker::allocate(size);
+}
+
+void operator delete(void *ptr) ALLOCATION_NOTHROW
+{
+    AllocationTracker::release(ptr);
+}
+
+void operator delete[](void *ptr) ALLOCATION_NOTHROW
+{
+    AllocationTracker::release(ptr);
+}
+
+// Called instead of the two above from C++14 on
+void operator delete(void *ptr, size_t) ALLOCATION_NOTHROW
+{
+    AllocationTracker::release(ptr);
+}
+
+void operator delete[](void *ptr, size_t) ALLOCATION_NOTHROW
+{
+    AllocationTracker::release(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    AllocationTracker::release(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) ALLOCATION_NOTHROW
+{
+    AllocationTracker::release(ptr);
+}
+
+#endif
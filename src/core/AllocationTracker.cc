@@ -0,0 +1,268 @@
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+#include "AllocationTracker.h"
+#include "Profiler.h"
+
+namespace
+{
+    // Slot 0 is out of any scope, slot id + 1 is the timer id
+    const int numStages = Profiler::maxTimers + 1;
+
+    // The counts of one thread, kept after it exits. Allocated
+    // with malloc, so creating it is not counted.
+    struct ThreadAllocations
+    {
+        uint64_t scopes[numStages];
+        uint64_t allocations[numStages];
+        uint64_t frees[numStages];
+        uint64_t bytes[numStages];
+        int64_t peakLiveBytes[numStages];
+        long maxRssKb[numStages];
+    };
+
+    volatile bool tracking = false;
+    // Set when AllocationHook.cc is linked in
+    volatile bool hooked = false;
+    volatile int64_t processLiveBytes = 0;
+    volatile int64_t processPeakBytes = 0;
+    volatile uint64_t processAllocations = 0;
+
+    pthread_mutex_t recordsLock = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<ThreadAllocations *> *records = NULL;
+
+    __thread ThreadAllocations *threadAllocations = NULL;
+    __thread int currentStage = 0;
+    __thread int64_t threadLiveBytes = 0;
+    __thread int64_t threadPeakBytes = 0;
+    // Set while the tracker itself allocates
+    __thread bool inTracker = false;
+
+    inline size_t usableSize(void *ptr)
+    {
+#ifdef __APPLE__
+        return malloc_size(ptr);
+#else
+        return malloc_usable_size(ptr);
+#endif
+    }
+
+    ThreadAllocations& localAllocations()
+    {
+        if(threadAllocations != NULL)
+            return *threadAllocations;
+
+        ThreadAllocations *record =
+            static_cast<ThreadAllocations *>(malloc(sizeof(ThreadAllocations)));
+        memset(record, 0, sizeof(ThreadAllocations));
+
+        pthread_mutex_lock(&recordsLock);
+        if(records == NULL)
+            records = new std::vector<ThreadAllocations *>();
+        records->push_back(record);
+        pthread_mutex_unlock(&recordsLock);
+
+        threadAllocations = record;
+        return *record;
+    }
+
+#ifndef NO_PROFILING
+    void recordAllocation(void *ptr, size_t size)
+    {
+        if(inTracker || ptr == NULL)
+            return;
+
+        inTracker = true;
+        ThreadAllocations& record = localAllocations();
+        int64_t usable = (int64_t)usableSize(ptr);
+        record.allocations[currentStage] ++;
+        record.bytes[currentStage] += size;
+
+        threadLiveBytes += usable;
+        if(threadLiveBytes > threadPeakBytes)
+            threadPeakBytes = threadLiveBytes;
+
+        __sync_fetch_and_add(&processAllocations, 1);
+        int64_t live = __sync_add_and_fetch(&processLiveBytes, usable);
+        int64_t peak = processPeakBytes;
+        while(live > peak)
+        {
+            int64_t seen = __sync_val_compare_and_swap(&processPeakBytes, peak, live);
+            if(seen == peak)
+                break;
+            peak = seen;
+        }
+        inTracker = false;
+    }
+
+    void recordFree(void *ptr)
+    {
+        if(inTracker || ptr == NULL)
+            return;
+
+        inTracker = true;
+        ThreadAllocations& record = localAllocations();
+        int64_t usable = (int64_t)usableSize(ptr);
+        record.frees[currentStage] ++;
+        threadLiveBytes -= usable;
+        __sync_sub_and_fetch(&processLiveBytes, usable);
+        inTracker = false;
+    }
+#endif
+}
+
+#ifndef NO_PROFILING
+
+void *AllocationTracker::allocate(size_t size)
+{
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if(tracking)
+        recordAllocation(ptr, size);
+    return ptr;
+}
+
+void AllocationTracker::release(void *ptr)
+{
+    if(tracking)
+        recordFree(ptr);
+    free(ptr);
+}
+
+void AllocationTracker::hookLinked()
+{
+    hooked = true;
+}
+
+#endif
+
+bool AllocationTracker::enable()
+{
+#ifdef NO_PROFILING
+    return false;
+#else
+    if(!hooked)
+        return false;
+    __sync_synchronize();
+    tracking = true;
+    return true;
+#endif
+}
+
+bool AllocationTracker::enabled()
+{
+    return tracking;
+}
+
+bool AllocationTracker::startScope(int timerId, Scope& scope)
+{
+    if(!tracking || timerId < 0)
+        return false;
+
+    scope.outerStage = currentStage;
+    scope.baseBytes = threadLiveBytes;
+    scope.outerPeakBytes = threadPeakBytes;
+    currentStage = timerId + 1;
+    threadPeakBytes = threadLiveBytes;
+    return true;
+}
+
+void AllocationTracker::stopScope(int timerId, const Scope& scope)
+{
+    inTracker = true;
+    ThreadAllocations& record = localAllocations();
+    int stage = timerId + 1;
+    record.scopes[stage] ++;
+    int64_t peak = threadPeakBytes - scope.baseBytes;
+    if(peak > record.peakLiveBytes[stage])
+        record.peakLiveBytes[stage] = peak;
+    long rss = maxRssKb();
+    if(rss > record.maxRssKb[stage])
+        record.maxRssKb[stage] = rss;
+
+    if(scope.outerPeakBytes > threadPeakBytes)
+        threadPeakBytes = scope.outerPeakBytes;
+    currentStage = scope.outerStage;
+    inTracker = false;
+}
+
+void AllocationTracker::snapshot(std::vector<StageReport>& stages)
+{
+    stages.clear();
+    std::vector<StageReport> merged(numStages);
+    pthread_mutex_lock(&recordsLock);
+    for(int s = 0; s < numStages; s ++)
+    {
+        StageReport& stage = merged[s];
+        memset(&stage, 0, sizeof(StageReport));
+        stage.timerId = s - 1;
+        for(int i = 0; records != NULL && i < (int)records->size(); i ++)
+        {
+            const ThreadAllocations& record = *(*records)[i];
+            stage.scopes += record.scopes[s];
+            stage.allocations += record.allocations[s];
+            stage.frees += record.frees[s];
+            stage.bytes += record.bytes[s];
+            if(record.peakLiveBytes[s] > stage.peakLiveBytes)
+                stage.peakLiveBytes = record.peakLiveBytes[s];
+            if(record.maxRssKb[s] > stage.maxRssKb)
+                stage.maxRssKb = record.maxRssKb[s];
+        }
+    }
+    pthread_mutex_unlock(&recordsLock);
+
+    for(int s = 1; s <= numStages; s ++)
+    {
+        const StageReport& stage = merged[s % numStages];
+        if(stage.scopes > 0 || stage.allocations > 0 || stage.frees > 0)
+            stages.push_back(stage);
+    }
+}
+
+int64_t AllocationTracker::liveBytes()
+{
+    return processLiveBytes;
+}
+
+int64_t AllocationTracker::peakLiveBytes()
+{
+    return processPeakBytes;
+}
+
+uint64_t AllocationTracker::allocations()
+{
+    return processAllocations;
+}
+
+long AllocationTracker::maxRssKb()
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    // In bytes on Mac OS
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+void AllocationTracker::reset()
+{
+    pthread_mutex_lock(&recordsLock);
+    for(int i = 0; records != NULL && i < (int)records->size(); i ++)
+        memset((*records)[i], 0, sizeof(ThreadAllocations));
+    pthread_mutex_unlock(&recordsLock);
+
+    processAllocations = 0;
+    processPeakBytes = processLiveBytes;
+    threadPeakBytes = threadLiveBytes;
+}
@@ -0,0 +1,234 @@
+#include <fstream>
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+#include "Calendar.h"
+
+namespace
+{
+    inline bool isWeekend(const boost::gregorian::date& date)
+    {
+        boost::gregorian::greg_weekday gw = date.day_of_week();
+        return gw == boost::gregorian::Saturday || gw == boost::gregorian::Sunday;
+    }
+
+    // The adjustment used outside of the range of the tables
+    boost::gregorian::date skipWeekend(const boost::gregorian::date& day,
+            Calendar::ADJUSTMENT adjustment)
+    {
+        using namespace boost::gregorian;
+
+        if(!isWeekend(day))
+            return day;
+
+        date following = next_weekday(day, greg_weekday(Monday));
+        if(adjustment == Calendar::FOLLOWING ||
+                (adjustment == Calendar::MODIFIEDFOLLOWING &&
+                 following.month() == day.month()))
+            return following;
+
+        return previous_weekday(day, greg_weekday(Friday));
+    }
+
+    Calendar *currentWorkCalendar = NULL;
+    volatile unsigned long nextCalendarId = 0;
+}
+
+const boost::gregorian::date Calendar::defaultFirstDate(1900, 1, 1);
+const boost::gregorian::date Calendar::defaultLastDate(2199, 12, 31);
+
+//////////////////////////////////////////
+// Definition of the class Calendar
+//////////////////////////////////////////
+Calendar::Calendar():
+    // Not defaultFirstDate and defaultLastDate, the weekend calendar
+    // may be needed before the static members are initialized
+    _name("WEEKEND"), _firstDate(1900, 1, 1), _lastDate(2199, 12, 31)
+{
+    _build();
+}
+
+Calendar::Calendar(const std::string& name,
+        const std::vector<Date>& holidays,
+        const boost::gregorian::date& firstDate,
+        const boost::gregorian::date& lastDate):
+    _name(name), _holidays(holidays), _firstDate(firstDate),
+    _lastDate(lastDate)
+{
+    if(_lastDate < _firstDate)
+        throw CalendarException("The last date of the calendar " + _name +
+                " is before its first date");
+
+    std::sort(_holidays.begin(), _holidays.end());
+    _holidays.erase(std::unique(_holidays.begin(), _holidays.end()),
+            _holidays.end());
+    _build();
+}
+
+Calendar::~Calendar()
+{
+}
+
+void Calendar::_build()
+{
+    _id = __sync_fetch_and_add(&nextCalendarId, 1);
+    _firstDayNumber = (long)_firstDate.day_number();
+    _numDays = (long)_lastDate.day_number() - _firstDayNumber + 1;
+
+    long numWords = (_numDays + 63) / 64;
+    std::vector<boost::uint64_t>(numWords, 0).swap(_bits);
+
+    // Weekdays first, then clear the holidays
+    int weekday = _firstDate.day_of_week();
+    for(long i = 0; i < _numDays; i ++, weekday = (weekday + 1) % 7)
+    {
+        if(weekday != boost::gregorian::Saturday && weekday != boost::gregorian::Sunday)
+            _bits[i >> 6] |= 1ULL << (i & 63);
+    }
+
+    for(int i = 0; i < (int)_holidays.size(); i ++)
+    {
+        long index = _index(_holidays[i].get());
+        if(_inRange(index))
+            _bits[index >> 6] &= ~(1ULL << (index & 63));
+    }
+
+    std::vector<long>(numWords + 1, 0).swap(_wordRanks);
+    std::vector<int>().swap(_businessDays);
+    for(long word = 0; word < numWords; word ++)
+    {
+        _wordRanks[word + 1] = _wordRanks[word] + __builtin_popcountll(_bits[word]);
+
+        for(long i = word * 64; i < std::min((word + 1) * 64, _numDays); i ++)
+            if(_isBusinessDay(i))
+                _businessDays.push_back((int)i);
+    }
+}
+
+Calendar Calendar::fromCSV(const std::string& filename,
+        const std::string& name)
+{
+    std::ifstream fin(filename.c_str());
+    if(!fin.good())
+        throw CalendarException("Fail to open the holiday file " + filename);
+
+    std::vector<Date> holidays;
+    std::string line;
+    while(getline(fin, line))
+    {
+        std::string field = line.substr(0, line.find(','));
+        boost::trim_if(field, boost::algorithm::is_any_of(" \t\r\n\""));
+        if(field.empty())
+            continue;
+
+        try
+        {
+            holidays.push_back(Date(field));
+        }
+        catch(std::exception& e)
+        {
+            // not a date, e.g. the header
+        }
+    }
+    fin.close();
+
+    return Calendar(name, holidays);
+}
+
+Calendar Calendar::joint(const Calendar& lhs, const Calendar& rhs)
+{
+    std::vector<Date> holidays(lhs._holidays);
+    holidays.insert(holidays.end(), rhs._holidays.begin(), rhs._holidays.end());
+
+    return Calendar(lhs._name + "+" + rhs._name, holidays,
+            std::max(lhs._firstDate, rhs._firstDate),
+            std::min(lhs._lastDate, rhs._lastDate));
+}
+
+bool Calendar::isBusinessDay(const Date& date) const
+{
+    long index = _index(date.get());
+    if(!_inRange(index))
+        return !isWeekend(date.get());
+
+    return _isBusinessDay(index);
+}
+
+Date Calendar::adjust(const Date& date, Calendar::ADJUSTMENT adjustment) const
+{
+    long index = _index(date.get());
+    if(!_inRange(index))
+        return Date(skipWeekend(date.get(), adjustment));
+
+    if(_isBusinessDay(index))
+        return date;
+
+    long rank = _rank(index);
+    if(adjustment != PRECEDING)
+    {
+        // No business day left in the tables
+        if(rank >= (long)_businessDays.size())
+            return Date(skipWeekend(date.get(), adjustment));
+
+        boost::gregorian::date following = _firstDate +
+            boost::gregorian::date_duration(_businessDays[rank]);
+
+        if(adjustment == FOLLOWING || following.month() == date.get().month())
+            return Date(following);
+    }
+
+    if(rank > 0)
+        return Date(_firstDate + boost::gregorian::date_duration(_businessDays[rank - 1]));
+
+    return Date(skipWeekend(date.get(), adjustment));
+}
+
+Date Calendar::addBusinessDays(const Date& date, int n) const
+{
+    if(n == 0)
+        return adjust(date, FOLLOWING);
+
+    long index = _index(date.get());
+    if(!_inRange(index))
+        throw CalendarException("The date " + date.toString() +
+                " is out of the range of the calendar " + _name);
+
+    // Business days up to the date, excluded for n > 0
+    // and included for n < 0
+    long target = n > 0 ? _rank(index + 1) + n - 1 : _rank(index) + n;
+    if(target < 0 || target >= (long)_businessDays.size())
+        throw CalendarException("The result of adding business days to " +
+                date.toString() + " is out of the range of the calendar " + _name);
+
+    return Date(_firstDate + boost::gregorian::date_duration(_businessDays[target]));
+}
+
+long Calendar::businessDaysBetween(const Date& from, const Date& to) const
+{
+    long fromIndex = _index(from.get());
+    long toIndex = _index(to.get());
+
+    // The rank is also defined one past the last day
+    if(fromIndex < 0 || fromIndex > _numDays || toIndex < 0 || toIndex > _numDays)
+        throw CalendarException("The dates are out of the range of the calendar " + _name);
+
+    return _rank(toIndex) - _rank(fromIndex);
+}
+
+const Calendar& Calendar::workCalendar()
+{
+    if(currentWorkCalendar == NULL)
+    {
+        static Calendar weekendCalendar;
+        return weekendCalendar;
+    }
+
+    return *currentWorkCalendar;
+}
+
+void Calendar::setWorkCalendar(const Calendar& calendar)
+{
+    Calendar *previous = currentWorkCalendar;
+    currentWorkCalendar = new Calendar(calendar);
+    delete previous;
+}
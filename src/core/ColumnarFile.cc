@@ -0,0 +1,372 @@
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ColumnarFile.h"
+
+using namespace Columnar;
+
+namespace
+{
+    const char fileMagic[8] = {'Y', 'C', 'C', 'O', 'L', 'F', '0', '1'};
+    const char chunkMagic[8] = {'Y', 'C', 'C', 'O', 'L', 'C', 'H', 'K'};
+    const char trailerMagic[8] = {'Y', 'C', 'C', 'O', 'L', 'E', 'N', 'D'};
+    const uint32_t formatVersion = 2;
+
+    const boost::gregorian::date epoch(1970, boost::gregorian::Jan, 1);
+
+    inline uint64_t alignUp(uint64_t size)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    int typeWidth(COLUMNTYPE type)
+    {
+        switch(type)
+        {
+            case INT32:
+            case DATE32:
+                return 4;
+            case INT64:
+            case FLOAT64:
+                return 8;
+            default:
+                throw ColumnarFileException("Invalid column type");
+        }
+    }
+}
+
+int32_t Columnar::toDate32(const Date& date)
+{
+    return (int32_t)(date.get() - epoch).days();
+}
+
+Date Columnar::fromDate32(int32_t days)
+{
+    return Date(epoch + boost::gregorian::date_duration(days));
+}
+
+//////////////////////////////////////////
+// Definition of the class ColumnarWriter
+//////////////////////////////////////////
+ColumnarWriter::ColumnarWriter(const std::string& filename,
+        const Schema& schema, size_t rowsPerChunk):
+    _schema(schema), _widths(schema.size()), _columns(schema.size()),
+    _rowSet(schema.size()), _rowsPerChunk(rowsPerChunk < 1 ? 1 : rowsPerChunk),
+    _numRowsInChunk(0), _numRows(0), _offset(0), _writer(filename),
+    _closed(false)
+{
+    ColumnarFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.numColumns = (uint32_t)schema.size();
+    header.headerSize = (uint32_t)alignUp(sizeof(ColumnarFileHeader) +
+            schema.size() * sizeof(ColumnarColumnDesc));
+
+    _writer.write((const char *)&header, sizeof(header));
+    _offset += sizeof(header);
+
+    for(int i = 0; i < (int)schema.size(); i ++)
+    {
+        ColumnarColumnDesc desc;
+        memset(&desc, 0, sizeof(desc));
+        strncpy(desc.name, schema[i].first.c_str(), sizeof(desc.name) - 1);
+        desc.type = schema[i].second;
+        desc.width = typeWidth(schema[i].second);
+        _widths[i] = desc.width;
+        _columns[i].reserve(_rowsPerChunk * desc.width);
+
+        _writer.write((const char *)&desc, sizeof(desc));
+        _offset += sizeof(desc);
+    }
+    _pad();
+}
+
+ColumnarWriter::~ColumnarWriter()
+{
+    if(!_closed)
+    {
+        try
+        {
+            close();
+        }
+        catch(std::exception& e)
+        {
+        }
+    }
+}
+
+void ColumnarWriter::_set(int column, COLUMNTYPE type, const void *value)
+{
+    if(column < 0 || column >= (int)_schema.size() ||
+            _schema[column].second != type)
+    {
+        std::ostringstream oss;
+        oss << "Invalid value for column " << column;
+        throw ColumnarFileException(oss.str());
+    }
+
+    std::vector<char>& buffer = _columns[column];
+    const char *bytes = (const char *)value;
+    if(_rowSet[column])
+        memcpy(&buffer[buffer.size() - _widths[column]], bytes, _widths[column]);
+    else
+        buffer.insert(buffer.end(), bytes, bytes + _widths[column]);
+    _rowSet[column] = 1;
+}
+
+void ColumnarWriter::setInt32(int column, int32_t value)
+{
+    _set(column, INT32, &value);
+}
+
+void ColumnarWriter::setInt64(int column, int64_t value)
+{
+    _set(column, INT64, &value);
+}
+
+void ColumnarWriter::setFloat64(int column, double value)
+{
+    _set(column, FLOAT64, &value);
+}
+
+void ColumnarWriter::setDate(int column, const Date& date)
+{
+    int32_t days = toDate32(date);
+    _set(column, DATE32, &days);
+}
+
+void ColumnarWriter::endRow()
+{
+    for(int i = 0; i < (int)_rowSet.size(); i ++)
+    {
+        if(!_rowSet[i])
+        {
+            std::ostringstream oss;
+            oss << "Column " << _schema[i].first << " is not set in row " << _numRows;
+            throw ColumnarFileException(oss.str());
+        }
+        _rowSet[i] = 0;
+    }
+
+    _numRowsInChunk ++;
+    _numRows ++;
+    if(_numRowsInChunk >= _rowsPerChunk)
+        _writeChunk();
+}
+
+void ColumnarWriter::close()
+{
+    if(_closed)
+        return;
+    _closed = true;
+
+    if(_numRowsInChunk > 0)
+        _writeChunk();
+
+    uint64_t directoryOffset = _offset;
+    if(!_chunkOffsets.empty())
+    {
+        _writer.write((const char *)&_chunkOffsets[0],
+                _chunkOffsets.size() * sizeof(uint64_t));
+        _offset += _chunkOffsets.size() * sizeof(uint64_t);
+    }
+
+    ColumnarFileTrailer trailer;
+    trailer.numChunks = _chunkOffsets.size();
+    trailer.numRows = _numRows;
+    trailer.directoryOffset = directoryOffset;
+    memcpy(trailer.magic, trailerMagic, sizeof(trailerMagic));
+    _writer.write((const char *)&trailer, sizeof(trailer));
+    _offset += sizeof(trailer);
+
+    _writer.flush();
+}
+
+void ColumnarWriter::_writeChunk()
+{
+    uint64_t chunkSize = sizeof(ColumnarChunkHeader);
+    for(int i = 0; i < (int)_columns.size(); i ++)
+        chunkSize += alignUp(_columns[i].size());
+
+    ColumnarChunkHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, chunkMagic, sizeof(chunkMagic));
+    header.numRows = _numRowsInChunk;
+    header.chunkSize = chunkSize;
+
+    _chunkOffsets.push_back(_offset);
+    _writer.write((const char *)&header, sizeof(header));
+    _offset += sizeof(header);
+
+    for(int i = 0; i < (int)_columns.size(); i ++)
+    {
+        if(!_columns[i].empty())
+            _writer.write(&_columns[i][0], _columns[i].size());
+        _offset += _columns[i].size();
+        _pad();
+        _columns[i].clear();
+    }
+
+    _numRowsInChunk = 0;
+}
+
+void ColumnarWriter::_pad()
+{
+    static const char zeros[alignment] = {0};
+    size_t padding = alignUp(_offset) - _offset;
+    _writer.write(zeros, padding);
+    _offset += padding;
+}
+
+//////////////////////////////////////////
+// Definition of the class ColumnarReader
+//////////////////////////////////////////
+ColumnarReader::ColumnarReader(const std::string& filename):
+    _data(NULL), _size(0), _numRows(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw ColumnarFileException("Cannot open the columnar file " + filename);
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size <
+            (off_t)(sizeof(ColumnarFileHeader) + sizeof(ColumnarFileTrailer)))
+    {
+        ::close(fd);
+        throw ColumnarFileException("Invalid columnar file " + filename);
+    }
+
+    _size = fileStat.st_size;
+    void *data = mmap(NULL, _size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        throw ColumnarFileException("Cannot map the columnar file " + filename);
+    _data = (const char *)data;
+
+    const ColumnarFileHeader *header = (const ColumnarFileHeader *)_data;
+    const ColumnarFileTrailer *trailer = (const ColumnarFileTrailer *)
+        (_data + _size - sizeof(ColumnarFileTrailer));
+
+    if(memcmp(header->magic, fileMagic, sizeof(fileMagic)) == 0 &&
+            header->byteOrder != byteOrderMark)
+    {
+        munmap((void *)_data, _size);
+        throw ColumnarFileException("The columnar file " + filename +
+                " was written in the other byte order");
+    }
+
+    if(memcmp(header->magic, fileMagic, sizeof(fileMagic)) != 0 ||
+            header->version != formatVersion ||
+            memcmp(trailer->magic, trailerMagic, sizeof(trailerMagic)) != 0 ||
+            header->headerSize > _size ||
+            sizeof(ColumnarFileHeader) + header->numColumns *
+                sizeof(ColumnarColumnDesc) > header->headerSize ||
+            trailer->directoryOffset + trailer->numChunks * sizeof(uint64_t) +
+                sizeof(ColumnarFileTrailer) != _size)
+    {
+        munmap((void *)_data, _size);
+        throw ColumnarFileException("Invalid columnar file " + filename);
+    }
+
+    const ColumnarColumnDesc *descs = (const ColumnarColumnDesc *)
+        (_data + sizeof(ColumnarFileHeader));
+    for(uint32_t i = 0; i < header->numColumns; i ++)
+        _descs.push_back(descs + i);
+
+    const uint64_t *directory = (const uint64_t *)(_data + trailer->directoryOffset);
+    for(uint64_t i = 0; i < trailer->numChunks; i ++)
+    {
+        const ColumnarChunkHeader *chunk = (const ColumnarChunkHeader *)
+            (_data + directory[i]);
+        if(directory[i] + sizeof(ColumnarChunkHeader) > trailer->directoryOffset ||
+                memcmp(chunk->magic, chunkMagic, sizeof(chunkMagic)) != 0 ||
+                directory[i] + chunk->chunkSize > trailer->directoryOffset)
+        {
+            munmap((void *)_data, _size);
+            throw ColumnarFileException("Invalid chunk in columnar file " + filename);
+        }
+        _chunks.push_back(chunk);
+    }
+    _numRows = trailer->numRows;
+}
+
+ColumnarReader::~ColumnarReader()
+{
+    munmap((void *)_data, _size);
+}
+
+std::string ColumnarReader::columnName(int column) const
+{
+    if(column < 0 || column >= numColumns())
+        throw ColumnarFileException("Invalid column index");
+
+    const ColumnarColumnDesc *desc = _descs[column];
+    return std::string(desc->name, strnlen(desc->name, sizeof(desc->name)));
+}
+
+COLUMNTYPE ColumnarReader::columnType(int column) const
+{
+    if(column < 0 || column >= numColumns())
+        throw ColumnarFileException("Invalid column index");
+
+    return (COLUMNTYPE)_descs[column]->type;
+}
+
+int ColumnarReader::findColumn(const std::string& name) const
+{
+    for(int i = 0; i < numColumns(); i ++)
+        if(columnName(i) == name)
+            return i;
+
+    return -1;
+}
+
+uint64_t ColumnarReader::chunkRows(int chunk) const
+{
+    if(chunk < 0 || chunk >= numChunks())
+        throw ColumnarFileException("Invalid chunk index");
+
+    return _chunks[chunk]->numRows;
+}
+
+const void *ColumnarReader::_column(int chunk, int column,
+        COLUMNTYPE type) const
+{
+    if(chunk < 0 || chunk >= numChunks() ||
+            column < 0 || column >= numColumns())
+        throw ColumnarFileException("Invalid chunk or column index");
+
+    COLUMNTYPE actualType = (COLUMNTYPE)_descs[column]->type;
+    bool compatible = actualType == type ||
+        (type == INT32 && actualType == DATE32);
+    if(!compatible)
+        throw ColumnarFileException("Column type mismatch for " + columnName(column));
+
+    const ColumnarChunkHeader *header = _chunks[chunk];
+    const char *buffer = (const char *)header + sizeof(ColumnarChunkHeader);
+    for(int i = 0; i < column; i ++)
+        buffer += alignUp(header->numRows * _descs[i]->width);
+
+    return buffer;
+}
+
+const int32_t *ColumnarReader::int32Column(int chunk, int column) const
+{
+    return (const int32_t *)_column(chunk, column, INT32);
+}
+
+const int64_t *ColumnarReader::int64Column(int chunk, int column) const
+{
+    return (const int64_t *)_column(chunk, column, INT64);
+}
+
+const double *ColumnarReader::float64Column(int chunk, int column) const
+{
+    return (const double *)_column(chunk, column, FLOAT64);
+}
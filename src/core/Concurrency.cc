@@ -0,0 +1,278 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include "Concurrency.h"
+
+namespace
+{
+    // Shared state of the worker threads started by runAll
+    struct WorkerContext
+    {
+        std::vector<Concurrency::Runnable *> *jobs;
+        volatile long nextJob;
+        pthread_mutex_t errorLock;
+        bool hasError;
+        std::string errorMessage;
+    };
+
+    void *threadMain(void *arg)
+    {
+        Concurrency::Runnable *runnable = static_cast<Concurrency::Runnable *>(arg);
+        runnable->run();
+
+        return NULL;
+    }
+
+    void *workerMain(void *arg)
+    {
+        WorkerContext *context = static_cast<WorkerContext *>(arg);
+        long numJobs = (long)context->jobs->size();
+
+        while(true)
+        {
+            long jobIndex = __sync_fetch_and_add(&context->nextJob, 1);
+            if(jobIndex >= numJobs)
+                break;
+
+            try
+            {
+                (*context->jobs)[jobIndex]->run();
+            }
+            catch(std::exception& e)
+            {
+                pthread_mutex_lock(&context->errorLock);
+                if(!context->hasError)
+                {
+                    context->hasError = true;
+                    context->errorMessage = e.what();
+                }
+                pthread_mutex_unlock(&context->errorLock);
+            }
+        }
+
+        return NULL;
+    }
+}
+
+int Concurrency::hardwareConcurrency()
+{
+    long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return numProcessors < 1 ? 1 : (int)numProcessors;
+}
+
+void Concurrency::runAll(std::vector<Runnable *>& jobs, int numThreads)
+{
+    WorkerContext context;
+    context.jobs = &jobs;
+    context.nextJob = 0;
+    context.hasError = false;
+    pthread_mutex_init(&context.errorLock, NULL);
+
+    if(numThreads > (int)jobs.size())
+        numThreads = (int)jobs.size();
+
+    // The calling thread works as well, so only
+    // numThreads - 1 extra threads are needed
+    std::vector<pthread_t> threads;
+    for(int i = 1; i < numThreads; i ++)
+    {
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, workerMain, &context) != 0)
+            break;
+
+        threads.push_back(thread);
+    }
+
+    workerMain(&context);
+
+    for(int i = 0; i < (int)threads.size(); i ++)
+        pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&context.errorLock);
+
+    if(context.hasError)
+        throw ConcurrencyException(context.errorMessage);
+}
+
+//////////////////////////////////////////
+// Definition of the class Thread
+//////////////////////////////////////////
+Concurrency::Thread::Thread(Runnable& runnable):
+    _joinable(false)
+{
+    if(pthread_create(&_thread, NULL, threadMain, &runnable) != 0)
+        throw ConcurrencyException("Fail to create a thread");
+
+    _joinable = true;
+}
+
+Concurrency::Thread::~Thread()
+{
+    join();
+}
+
+void Concurrency::Thread::join()
+{
+    if(_joinable)
+    {
+        pthread_join(_thread, NULL);
+        _joinable = false;
+    }
+}
+
+//////////////////////////////////////////
+// Definition of the class TaskGraph
+//////////////////////////////////////////
+Concurrency::TaskGraph::TaskGraph():
+    _numUnfinished(0), _hasError(false)
+{
+    pthread_mutex_init(&_lock, NULL);
+    pthread_cond_init(&_changed, NULL);
+}
+
+Concurrency::TaskGraph::~TaskGraph()
+{
+    pthread_cond_destroy(&_changed);
+    pthread_mutex_destroy(&_lock);
+}
+
+Concurrency::TaskGraph::TaskId Concurrency::TaskGraph::addTask(Runnable& task)
+{
+    return addTask(task, std::vector<TaskId>());
+}
+
+Concurrency::TaskGraph::TaskId Concurrency::TaskGraph::addTask(Runnable& task,
+        TaskId dependency)
+{
+    return addTask(task, std::vector<TaskId>(1, dependency));
+}
+
+Concurrency::TaskGraph::TaskId Concurrency::TaskGraph::addTask(Runnable& task,
+        const std::vector<TaskId>& dependencies)
+{
+    pthread_mutex_lock(&_lock);
+
+    TaskId id = (TaskId)_nodes.size();
+    Node node;
+    node.task = &task;
+    node.numPendingDependencies = 0;
+    node.finished = false;
+
+    for(int i = 0; i < (int)dependencies.size(); i ++)
+    {
+        TaskId dependency = dependencies[i];
+        if(dependency < 0 || dependency >= id)
+        {
+            pthread_mutex_unlock(&_lock);
+            throw ConcurrencyException("Unknown task in the dependencies");
+        }
+
+        if(!_nodes[dependency].finished)
+        {
+            _nodes[dependency].dependents.push_back(id);
+            node.numPendingDependencies ++;
+        }
+    }
+
+    _nodes.push_back(node);
+    _numUnfinished ++;
+    if(node.numPendingDependencies == 0)
+    {
+        _readyTasks.push_back(id);
+        pthread_cond_signal(&_changed);
+    }
+
+    pthread_mutex_unlock(&_lock);
+
+    return id;
+}
+
+void *Concurrency::TaskGraph::_workerMain(void *arg)
+{
+    static_cast<TaskGraph *>(arg)->_work();
+
+    return NULL;
+}
+
+void Concurrency::TaskGraph::_work()
+{
+    pthread_mutex_lock(&_lock);
+    while(true)
+    {
+        while(!_hasError && _numUnfinished > 0 && _readyTasks.empty())
+            pthread_cond_wait(&_changed, &_lock);
+
+        if(_hasError || _numUnfinished == 0)
+            break;
+
+        TaskId id = _readyTasks.front();
+        _readyTasks.pop_front();
+        Runnable *task = _nodes[id].task;
+        pthread_mutex_unlock(&_lock);
+
+        std::string errorMessage;
+        bool failed = false;
+        try
+        {
+            task->run();
+        }
+        catch(std::exception& e)
+        {
+            failed = true;
+            errorMessage = e.what();
+        }
+
+        pthread_mutex_lock(&_lock);
+        if(failed && !_hasError)
+        {
+            _hasError = true;
+            _errorMessage = errorMessage;
+        }
+
+        // Release the dependents whose last dependency this was
+        Node& node = _nodes[id];
+        node.finished = true;
+        _numUnfinished --;
+        for(int i = 0; i < (int)node.dependents.size(); i ++)
+        {
+            if(-- _nodes[node.dependents[i]].numPendingDependencies == 0)
+                _readyTasks.push_back(node.dependents[i]);
+        }
+
+        pthread_cond_broadcast(&_changed);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+void Concurrency::TaskGraph::run(int numThreads)
+{
+    std::vector<pthread_t> threads;
+    for(int i = 1; i < numThreads; i ++)
+    {
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, _workerMain, this) != 0)
+            break;
+
+        threads.push_back(thread);
+    }
+
+    _work();
+
+    for(int i = 0; i < (int)threads.size(); i ++)
+        pthread_join(threads[i], NULL);
+
+    // Forget the finished graph so that it can be reused
+    pthread_mutex_lock(&_lock);
+    bool hasError = _hasError;
+    std::string errorMessage = _errorMessage;
+    _nodes.clear();
+    _readyTasks.clear();
+    _numUnfinished = 0;
+    _hasError = false;
+    _errorMessage.clear();
+    pthread_mutex_unlock(&_lock);
+
+    if(hasError)
+        throw ConcurrencyException(errorMessage);
+}
@@ -0,0 +1,405 @@
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <unistd.h>
+
+#include "CurveQuery.h"
+#include "Concurrency.h"
+#include "Profiler.h"
+#include "Trace.h"
+
+namespace
+{
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' ||
+            c == '\t' || c == '\v' || c == '\f';
+    }
+
+    inline bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // (julian day number, position in the chunk) used to sort
+    // the query dates without comparing Date objects
+    typedef std::pair<unsigned long, int> DateKey;
+
+    // Parse the query dates in [begin, end), resolve them with
+    // one sorted sweep, and append the results on the curve or
+    // extrapolated in input order
+    void evaluateChunk(const YieldCurveInstance& instYC,
+            YieldCurveInstance::EXTRAPOLATION extrapolation,
+            const char *begin, const char *end,
+            std::vector<CurveQueryResult>& results)
+    {
+        std::vector<Date> dates;
+        const char *curr = begin;
+
+        while(curr != end)
+        {
+            while(curr != end && isSpace(*curr))
+                curr ++;
+
+            const char *tokenBegin = curr;
+            while(curr != end && !isSpace(*curr))
+                curr ++;
+
+            if(tokenBegin == curr)
+                break;
+
+            Date date;
+            if(StreamingCurveQuery::parseDate(tokenBegin, curr, date))
+                dates.push_back(WorkDate(date));
+        }
+
+        int numDates = (int)dates.size();
+        std::vector<DateKey> keys(numDates);
+        for(int i = 0; i < numDates; i ++)
+            keys[i] = DateKey(dates[i].get().day_number(), i);
+
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<Date> sortedDates;
+        sortedDates.reserve(numDates);
+        for(int i = 0; i < numDates; i ++)
+            sortedDates.push_back(dates[keys[i].second]);
+
+        std::vector<double> sortedValues, sortedDfs;
+        std::vector<YieldCurveInstance::LOOKUPSTATUS> sortedStatus;
+        {
+            PROFILE_TIMER(lookupTimer, "curveLookupBatch");
+            TRACE_SCOPE_ARG("curveLookupBatch", "dates", numDates);
+            instYC.lookupSorted(sortedDates, extrapolation, sortedValues,
+                    sortedDfs, sortedStatus);
+            lookupTimer.addItems(numDates);
+        }
+        PROFILE_COUNT("curveLookups", numDates);
+
+        // Scatter the sorted results back to the input order
+        std::vector<double> values(numDates), dfs(numDates);
+        std::vector<YieldCurveInstance::LOOKUPSTATUS> status(numDates);
+        for(int i = 0; i < numDates; i ++)
+        {
+            int pos = keys[i].second;
+            values[pos] = sortedValues[i];
+            dfs[pos] = sortedDfs[i];
+            status[pos] = sortedStatus[i];
+        }
+
+        results.reserve(results.size() + numDates);
+        for(int i = 0; i < numDates; i ++)
+            if(status[i] != YieldCurveInstance::OUTOFRANGE)
+                results.push_back(CurveQueryResult(dates[i], dfs[i], values[i]));
+    }
+
+    // Unit of work passed between the stages of the pipeline,
+    // a NULL batch marks the end of the stream
+    struct QueryBatch
+    {
+        std::vector<char> text;
+        std::vector<CurveQueryResult> results;
+    };
+
+    typedef Concurrency::BoundedSPSCQueue<QueryBatch *> BatchQueue;
+
+    // Reader stage: fill free batches with whole tokens from
+    // the file, and deal them out to the evaluators in turn
+    class StreamReader : public Concurrency::Runnable
+    {
+        public:
+            StreamReader(int fd, bool skipHeader, size_t batchBytes,
+                    BatchQueue& freeQueue, std::vector<BatchQueue *>& evalQueues):
+                failed(false), _fd(fd), _skipHeader(skipHeader),
+                _batchBytes(batchBytes), _freeQueue(freeQueue),
+                _evalQueues(evalQueues){};
+
+            virtual void run();
+
+            bool failed;
+
+        private:
+            int _fd;
+            bool _skipHeader;
+            size_t _batchBytes;
+            BatchQueue& _freeQueue;
+            std::vector<BatchQueue *>& _evalQueues;
+    };
+
+    // Evaluator stage: resolve the batches of one input queue
+    class StreamEvaluator : public Concurrency::Runnable
+    {
+        public:
+            StreamEvaluator(const YieldCurveInstance& instYC,
+                    YieldCurveInstance::EXTRAPOLATION extrapolation,
+                    BatchQueue& inQueue, BatchQueue& outQueue):
+                failed(false), _instYC(instYC),
+                _extrapolation(extrapolation), _inQueue(inQueue),
+                _outQueue(outQueue){};
+
+            virtual void run();
+
+            bool failed;
+            std::string errorMessage;
+
+        private:
+            const YieldCurveInstance& _instYC;
+            YieldCurveInstance::EXTRAPOLATION _extrapolation;
+            BatchQueue& _inQueue;
+            BatchQueue& _outQueue;
+    };
+}
+
+void StreamReader::run()
+{
+    std::vector<char> leftover;
+    bool endOfFile = false;
+    bool inHeader = _skipHeader;
+    size_t numBatches = 0;
+
+    while(!endOfFile)
+    {
+        QueryBatch *batch = _freeQueue.pop();
+        std::vector<char>& text = batch->text;
+        text.swap(leftover);
+        leftover.clear();
+
+        // Fill the batch, and keep reading past the limit only
+        // when it holds no whitespace to cut at
+        size_t size = text.size();
+        text.resize(std::max(_batchBytes, size + 1));
+        while(!endOfFile)
+        {
+            if(size == text.size())
+            {
+                if(std::find_if(text.begin(), text.end(), isSpace) != text.end())
+                    break;
+                text.resize(text.size() * 2);
+            }
+
+            ssize_t numRead = read(_fd, &text[size], text.size() - size);
+            if(numRead < 0 && errno == EINTR)
+                continue;
+
+            if(numRead <= 0)
+            {
+                failed = numRead < 0;
+                endOfFile = true;
+            }
+            else
+            {
+                size += numRead;
+            }
+        }
+        text.resize(size);
+
+        if(inHeader)
+        {
+            std::vector<char>::iterator lineEnd =
+                std::find(text.begin(), text.end(), '\n');
+            if(lineEnd != text.end())
+                inHeader = false;
+            text.erase(text.begin(), lineEnd);
+        }
+
+        // Move the last, possibly partial, token to the next batch
+        if(!endOfFile)
+        {
+            std::vector<char>::reverse_iterator lastSpace =
+                std::find_if(text.rbegin(), text.rend(), isSpace);
+            leftover.assign(lastSpace.base(), text.end());
+            text.erase(lastSpace.base(), text.end());
+        }
+
+        _evalQueues[numBatches % _evalQueues.size()]->push(batch);
+        numBatches ++;
+    }
+
+    for(size_t i = 0; i < _evalQueues.size(); i ++)
+        _evalQueues[(numBatches + i) % _evalQueues.size()]->push(NULL);
+}
+
+void StreamEvaluator::run()
+{
+    while(true)
+    {
+        QueryBatch *batch = _inQueue.pop();
+        if(batch == NULL)
+        {
+            _outQueue.push(NULL);
+            break;
+        }
+
+        batch->results.clear();
+        try
+        {
+            if(!batch->text.empty())
+                evaluateChunk(_instYC, _extrapolation, &batch->text[0],
+                        &batch->text[0] + batch->text.size(), batch->results);
+        }
+        catch(std::exception& e)
+        {
+            // Keep the pipeline flowing, the error is
+            // reported after all the stages are joined
+            if(!failed)
+                errorMessage = e.what();
+            failed = true;
+            batch->results.clear();
+        }
+        _outQueue.push(batch);
+    }
+}
+
+//////////////////////////////////////////
+// Definition of the class StreamingCurveQuery
+//////////////////////////////////////////
+StreamingCurveQuery::StreamingCurveQuery(const YieldCurveInstance& instYC,
+        int numEvaluators, size_t batchBytes,
+        YieldCurveInstance::EXTRAPOLATION extrapolation):
+    _instYC(instYC), _numEvaluators(numEvaluators < 1 ? 1 : numEvaluators),
+    _batchBytes(batchBytes < 64 ? 64 : batchBytes),
+    _extrapolation(extrapolation)
+{
+    _instYC.solveAll();
+}
+
+StreamingCurveQuery::~StreamingCurveQuery()
+{
+}
+
+void StreamingCurveQuery::run(int fd, bool skipHeader,
+        CurveQuerySink& sink) const
+{
+    // Two batches per evaluator keeps every evaluator busy
+    // while the reader and the writer work on the others
+    int numBatches = 2 * _numEvaluators + 2;
+    std::vector<QueryBatch> batches(numBatches);
+
+    // No queue can ever hold more than all the batches plus the
+    // end markers, so only the free queue and the input queues of
+    // the evaluators ever wait
+    BatchQueue freeQueue(numBatches);
+    for(int i = 0; i < numBatches; i ++)
+        freeQueue.push(&batches[i]);
+
+    std::vector<BatchQueue *> evalQueues, outQueues;
+    for(int i = 0; i < _numEvaluators; i ++)
+    {
+        evalQueues.push_back(new BatchQueue(numBatches + 1));
+        outQueues.push_back(new BatchQueue(numBatches + 1));
+    }
+
+    StreamReader reader(fd, skipHeader, _batchBytes, freeQueue, evalQueues);
+    std::vector<StreamEvaluator *> evaluators;
+    for(int i = 0; i < _numEvaluators; i ++)
+        evaluators.push_back(new StreamEvaluator(_instYC, _extrapolation,
+                    *evalQueues[i], *outQueues[i]));
+
+    std::string sinkError;
+    bool sinkFailed = false;
+    {
+        Concurrency::Thread readerThread(reader);
+        std::vector<Concurrency::Thread *> evaluatorThreads;
+        for(int i = 0; i < _numEvaluators; i ++)
+            evaluatorThreads.push_back(new Concurrency::Thread(*evaluators[i]));
+
+        // Writer stage: collect the batches in the order they
+        // were dealt out and recycle them
+        size_t endQueue = 0;
+        for(size_t i = 0; ; i ++)
+        {
+            QueryBatch *batch = outQueues[i % _numEvaluators]->pop();
+            if(batch == NULL)
+            {
+                endQueue = i % _numEvaluators;
+                break;
+            }
+
+            if(!sinkFailed)
+            {
+                try
+                {
+                    sink.consume(batch->results);
+                }
+                catch(std::exception& e)
+                {
+                    sinkFailed = true;
+                    sinkError = e.what();
+                }
+            }
+            freeQueue.push(batch);
+        }
+
+        for(int i = 0; i < _numEvaluators; i ++)
+        {
+            // Drain the end markers of the other evaluators
+            if(i != (int)endQueue)
+                outQueues[i]->pop();
+            evaluatorThreads[i]->join();
+            delete evaluatorThreads[i];
+        }
+        readerThread.join();
+    }
+
+    std::string errorMessage;
+    if(reader.failed)
+        errorMessage = "Fail to read the query input";
+    for(int i = 0; i < _numEvaluators; i ++)
+    {
+        if(evaluators[i]->failed && errorMessage.empty())
+            errorMessage = evaluators[i]->errorMessage;
+        delete evaluators[i];
+        delete evalQueues[i];
+        delete outQueues[i];
+    }
+    if(sinkFailed && errorMessage.empty())
+        errorMessage = sinkError;
+
+    if(!errorMessage.empty())
+        throw YieldCurveException(errorMessage);
+}
+
+bool StreamingCurveQuery::parseDate(const char *begin, const char *end,
+        Date& date)
+{
+    try
+    {
+        // Fast path for yyyy/mm/dd and yyyy-mm-dd
+        long length = end - begin;
+        if(length >= 8 && length <= 10 &&
+                isDigit(begin[0]) && isDigit(begin[1]) &&
+                isDigit(begin[2]) && isDigit(begin[3]) &&
+                (begin[4] == '/' || begin[4] == '-'))
+        {
+            const char *curr = begin + 5;
+            int month = 0, day = 0;
+            while(curr != end && isDigit(*curr))
+                month = month * 10 + (*curr ++ - '0');
+
+            if(curr != end && *curr == begin[4] &&
+                    curr - begin >= 6 && curr - begin <= 7)
+            {
+                const char *dayBegin = ++ curr;
+                while(curr != end && isDigit(*curr))
+                    day = day * 10 + (*curr ++ - '0');
+
+                if(curr == end && curr - dayBegin >= 1 &&
+                        curr - dayBegin <= 2)
+                {
+                    int year = (begin[0] - '0') * 1000 + (begin[1] - '0') * 100 +
+                        (begin[2] - '0') * 10 + (begin[3] - '0');
+                    date = Date(boost::gregorian::date(year, month, day));
+                    return true;
+                }
+            }
+        }
+
+        date = Date(std::string(begin, end));
+        return !date.get().is_special();
+    }
+    catch(std::exception& e)
+    {
+        return false;
+    }
+}
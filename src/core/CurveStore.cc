@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CurveStore.h"
+#include "ColumnarFile.h"
+
+namespace
+{
+    const char directoryMagic[8] = {'Y', 'C', 'S', 'T', 'O', 'R', 'D', 'R'};
+    const char snapshotMagic[8] = {'Y', 'C', 'S', 'T', 'O', 'R', 'S', 'N'};
+    const uint32_t formatVersion = 1;
+
+    inline uint64_t alignUp(uint64_t size)
+    {
+        return (size + Columnar::alignment - 1) / Columnar::alignment *
+            Columnar::alignment;
+    }
+
+    // The offsets of the arrays of a curve from its first one
+    inline uint64_t valuesOffset(uint32_t numPoints)
+    {
+        return alignUp(numPoints * sizeof(int32_t));
+    }
+
+    inline uint64_t deltaTsOffset(uint32_t numPoints)
+    {
+        return valuesOffset(numPoints) + alignUp(numPoints * sizeof(double));
+    }
+
+    inline uint64_t curveSize(uint32_t numPoints)
+    {
+        return deltaTsOffset(numPoints) + alignUp(numPoints * sizeof(double));
+    }
+
+    std::string directoryName(const std::string& storeName)
+    {
+        if(storeName.empty() || storeName.size() > 200 ||
+                storeName.find('/') != std::string::npos)
+            throw CurveStoreException("Invalid curve store name " + storeName);
+
+        return "/" + storeName;
+    }
+
+    std::string snapshotName(const std::string& storeName, uint64_t version)
+    {
+        std::ostringstream oss;
+        oss << directoryName(storeName) << "." << version;
+        return oss.str();
+    }
+}
+
+//////////////////////////////////////////
+// Definition of the class CurveStoreWriter
+//////////////////////////////////////////
+CurveStoreWriter::CurveStoreWriter(const std::string& storeName):
+    _storeName(storeName), _directory(NULL)
+{
+    std::string name = directoryName(storeName);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0)
+        throw CurveStoreException("Cannot open the curve store " + storeName);
+
+    struct stat segStat;
+    if(fstat(fd, &segStat) != 0 || (segStat.st_size == 0 &&
+                ftruncate(fd, sizeof(CurveStoreDirectory)) != 0))
+    {
+        ::close(fd);
+        throw CurveStoreException("Cannot create the curve store " + storeName);
+    }
+
+    void *data = mmap(NULL, sizeof(CurveStoreDirectory),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        throw CurveStoreException("Cannot map the curve store " + storeName);
+    _directory = (CurveStoreDirectory *)data;
+
+    // A new segment is zero-filled
+    if(segStat.st_size == 0)
+    {
+        memcpy(_directory->magic, directoryMagic, sizeof(directoryMagic));
+        _directory->formatVersion = formatVersion;
+    }
+    else if(memcmp(_directory->magic, directoryMagic,
+                sizeof(directoryMagic)) != 0 ||
+            _directory->formatVersion != formatVersion)
+    {
+        munmap(_directory, sizeof(CurveStoreDirectory));
+        throw CurveStoreException("Invalid curve store " + storeName);
+    }
+}
+
+CurveStoreWriter::~CurveStoreWriter()
+{
+    munmap(_directory, sizeof(CurveStoreDirectory));
+}
+
+void CurveStoreWriter::add(const std::string& curveName,
+        const YieldCurveInstance& curve)
+{
+    if(curveName.empty() || curveName.size() >= sizeof(CurveStoreEntry().name))
+        throw CurveStoreException("Invalid curve name " + curveName);
+
+    curve.solveAll();
+
+    Curve& stored = _curves[curveName];
+    stored.name = curveName;
+    stored.type = curve.curveType();
+    stored.compoundFreq = curve.compoundFreq();
+    stored.startDate = curve.startDate();
+
+    // A curve of another store is copied as it is mapped
+    const CurvePointArrays& view = curve._view;
+    if(view.dates != NULL)
+    {
+        stored.dates.assign(view.dates, view.dates + view.numPoints);
+        stored.values.assign(view.values, view.values + view.numPoints);
+        stored.deltaTs.assign(view.deltaTs, view.deltaTs + view.numPoints);
+        return;
+    }
+
+    stored.dates.resize(curve._curveData.size());
+    stored.values.resize(curve._curveData.size());
+    stored.deltaTs.resize(curve._curveData.size());
+
+    for(int i = 0; i < (int)curve._curveData.size(); i ++)
+    {
+        const CurvePoint_t& point = curve._curveData[i];
+        stored.dates[i] = Columnar::toDate32(point.date);
+        stored.values[i] = point.value;
+        stored.deltaTs[i] = point.deltaT;
+    }
+}
+
+uint64_t CurveStoreWriter::publish()
+{
+    uint64_t previous = _directory->version;
+    uint64_t version = previous + 1;
+
+    uint64_t size = alignUp(sizeof(CurveStoreHeader) +
+            _curves.size() * sizeof(CurveStoreEntry));
+    std::map<std::string, Curve>::const_iterator iter;
+    for(iter = _curves.begin(); iter != _curves.end(); iter ++)
+        size += curveSize((uint32_t)iter->second.dates.size());
+
+    std::string name = snapshotName(_storeName, version);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if(fd < 0)
+        throw CurveStoreException("Cannot create the curve store snapshot " + name);
+
+    if(ftruncate(fd, size) != 0)
+    {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw CurveStoreException("Cannot size the curve store snapshot " + name);
+    }
+
+    void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapped == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        throw CurveStoreException("Cannot map the curve store snapshot " + name);
+    }
+    char *data = (char *)mapped;
+
+    CurveStoreHeader *header = (CurveStoreHeader *)data;
+    memcpy(header->magic, snapshotMagic, sizeof(snapshotMagic));
+    header->formatVersion = formatVersion;
+    header->numCurves = (uint32_t)_curves.size();
+    header->version = version;
+    header->size = size;
+
+    CurveStoreEntry *entry = (CurveStoreEntry *)(data + sizeof(CurveStoreHeader));
+    uint64_t offset = alignUp(sizeof(CurveStoreHeader) +
+            _curves.size() * sizeof(CurveStoreEntry));
+    for(iter = _curves.begin(); iter != _curves.end(); iter ++, entry ++)
+    {
+        const Curve& curve = iter->second;
+        uint32_t numPoints = (uint32_t)curve.dates.size();
+
+        strncpy(entry->name, curve.name.c_str(), sizeof(entry->name) - 1);
+        entry->type = curve.type;
+        entry->startDate = Columnar::toDate32(curve.startDate);
+        entry->numPoints = numPoints;
+        entry->compoundFreq = curve.compoundFreq;
+        entry->offset = offset;
+
+        char *arrays = data + offset;
+        if(numPoints > 0)
+        {
+            memcpy(arrays, &curve.dates[0], numPoints * sizeof(int32_t));
+            memcpy(arrays + valuesOffset(numPoints), &curve.values[0],
+                    numPoints * sizeof(double));
+            memcpy(arrays + deltaTsOffset(numPoints), &curve.deltaTs[0],
+                    numPoints * sizeof(double));
+        }
+        offset += curveSize(numPoints);
+    }
+
+    munmap(mapped, size);
+
+    // The snapshot is complete before readers can see its version
+    __sync_synchronize();
+    _directory->version = version;
+
+    // The readers still attached to it keep their mapping
+    if(previous > 0)
+        shm_unlink(snapshotName(_storeName, previous).c_str());
+
+    return version;
+}
+
+void CurveStoreWriter::remove(const std::string& storeName)
+{
+    std::string name = directoryName(storeName);
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+        return;
+
+    struct stat segStat;
+    if(fstat(fd, &segStat) == 0 &&
+            segStat.st_size >= (off_t)sizeof(CurveStoreDirectory))
+    {
+        void *data = mmap(NULL, sizeof(CurveStoreDirectory), PROT_READ,
+                MAP_SHARED, fd, 0);
+        if(data != MAP_FAILED)
+        {
+            uint64_t version = ((const CurveStoreDirectory *)data)->version;
+            if(version > 0)
+                shm_unlink(snapshotName(storeName, version).c_str());
+            munmap(data, sizeof(CurveStoreDirectory));
+        }
+    }
+    ::close(fd);
+
+    shm_unlink(name.c_str());
+}
+
+//////////////////////////////////////////
+// Definition of the class CurveStoreReader
+//////////////////////////////////////////
+CurveStoreReader::CurveStoreReader(const std::string& storeName):
+    _storeName(storeName), _directory(NULL), _version(0),
+    _snapshot(NULL), _snapshotSize(0)
+{
+    std::string name = directoryName(storeName);
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+        throw CurveStoreException("Cannot open the curve store " + storeName);
+
+    struct stat segStat;
+    if(fstat(fd, &segStat) != 0 ||
+            segStat.st_size < (off_t)sizeof(CurveStoreDirectory))
+    {
+        ::close(fd);
+        throw CurveStoreException("Invalid curve store " + storeName);
+    }
+
+    void *data = mmap(NULL, sizeof(CurveStoreDirectory), PROT_READ,
+            MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        throw CurveStoreException("Cannot map the curve store " + storeName);
+    _directory = (const CurveStoreDirectory *)data;
+
+    if(memcmp(_directory->magic, directoryMagic, sizeof(directoryMagic)) != 0 ||
+            _directory->formatVersion != formatVersion)
+    {
+        munmap((void *)_directory, sizeof(CurveStoreDirectory));
+        throw CurveStoreException("Invalid curve store " + storeName);
+    }
+
+    try
+    {
+        _version = _load(_names, _curves, _snapshot, _snapshotSize);
+    }
+    catch(CurveStoreException& e)
+    {
+        munmap((void *)_directory, sizeof(CurveStoreDirectory));
+        throw;
+    }
+}
+
+CurveStoreReader::~CurveStoreReader()
+{
+    _clear();
+    munmap((void *)_directory, sizeof(CurveStoreDirectory));
+}
+
+uint64_t CurveStoreReader::_load(std::vector<std::string>& names,
+        std::vector<YieldCurveInstance *>& curves, void *& snapshot,
+        size_t& snapshotSize) const
+{
+    int fd = -1;
+    uint64_t version = 0;
+
+    // A snapshot is unlinked once the next one is current: if it
+    // is gone, the directory has moved on and the current one is
+    // opened instead
+    while(fd < 0)
+    {
+        version = _directory->version;
+        if(version == 0)
+            throw CurveStoreException("Nothing published in the curve store " +
+                    _storeName);
+
+        fd = shm_open(snapshotName(_storeName, version).c_str(), O_RDONLY, 0);
+        if(fd < 0 && (errno != ENOENT || _directory->version == version))
+            throw CurveStoreException("Cannot open the curve store snapshot " +
+                    snapshotName(_storeName, version));
+    }
+
+    struct stat segStat;
+    if(fstat(fd, &segStat) != 0 ||
+            segStat.st_size < (off_t)sizeof(CurveStoreHeader))
+    {
+        ::close(fd);
+        throw CurveStoreException("Invalid curve store snapshot " +
+                snapshotName(_storeName, version));
+    }
+
+    size_t size = segStat.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        throw CurveStoreException("Cannot map the curve store snapshot " +
+                snapshotName(_storeName, version));
+
+    const CurveStoreHeader *header = (const CurveStoreHeader *)data;
+    bool valid = memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) == 0 &&
+        header->formatVersion == formatVersion && header->version == version &&
+        header->size == size && sizeof(CurveStoreHeader) +
+            header->numCurves * sizeof(CurveStoreEntry) <= size;
+
+    const CurveStoreEntry *entries = (const CurveStoreEntry *)
+        ((const char *)data + sizeof(CurveStoreHeader));
+    for(uint32_t i = 0; valid && i < header->numCurves; i ++)
+        valid = entries[i].offset + curveSize(entries[i].numPoints) <= size &&
+            entries[i].name[sizeof(entries[i].name) - 1] == '\0' &&
+            entries[i].type <= YieldCurveDefinition::LOGDISCOUNTFACTOR;
+
+    if(!valid)
+    {
+        munmap(data, size);
+        throw CurveStoreException("Invalid curve store snapshot " +
+                snapshotName(_storeName, version));
+    }
+
+    // The points are stored final, in the order of the curve, and
+    // the curves read them where they are mapped
+    names.clear();
+    curves.clear();
+    for(uint32_t i = 0; i < header->numCurves; i ++)
+    {
+        const CurveStoreEntry& entry = entries[i];
+        const char *arrays = (const char *)data + entry.offset;
+
+        CurvePointArrays points;
+        points.numPoints = (int)entry.numPoints;
+        points.dates = (const int32_t *)arrays;
+        points.values = (const double *)(arrays +
+                valuesOffset(entry.numPoints));
+        points.deltaTs = (const double *)(arrays +
+                deltaTsOffset(entry.numPoints));
+
+        names.push_back(std::string(entry.name));
+        curves.push_back(YieldCurveInstance::createView(
+                    (YieldCurveDefinition::CURVETYPE)entry.type,
+                    entry.compoundFreq, Columnar::fromDate32(entry.startDate),
+                    points));
+    }
+
+    snapshot = data;
+    snapshotSize = size;
+    return version;
+}
+
+void CurveStoreReader::_clear()
+{
+    for(int i = 0; i < (int)_curves.size(); i ++)
+        delete _curves[i];
+
+    _names.clear();
+    _curves.clear();
+
+    if(_snapshot != NULL)
+        munmap(_snapshot, _snapshotSize);
+    _snapshot = NULL;
+    _snapshotSize = 0;
+}
+
+const YieldCurveInstance *CurveStoreReader::find(const std::string& curveName) const
+{
+    // The entries are sorted by name
+    std::vector<std::string>::const_iterator iter =
+        std::lower_bound(_names.begin(), _names.end(), curveName);
+    if(iter == _names.end() || *iter != curveName)
+        return NULL;
+
+    return _curves[iter - _names.begin()];
+}
+
+bool CurveStoreReader::isStale() const
+{
+    return _directory->version != _version;
+}
+
+bool CurveStoreReader::refresh()
+{
+    if(!isStale())
+        return false;
+
+    // _load leaves the current snapshot alone if it throws
+    std::vector<std::string> names;
+    std::vector<YieldCurveInstance *> curves;
+    void *snapshot;
+    size_t snapshotSize;
+    uint64_t version = _load(names, curves, snapshot, snapshotSize);
+
+    _clear();
+    _names.swap(names);
+    _curves.swap(curves);
+    _snapshot = snapshot;
+    _snapshotSize = snapshotSize;
+    _version = version;
+    return true;
+}
@@ -1,9 +1,23 @@
 #include <boost/regex.hpp>
 #include <boost/lexical_cast.hpp>
 #include <sstream>
+#include <cmath>
 
 #include "Date.h"
+#include "Calendar.h"
 
+namespace
+{
+    // The days of a month in the conversions of Duration
+    const double daysPerMonth = 30.42;
+    // How far from a whole month a scaled duration may be
+    const double monthTolerance = 1e-6;
+
+    inline int nearest(double value)
+    {
+        return (int)floor(value + 0.5);
+    }
+}
 
 /////////////////////////////////////////
 // Definition of the class Date
@@ -38,55 +52,37 @@ Date Date::today()
 
 Date Date::operator+(const Duration& rhs) const
 {
-    Duration::TYPE type = rhs.type();
-
-    switch(type)
+    if(rhs.type() == Duration::INVALID)
     {
-        case Duration::WEEK:
-        case Duration::DAY:
-        {
-            boost::gregorian::date_duration duration(
-                    (long)(rhs.getDuration(Duration::DAY)));
-            Date newDay(this->_date + duration);
-            return newDay;
-        }
-        case Duration::YEAR:
-        case Duration::MONTH:
-        case Duration::QUARTER:
-        {
-            boost::gregorian::months duration(
-                    (int)(rhs.getDuration(Duration::MONTH)));
+        std::string errorMessage("Invalid Duration");
+        throw DateException(errorMessage);
+    }
 
-            Date newDay(this->_date + duration);
+    return *this + rhs.tenor();
+}
 
-            boost::gregorian::date newRawDay(newDay.get());
-             
-            // Considering the day
-            // in the month, if the resulting day is
-            // larger then the day before add, then
-            // modify the resulting day to the day 
-            // before add
+Date Date::operator+(const Tenor& rhs) const
+{
+    boost::gregorian::date newRawDay(_date);
 
-            int diff;
-            if((diff = _date.day() - newRawDay.day()) < 0)
-            {
-                boost::gregorian::date modifiedRawDate =
-                    newRawDay - boost::gregorian::date_duration(-diff);
-                
-                Date modifiedDate(modifiedRawDate);
-                return modifiedDate;
-            }
-            else
-            {
-                return newDay;
-            }
-        }
-        default:
-        {
-            std::string errorMessage("Invalid Duration");
-            throw DateException(errorMessage);
-        }
+    if(rhs.months() != 0)
+    {
+        newRawDay = _date + boost::gregorian::months(rhs.months());
+
+        // Considering the day
+        // in the month, if the resulting day is
+        // larger then the day before add, then
+        // modify the resulting day to the day 
+        // before add
+        int diff;
+        if((diff = _date.day() - newRawDay.day()) < 0)
+            newRawDay = newRawDay - boost::gregorian::date_duration(-diff);
     }
+
+    if(rhs.days() != 0)
+        newRawDay = newRawDay + boost::gregorian::date_duration(rhs.days());
+
+    return Date(newRawDay);
 }
 
 Duration Date::operator-(const Date& rhs) const
@@ -138,7 +134,7 @@ bool Date::operator==(const Date& rhs) const
 /////////////////////////////////////////
 // Definition of Date Helper functions
 //////////////////////////////////////////
-double normDiffDate(Date& d1, Date& d2, Date::TYPE type)
+double normDiffDate(const Date& d1, const Date& d2, Date::TYPE type)
 {
     Duration duration = d1 < d2 ? d2 - d1 : d1 - d2;
 
@@ -230,12 +226,56 @@ Duration::Duration(std::string& durStr)
         std::string errorMsg = "Fail to read the duration value from " + durStr;
         throw DurationException(errorMsg);
     }
+
+    _tenor = _toTenor(_duration, _type);
 }
 
 Duration::~Duration()
 {
 }
 
+Tenor Duration::_toTenor(double duration, Duration::TYPE type)
+{
+    double months;
+    switch(type)
+    {
+        case Duration::DAY:
+            return Tenor(0, (int)duration);
+        case Duration::WEEK:
+            return Tenor(0, (int)(duration * 7.0));
+        case Duration::MONTH:
+            months = duration;
+            break;
+        case Duration::QUARTER:
+            months = duration * 3.0;
+            break;
+        case Duration::YEAR:
+            months = duration * 12.0;
+            break;
+        default:
+            return Tenor();
+    }
+
+    int wholeMonths = nearest(months);
+    if(fabs(months - wholeMonths) < monthTolerance)
+        return Tenor(wholeMonths, 0);
+
+    wholeMonths = (int)floor(months);
+    return Tenor(wholeMonths, nearest((months - wholeMonths) * daysPerMonth));
+}
+
+int Duration::periods(const Duration& period) const
+{
+    Tenor total = tenor();
+    Tenor step = period.tenor();
+    if(total.days() == 0 && step.days() == 0 && step.months() > 0)
+        return total.months() / step.months();
+    if(total.months() == 0 && step.months() == 0 && step.days() > 0)
+        return total.days() / step.days();
+
+    return (int)floor(*this / period + monthTolerance);
+}
+
 bool Duration::isValidDuration(std::string& durStr)
 {
     static const boost::regex format("^(ON)|(O/N)|(TN)|(T/N)|"
@@ -456,22 +496,6 @@ Duration Duration::operator-(const Duration& rhs) const
     return newDuration;
 }
 
-bool Duration::operator==(const Duration& rhs) const
-{
-    double time1 = this->getDuration(this->type());
-    double time2 = rhs.getDuration(this->type());
-
-    return time1 == time2;
-}
-
-bool Duration::operator<(const Duration& rhs) const
-{
-    double time1 = this->getDuration(_type);
-    double time2 = rhs.getDuration(_type);
-
-    return time1 < time2;
-}
-
 /////////////////////////////////////////
 // Definition of the class WorkDate
 //////////////////////////////////////////
@@ -487,9 +511,5 @@ WorkDate::~WorkDate()
 
 void WorkDate::_jumpToNearestNextWorkDay()
 {
-    using namespace boost::gregorian;
-
-    greg_weekday gw = _date.day_of_week();
-    if(gw == Saturday || gw == Sunday)
-        _date = next_weekday(_date, greg_weekday(Monday));
+    _date = Calendar::workCalendar().adjust(*this).get();
 }
@@ -0,0 +1,403 @@
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+#include "FittedCurve.h"
+#include "Schedule.h"
+
+namespace
+{
+    const int numParameters = 6;
+    // The range of the taus, in years: a tau near zero or far
+    // beyond the curve only trades a beta against another
+    const double minTau = 0.05;
+    const double maxTau = 30.0;
+
+    // An instrument of the fit, its resolved dates as year
+    // fractions
+    struct FitInstrument
+    {
+        InstrumentDefinition::TYPE type;
+        // the quote, in percent
+        double quote;
+        double maturityT;
+        // the accrual of the (last) period
+        double accrual;
+        // FRA: the start of the period
+        double startT;
+        // SWAP: the coupons before the maturity
+        std::vector<double> couponTs;
+        std::vector<double> couponAccruals;
+    };
+
+    // f(x) = (1 - exp(-x)) / x, 1 at the start of the curve
+    inline double loading(double x, double expMinusX)
+    {
+        return x < 1e-8 ? 1.0 - 0.5 * x : (1.0 - expMinusX) / x;
+    }
+
+    inline double nssZeroRate(const NSSParameters& params, double t)
+    {
+        double x1 = t / params.tau1;
+        double x2 = t / params.tau2;
+        double e1 = exp(-x1);
+        double e2 = exp(-x2);
+        double f1 = loading(x1, e1);
+        double f2 = loading(x2, e2);
+
+        return params.beta0 + params.beta1 * f1 +
+            params.beta2 * (f1 - e1) + params.beta3 * (f2 - e2);
+    }
+
+    // The taus are fitted through their logs to stay positive
+    NSSParameters toParameters(const double *x)
+    {
+        NSSParameters params;
+        params.beta0 = x[0];
+        params.beta1 = x[1];
+        params.beta2 = x[2];
+        params.beta3 = x[3];
+        params.tau1 = exp(x[4]);
+        params.tau2 = exp(x[5]);
+        return params;
+    }
+
+    // The par rate of an instrument on the curve, in percent
+    double parRate(const NSSParameters& params, const FitInstrument& instr)
+    {
+        double dfMaturity = exp(-nssZeroRate(params, instr.maturityT) *
+                instr.maturityT);
+
+        switch(instr.type)
+        {
+            case InstrumentDefinition::CASH:
+                return InstrumentPricing::cashRate(dfMaturity,
+                        instr.accrual) * 100.0;
+            case InstrumentDefinition::FRA:
+                {
+                    double dfStart = exp(-nssZeroRate(params, instr.startT) *
+                            instr.startT);
+                    return InstrumentPricing::fraRate(dfMaturity,
+                            instr.accrual, dfStart) * 100.0;
+                }
+            default:
+                {
+                    double annuity = 0.0;
+                    for(int i = 0; i < (int)instr.couponTs.size(); i ++)
+                    {
+                        double t = instr.couponTs[i];
+                        annuity += instr.couponAccruals[i] *
+                            exp(-nssZeroRate(params, t) * t);
+                    }
+                    return InstrumentPricing::swapRate(dfMaturity,
+                            instr.accrual, annuity) * 100.0;
+                }
+        }
+    }
+
+    // The residuals and their sum of squares
+    double fitResiduals(const std::vector<FitInstrument>& instrs,
+            const double *x, std::vector<double>& residuals)
+    {
+        NSSParameters params = toParameters(x);
+        residuals.resize(instrs.size());
+
+        double cost = 0.0;
+        for(int j = 0; j < (int)instrs.size(); j ++)
+        {
+            residuals[j] = parRate(params, instrs[j]) - instrs[j].quote;
+            cost += residuals[j] * residuals[j];
+        }
+
+        // A parameter set the rates cannot be priced with
+        if(cost != cost)
+            cost = HUGE_VAL;
+        return cost;
+    }
+
+    // Solve a * x = b in place by Gaussian elimination with partial
+    // pivoting, a row-major n x n; false if a is singular
+    bool solveLinear(std::vector<double>& a, std::vector<double>& b, int n)
+    {
+        for(int k = 0; k < n; k ++)
+        {
+            int pivot = k;
+            for(int i = k + 1; i < n; i ++)
+                if(fabs(a[i * n + k]) > fabs(a[pivot * n + k]))
+                    pivot = i;
+            if(fabs(a[pivot * n + k]) < 1e-300)
+                return false;
+
+            if(pivot != k)
+            {
+                for(int j = 0; j < n; j ++)
+                    std::swap(a[k * n + j], a[pivot * n + j]);
+                std::swap(b[k], b[pivot]);
+            }
+
+            for(int i = k + 1; i < n; i ++)
+            {
+                double factor = a[i * n + k] / a[k * n + k];
+                for(int j = k; j < n; j ++)
+                    a[i * n + j] -= factor * a[k * n + j];
+                b[i] -= factor * b[k];
+            }
+        }
+
+        for(int k = n - 1; k >= 0; k --)
+        {
+            double sum = b[k];
+            for(int j = k + 1; j < n; j ++)
+                sum -= a[k * n + j] * b[j];
+            b[k] = sum / a[k * n + k];
+        }
+        return true;
+    }
+}
+
+//////////////////////////////////////////
+// Definition of the class NelsonSiegelSvenssonCurve
+//////////////////////////////////////////
+NelsonSiegelSvenssonCurve::NelsonSiegelSvenssonCurve(
+        const NSSParameters& params, const Date& startDate):
+    _params(params), _startDate(startDate), _numIterations(0)
+{
+}
+
+NelsonSiegelSvenssonCurve NelsonSiegelSvenssonCurve::fit(
+        const YieldCurveDefinition& ycDef,
+        const InstrumentValues& instrVals, const Date& asOf,
+        int maxIterations)
+{
+    ycDef._checkInstrumentIds(instrVals);
+
+    // The instruments of the quotes, with the dates of bindData
+    Date today = WorkDate(asOf);
+    Schedule::Dates pillarDates = ycDef.getPillarDates(today);
+
+    int numQuotes = (int)instrVals.values.size();
+    std::vector<FitInstrument> instrs(numQuotes);
+    ResolvedInstrument resolved;
+    int shortest = 0;
+    int longest = 0;
+    for(int j = 0; j < numQuotes; j ++)
+    {
+        int instrDefIndex = ycDef._definitionIndex(instrVals.values[j].first);
+        resolveInstrument(ycDef._instrDefs[instrDefIndex], today,
+                pillarDates[instrDefIndex], ycDef._compoundFreq, resolved);
+
+        FitInstrument& instr = instrs[j];
+        instr.type = resolved.type;
+        instr.quote = instrVals.values[j].second;
+        instr.maturityT = resolved.deltaTToMaturity;
+        instr.accrual = resolved.accrual;
+        instr.startT = normDiffDate(today, resolved.startDate, Date::ACT365);
+        instr.couponAccruals = resolved.couponAccruals;
+        for(int i = 0; i < (int)resolved.couponDates.size(); i ++)
+            instr.couponTs.push_back(normDiffDate(today,
+                        resolved.couponDates[i], Date::ACT365));
+
+        if(instr.maturityT < instrs[shortest].maturityT)
+            shortest = j;
+        if(instr.maturityT > instrs[longest].maturityT)
+            longest = j;
+    }
+
+    // Start from the long quote with the short end at the short
+    // quote, the humps flat
+    double x[numParameters] = {instrs[longest].quote / 100.0,
+        (instrs[shortest].quote - instrs[longest].quote) / 100.0,
+        0.0, 0.0, log(1.0), log(5.0)};
+
+    std::vector<double> residuals;
+    std::vector<double> bumpedResiduals;
+    std::vector<double> jacobian(numQuotes * numParameters);
+    std::vector<double> normal(numParameters * numParameters);
+    std::vector<double> gradient(numParameters);
+    double cost = fitResiduals(instrs, x, residuals);
+    double lambda = 1e-3;
+    const double bump = 1e-7;
+
+    int iteration = 0;
+    for(; iteration < maxIterations; iteration ++)
+    {
+        // Forward differences of the residuals
+        for(int k = 0; k < numParameters; k ++)
+        {
+            double saved = x[k];
+            x[k] += bump;
+            fitResiduals(instrs, x, bumpedResiduals);
+            x[k] = saved;
+
+            for(int j = 0; j < numQuotes; j ++)
+                jacobian[j * numParameters + k] =
+                    (bumpedResiduals[j] - residuals[j]) / bump;
+        }
+
+        // J'J and J'r
+        for(int k = 0; k < numParameters; k ++)
+        {
+            gradient[k] = 0.0;
+            for(int j = 0; j < numQuotes; j ++)
+                gradient[k] += jacobian[j * numParameters + k] * residuals[j];
+
+            for(int l = 0; l < numParameters; l ++)
+            {
+                double sum = 0.0;
+                for(int j = 0; j < numQuotes; j ++)
+                    sum += jacobian[j * numParameters + k] *
+                        jacobian[j * numParameters + l];
+                normal[k * numParameters + l] = sum;
+            }
+        }
+
+        // A tau at a bound the gradient pushes it beyond is held
+        // there for this step
+        for(int k = 4; k < numParameters; k ++)
+        {
+            bool atMin = x[k] <= log(minTau) && gradient[k] > 0.0;
+            bool atMax = x[k] >= log(maxTau) && gradient[k] < 0.0;
+            if(!atMin && !atMax)
+                continue;
+
+            for(int l = 0; l < numParameters; l ++)
+            {
+                normal[k * numParameters + l] = 0.0;
+                normal[l * numParameters + k] = 0.0;
+            }
+            normal[k * numParameters + k] = 1.0;
+            gradient[k] = 0.0;
+        }
+
+        // Raise the damping until a step lowers the cost
+        bool improved = false;
+        double newCost = cost;
+        while(lambda < 1e12)
+        {
+            std::vector<double> damped(normal);
+            std::vector<double> step(numParameters);
+            for(int k = 0; k < numParameters; k ++)
+            {
+                damped[k * numParameters + k] +=
+                    lambda * (normal[k * numParameters + k] + 1e-12);
+                step[k] = -gradient[k];
+            }
+
+            if(solveLinear(damped, step, numParameters))
+            {
+                double trial[numParameters];
+                for(int k = 0; k < numParameters; k ++)
+                    trial[k] = x[k] + step[k];
+                for(int k = 4; k < numParameters; k ++)
+                    trial[k] = std::min(std::max(trial[k], log(minTau)),
+                            log(maxTau));
+
+                std::vector<double> trialResiduals;
+                newCost = fitResiduals(instrs, trial, trialResiduals);
+                if(newCost < cost)
+                {
+                    std::copy(trial, trial + numParameters, x);
+                    residuals.swap(trialResiduals);
+                    lambda = std::max(lambda / 10.0, 1e-12);
+                    improved = true;
+                    break;
+                }
+            }
+
+            lambda *= 10.0;
+        }
+
+        if(!improved)
+            break;
+
+        double decrease = cost - newCost;
+        cost = newCost;
+        if(decrease <= 1e-14 * (1.0 + cost))
+            break;
+    }
+
+    NelsonSiegelSvenssonCurve curve(toParameters(x), today);
+    curve._quoteResiduals = residuals;
+    curve._numIterations = iteration;
+    return curve;
+}
+
+double NelsonSiegelSvenssonCurve::zeroRate(double t) const
+{
+    return nssZeroRate(_params, t);
+}
+
+double NelsonSiegelSvenssonCurve::zeroRate(const Date& date) const
+{
+    return zeroRate(normDiffDate(_startDate, WorkDate(date), Date::ACT365));
+}
+
+double NelsonSiegelSvenssonCurve::getDf(const Date& date) const
+{
+    return df(normDiffDate(_startDate, WorkDate(date), Date::ACT365));
+}
+
+void NelsonSiegelSvenssonCurve::_yearFractions(
+        const std::vector<Date>& dates, std::vector<double>& ts) const
+{
+    ts.resize(dates.size());
+    for(int i = 0; i < (int)dates.size(); i ++)
+        ts[i] = normDiffDate(_startDate, WorkDate(dates[i]), Date::ACT365);
+}
+
+void NelsonSiegelSvenssonCurve::getZeroRates(const std::vector<Date>& dates,
+        std::vector<double>& rates) const
+{
+    std::vector<double> ts;
+    _yearFractions(dates, ts);
+
+    int numDates = (int)ts.size();
+    rates.resize(numDates);
+    const double *__restrict__ t = numDates > 0 ? &ts[0] : NULL;
+    double *__restrict__ rate = numDates > 0 ? &rates[0] : NULL;
+    NSSParameters params = _params;
+    for(int i = 0; i < numDates; i ++)
+        rate[i] = nssZeroRate(params, t[i]);
+}
+
+void NelsonSiegelSvenssonCurve::getDfs(const std::vector<Date>& dates,
+        std::vector<double>& dfs) const
+{
+    std::vector<double> ts;
+    _yearFractions(dates, ts);
+
+    int numDates = (int)ts.size();
+    dfs.resize(numDates);
+    const double *__restrict__ t = numDates > 0 ? &ts[0] : NULL;
+    double *__restrict__ df = numDates > 0 ? &dfs[0] : NULL;
+    NSSParameters params = _params;
+    for(int i = 0; i < numDates; i ++)
+        df[i] = exp(-nssZeroRate(params, t[i]) * t[i]);
+}
+
+double NelsonSiegelSvenssonCurve::residuals(const YieldCurveInstance& curve,
+        const std::vector<Date>& dates, std::vector<double>& residuals) const
+{
+    std::vector<double> rates;
+    getZeroRates(dates, rates);
+
+    int numDates = (int)dates.size();
+    residuals.resize(numDates);
+    double maxResidual = 0.0;
+    for(int i = 0; i < numDates; i ++)
+    {
+        Date workDate = WorkDate(dates[i]);
+        double t = normDiffDate(curve.startDate(), workDate, Date::ACT365);
+        if(t <= 0.0)
+        {
+            residuals[i] = 0.0;
+            continue;
+        }
+
+        double bootstrapped = -log(curve.getDf(workDate)) / t;
+        residuals[i] = (rates[i] - bootstrapped) * 100.0;
+        maxResidual = std::max(maxResidual, fabs(residuals[i]));
+    }
+
+    return maxResidual;
+}
@@ -10,20 +10,20 @@
 //////////////////////////////////////////
 // Definition of InstrumentDefinition class
 //////////////////////////////////////////
-InstrumentDefinition::InstrumentDefinition(
-        const Duration& maturity, const int index):
-    _maturity(maturity), _index(index)
-{
-}
+const Duration::TYPE InstrumentDefinition::defaultFRADurationType = Duration::MONTH;
 
-InstrumentDefinition::InstrumentDefinition(
-        const InstrumentDefinition& rhs):
-    _index(rhs._index), _maturity(rhs._maturity),
-    _type(rhs._type)
+InstrumentDefinition::InstrumentDefinition(InstrumentDefinition::TYPE type,
+        const Duration& maturity, int index):
+    _index(index), _maturity(maturity),
+    _maturityTenor(maturity.tenor()), _type(type)
 {
 }
 
-InstrumentDefinition::~InstrumentDefinition()
+InstrumentDefinition::InstrumentDefinition(const Duration& startDuration,
+        const Duration& maturity, int index):
+    _index(index), _maturity(maturity),
+    _maturityTenor(maturity.tenor()), _startDuration(startDuration),
+    _type(InstrumentDefinition::FRA)
 {
 }
 
@@ -48,7 +48,7 @@ std::string InstrumentDefinition::typeToString(
     }
 }
 
-InstrumentDefinition* InstrumentDefinition::parseString(std::string& instrDefStr)
+InstrumentDefinition InstrumentDefinition::parseString(std::string& instrDefStr)
 {
     try
     {
@@ -86,8 +86,7 @@ InstrumentDefinition* InstrumentDefinition::parseString(std::string& instrDefStr
         {
             // InstrumentDefinitionType is CASH
             Duration duration(dateStr);
-            InstrumentDefinition *instr = new CASHInstrDefinition(duration, id);
-            return instr;
+            return InstrumentDefinition(InstrumentDefinition::CASH, duration, id);
         }
         else if(boost::iequals(instrumentType, std::string("FRA")))
         {
@@ -116,7 +115,7 @@ InstrumentDefinition* InstrumentDefinition::parseString(std::string& instrDefStr
             if(boost::regex_match(startDurationStr, allDigitsFormat))
             {
                 double startDurationNum = boost::lexical_cast<double>(startDurationStr);
-                Duration startDuration(startDurationNum, FRAInstrDefinition::defaultDurationType);
+                Duration startDuration(startDurationNum, InstrumentDefinition::defaultFRADurationType);
                 tStartDuration = startDuration;
             }
             else
@@ -128,7 +127,7 @@ InstrumentDefinition* InstrumentDefinition::parseString(std::string& instrDefStr
             if(boost::regex_match(maturityStr, allDigitsFormat))
             {
                 double maturityNum = boost::lexical_cast<double>(maturityStr);
-                Duration maturity(maturityNum, FRAInstrDefinition::defaultDurationType);
+                Duration maturity(maturityNum, InstrumentDefinition::defaultFRADurationType);
                 tMaturity = maturity;
             }
             else
@@ -137,16 +136,13 @@ InstrumentDefinition* InstrumentDefinition::parseString(std::string& instrDefStr
                 tMaturity = maturity;
             }
 
-            InstrumentDefinition *instr = new FRAInstrDefinition(tStartDuration, tMaturity, id);
-            return instr;
+            return InstrumentDefinition(tStartDuration, tMaturity, id);
         }
         else if(boost::iequals(instrumentType, std::string("SWAP")))
         {
             // InstrumentType is SWAP
             Duration duration(dateStr);
-
-            InstrumentDefinition *instr = new SWAPInstrDefinition(duration, id);
-            return instr;
+            return InstrumentDefinition(InstrumentDefinition::SWAP, duration, id);
         }
         else
         {
@@ -165,111 +161,13 @@ InstrumentDefinition* InstrumentDefinition::parseString(std::string& instrDefStr
 
 }
 
-InstrumentDefinition* InstrumentDefinition::clone()
-{
-    InstrumentDefinition *newInstrDef;
-    switch(this->type())
-    {
-        case InstrumentDefinition::CASH:
-            {
-                CASHInstrDefinition* instrDef = 
-                    dynamic_cast<CASHInstrDefinition *>(this);
-
-                newInstrDef = new CASHInstrDefinition(*instrDef);
-                break;
-            }
-        case InstrumentDefinition::FRA:
-            {
-                FRAInstrDefinition* instrDef =
-                    dynamic_cast<FRAInstrDefinition *>(this);
-
-                newInstrDef = new FRAInstrDefinition(*instrDef);
-                break;
-            }
-        case InstrumentDefinition::SWAP:
-            {
-                SWAPInstrDefinition* instrDef =
-                    dynamic_cast<SWAPInstrDefinition *>(this);
-
-                newInstrDef = new SWAPInstrDefinition(*instrDef);
-                break;
-            }
-        case InstrumentDefinition::FAKE:
-            {
-                FAKEInstrDefinition* instrDef = 
-                    dynamic_cast<FAKEInstrDefinition *>(this);
-
-                newInstrDef = new FAKEInstrDefinition(*instrDef);
-                break;
-            }
-    }
-
-    return newInstrDef;
-}
-
-//////////////////////////////////////////
-// Definition of CASHInstrDefinition class
-//////////////////////////////////////////
-CASHInstrDefinition::CASHInstrDefinition(Duration& maturity, int index):
-    InstrumentDefinition(maturity, index)
-{
-    _type = InstrumentDefinition::CASH;
-}
-
-CASHInstrDefinition::~CASHInstrDefinition()
-{
-}
-
-std::string CASHInstrDefinition::subtype() const
-{
-    return _maturity.toString(true, true);
-}
-//////////////////////////////////////////
-// Definition of FRAInstrDefinition class
-//////////////////////////////////////////
-const Duration::TYPE FRAInstrDefinition::defaultDurationType = Duration::MONTH;
-
-FRAInstrDefinition::FRAInstrDefinition(Duration& startDuration,
-        Duration& maturity, int index):
-    _startDuration(startDuration), InstrumentDefinition(maturity, index)
+std::string InstrumentDefinition::subtype() const
 {
-    _type = InstrumentDefinition::FRA;
-}
-
-FRAInstrDefinition::~FRAInstrDefinition()
-{
-}
-
-std::string FRAInstrDefinition::subtype() const
-{
-    return _startDuration.toString(false, false) + 
-        "x" + _maturity.toString(false, false);
-}
-
-//////////////////////////////////////////
-// Definition of SWAPInstrDefinition class
-//////////////////////////////////////////
-SWAPInstrDefinition::SWAPInstrDefinition(Duration& maturity, int index):
-    InstrumentDefinition(maturity, index)
-{
-    _type = InstrumentDefinition::SWAP;
-}
-
-SWAPInstrDefinition::~SWAPInstrDefinition()
-{
-}
-
-std::string SWAPInstrDefinition::subtype() const
-{
-    return _maturity.toString(true, true);
-}
-
-//////////////////////////////////////////
-// Definition of SWAPInstrDefinition class
-//////////////////////////////////////////
-std::string FAKEInstrDefinition::subtype() const
-{
-    return _maturity.toString(true, true);
+    if(_type == InstrumentDefinition::FRA)
+        return _startDuration.toString(false, false) + 
+            "x" + _maturity.toString(false, false);
+    else
+        return _maturity.toString(true, true);
 }
 
 //////////////////////////////////////////
@@ -279,12 +177,10 @@ bool InstrumentDefinitionCompare::operator()(
         const InstrumentDefinition& lhs,
         const InstrumentDefinition& rhs) const
 {
-    int timeI1, timeI2;
-
-    timeI1 = lhs.maturity().getDuration(Duration::DAY);
-    timeI2 = rhs.maturity().getDuration(Duration::DAY);
+    const Tenor& tenor1 = lhs.maturityTenor();
+    const Tenor& tenor2 = rhs.maturityTenor();
 
-    if(timeI1 == timeI2)
+    if(tenor1 == tenor2)
     {
         if((lhs.type() == InstrumentDefinition::CASH &&
             (rhs.type() == InstrumentDefinition::FRA || rhs.type() == InstrumentDefinition::SWAP)) ||
@@ -294,15 +190,9 @@ bool InstrumentDefinitionCompare::operator()(
             return false;
     }
     else
-        return timeI1 < timeI2;
+        return tenor1 < tenor2;
 }
 
-bool InstrumentDefinitionCompare::operator()(
-        const InstrumentDefinition* ptrlhs,
-        const InstrumentDefinition* ptrrhs) const
-{
-    return this->operator()(*ptrlhs, *ptrrhs);
-}
 //////////////////////////////////////////
 // Definition of InstrumentDefinitionDurationCompare structure
 //////////////////////////////////////////
@@ -310,24 +200,9 @@ bool InstrumentDefinitionDurationCompare::operator()(
         const InstrumentDefinition& lhs,
         const Duration& rhs) const
 {
-    int timeI1, timeI2;
-
-    timeI1 = lhs.maturity().getDuration(Duration::DAY);
-    timeI2 = rhs.getDuration(Duration::DAY);
-
-    if(timeI1 == timeI2)
-        return false;
-    else
-        return timeI1 < timeI2;
+    return lhs.maturityTenor() < rhs.tenor();
 }
 
-bool InstrumentDefinitionDurationCompare::operator()(
-        const InstrumentDefinition *ptrlhs,
-        const Duration *ptrrhs) const
-{
-    return this->operator()(
-            *ptrlhs, *ptrrhs);
-}
 bool InstrumentDefinitionDurationCompare::operator()(
         const Duration& lhs,
         const InstrumentDefinition& rhs) const
@@ -335,10 +210,3 @@ bool InstrumentDefinitionDurationCompare::operator()(
     return !(this->operator()(rhs, lhs));
 }
 
-bool InstrumentDefinitionDurationCompare::operator()(
-        const Duration *ptrrhs,
-        const InstrumentDefinition *ptrlhs) const
-{
-    return !(this->operator()(*ptrrhs, *ptrlhs));
-}
-
@@ -0,0 +1,242 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "OutputWriter.h"
+
+namespace
+{
+    // "00" "01" ... "99", so that integers are written two
+    // digits at a time
+    struct DigitPairTable
+    {
+        DigitPairTable()
+        {
+            for(int i = 0; i < 100; i ++)
+            {
+                digits[2 * i] = (char)('0' + i / 10);
+                digits[2 * i + 1] = (char)('0' + i % 10);
+            }
+        }
+
+        char digits[200];
+    };
+
+    const DigitPairTable digitPairs;
+
+    const char monthNames[12][4] = {"Jan", "Feb", "Mar", "Apr",
+        "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4,
+        1e5, 1e6, 1e7, 1e8, 1e9};
+    const unsigned long long intPowersOf10[] = {1ULL, 10ULL, 100ULL,
+        1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+        100000000ULL, 1000000000ULL};
+
+    // Write the decimal digits of value backwards ending at
+    // end, and return the position of the first digit
+    inline char *formatUnsigned(unsigned long long value, char *end)
+    {
+        while(value >= 100)
+        {
+            int pair = (int)(value % 100);
+            value /= 100;
+            *(-- end) = digitPairs.digits[2 * pair + 1];
+            *(-- end) = digitPairs.digits[2 * pair];
+        }
+
+        if(value >= 10)
+        {
+            *(-- end) = digitPairs.digits[2 * value + 1];
+            *(-- end) = digitPairs.digits[2 * value];
+        }
+        else
+        {
+            *(-- end) = (char)('0' + value);
+        }
+
+        return end;
+    }
+
+    // Same as formatUnsigned but always write width digits
+    inline void formatZeroPadded(unsigned long long value, char *end,
+            int width)
+    {
+        for(int i = 0; i < width; i ++)
+        {
+            *(-- end) = (char)('0' + value % 10);
+            value /= 10;
+        }
+    }
+}
+
+//////////////////////////////////////////
+// Definition of the class BufferedWriter
+//////////////////////////////////////////
+BufferedWriter::BufferedWriter(int fd, size_t bufferSize):
+    _fd(fd), _ownFd(false), _buffer(bufferSize < 64 ? 64 : bufferSize),
+    _size(0)
+{
+}
+
+BufferedWriter::BufferedWriter(const std::string& filename,
+        size_t bufferSize):
+    _fd(-1), _ownFd(true), _buffer(bufferSize < 64 ? 64 : bufferSize),
+    _size(0)
+{
+    _fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(_fd < 0)
+        throw OutputException("Cannot open the output file " + filename);
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch(OutputException& e)
+    {
+    }
+
+    if(_ownFd)
+        close(_fd);
+}
+
+BufferedWriter& BufferedWriter::writeInt(long long value)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    unsigned long long absValue = value < 0 ?
+        0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    char *begin = formatUnsigned(absValue, end);
+    if(value < 0)
+        *(-- begin) = '-';
+
+    return write(begin, end - begin);
+}
+
+BufferedWriter& BufferedWriter::writeFixed(double value, int precision)
+{
+    bool negative = value < 0.0 || (value == 0.0 && 1.0 / value < 0.0);
+    double absValue = fabs(value);
+
+    if(precision >= 0 && precision <= 9 && absValue < 1e15)
+    {
+        double scaled = absValue * powersOf10[precision];
+        double integral = floor(scaled);
+        double fraction = scaled - integral;
+
+        // The product may be off by half an ulp, so only decide
+        // the rounding here when it cannot be a tie; ties and
+        // large numbers are left to printf below
+        double margin = scaled * 4e-16 + 1e-12;
+        if(scaled < 1e15 && fabs(fraction - 0.5) > margin)
+        {
+            unsigned long long digits = (unsigned long long)integral +
+                (fraction > 0.5 ? 1 : 0);
+            unsigned long long intPart = digits / intPowersOf10[precision];
+            unsigned long long fracPart = digits % intPowersOf10[precision];
+
+            char text[48];
+            char *end = text + sizeof(text);
+            char *begin = end;
+            if(precision > 0)
+            {
+                begin -= precision;
+                formatZeroPadded(fracPart, end, precision);
+                *(-- begin) = '.';
+            }
+            begin = formatUnsigned(intPart, begin);
+            if(negative)
+                *(-- begin) = '-';
+
+            return write(begin, end - begin);
+        }
+    }
+
+    char *text = _reserve(512);
+    int length = snprintf(text, 512, "%.*f", precision, value);
+    if(length > 0)
+        _size += length < 512 ? length : 511;
+
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::writeGeneral(double value, int precision)
+{
+    char *text = _reserve(64);
+    int length = snprintf(text, 64, "%.*g", precision, value);
+    if(length > 0)
+        _size += length < 64 ? length : 63;
+
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::writeShortest(double value)
+{
+    char text[32];
+    int length = 0;
+    for(int precision = 15; precision <= 17; precision ++)
+    {
+        length = snprintf(text, sizeof(text), "%.*g", precision, value);
+        if(strtod(text, NULL) == value || value != value)
+            break;
+    }
+
+    return write(text, length);
+}
+
+BufferedWriter& BufferedWriter::writeDate(const Date& date)
+{
+    boost::gregorian::date rawDate = date.get();
+    if(rawDate.is_special())
+        return write(date.toString());
+
+    boost::gregorian::date::ymd_type ymd = rawDate.year_month_day();
+    int year = ymd.year;
+    int day = ymd.day;
+
+    char *text = _reserve(11);
+    formatZeroPadded(year, text + 4, 4);
+    text[4] = '-';
+    memcpy(text + 5, monthNames[ymd.month - 1], 3);
+    text[8] = '-';
+    text[9] = digitPairs.digits[2 * day];
+    text[10] = digitPairs.digits[2 * day + 1];
+    _size += 11;
+
+    return *this;
+}
+
+void BufferedWriter::flush()
+{
+    if(_size == 0)
+        return;
+
+    size_t size = _size;
+    _size = 0;
+    _writeAll(&_buffer[0], size);
+}
+
+void BufferedWriter::_writeAll(const char *data, size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t written = ::write(_fd, data, length);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            throw OutputException("Fail to write the output");
+        }
+
+        data += written;
+        length -= written;
+    }
+}
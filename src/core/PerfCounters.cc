@@ -0,0 +1,117 @@
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "PerfCounters.h"
+
+namespace
+{
+    const char *eventNames[PerfCounters::NUMEVENTS] =
+    {
+        "cycles", "instructions", "cache_misses", "branch_misses"
+    };
+
+#ifdef __linux__
+    const uint64_t eventConfigs[PerfCounters::NUMEVENTS] =
+    {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    // There is no glibc wrapper
+    int openEvent(uint64_t config, int groupFd)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP |
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return (int)syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+    }
+#endif
+}
+
+const char *PerfCounters::eventName(int event)
+{
+    return event >= 0 && event < NUMEVENTS ? eventNames[event] : "";
+}
+
+PerfCounters::CounterGroup::CounterGroup():_numOpen(0)
+{
+    for(int i = 0; i < NUMEVENTS; i ++)
+    {
+        _fds[i] = -1;
+        _positions[i] = -1;
+    }
+
+#ifdef __linux__
+    // The cycles lead the group, the others join it if they can
+    for(int i = 0; i < NUMEVENTS; i ++)
+    {
+        int fd = openEvent(eventConfigs[i], i == CYCLES ? -1 : _fds[CYCLES]);
+        if(fd < 0)
+        {
+            if(_error.empty())
+                _error = std::string(eventNames[i]) + ": " + strerror(errno);
+            if(i == CYCLES)
+                return;
+            continue;
+        }
+
+        _fds[i] = fd;
+        _positions[i] = _numOpen ++;
+    }
+#else
+    _error = "perf_event_open is only available on Linux";
+#endif
+}
+
+PerfCounters::CounterGroup::~CounterGroup()
+{
+    for(int i = 0; i < NUMEVENTS; i ++)
+    {
+        if(_fds[i] >= 0)
+            close(_fds[i]);
+    }
+}
+
+bool PerfCounters::CounterGroup::read(uint64_t values[NUMEVENTS]) const
+{
+    if(!isOpen())
+        return false;
+
+    // nr, time enabled, time running, then the values in the
+    // order the events were opened
+    uint64_t buffer[3 + NUMEVENTS];
+    ssize_t size = (ssize_t)((3 + _numOpen) * sizeof(uint64_t));
+    if(::read(_fds[CYCLES], buffer, size) != size)
+        return false;
+
+    uint64_t enabled = buffer[1];
+    uint64_t running = buffer[2];
+    for(int i = 0; i < NUMEVENTS; i ++)
+    {
+        if(_positions[i] < 0)
+        {
+            values[i] = 0;
+            continue;
+        }
+
+        uint64_t value = buffer[3 + _positions[i]];
+        if(running > 0 && running < enabled)
+            value = (uint64_t)((double)value * enabled / running);
+        values[i] = value;
+    }
+
+    return true;
+}
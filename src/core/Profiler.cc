@@ -0,0 +1,736 @@
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <time.h>
+
+#include "Profiler.h"
+
+namespace
+{
+    // The histogram buckets split every power of two in 4, so a
+    // percentile is within 25% of the time recorded
+    const int numBuckets = 252;
+
+    inline int bucketOf(uint64_t ns)
+    {
+        if(ns < 4)
+            return (int)ns;
+
+        int msb = 63 - __builtin_clzll(ns);
+        return 4 * (msb - 1) + (int)((ns >> (msb - 2)) & 3);
+    }
+
+    inline uint64_t bucketUpperBound(int bucket)
+    {
+        if(bucket < 4)
+            return (uint64_t)bucket;
+
+        int msb = bucket / 4 + 1;
+        return ((uint64_t)(5 + bucket % 4) << (msb - 2)) - 1;
+    }
+
+    struct TimerSlot
+    {
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t minNs;
+        uint64_t maxNs;
+        uint64_t items;
+        uint64_t buckets[numBuckets];
+    };
+
+    // Everything recorded by one thread
+    struct ThreadBuffer
+    {
+        TimerSlot timers[Profiler::maxTimers];
+        uint64_t counters[Profiler::maxCounters];
+    };
+
+    void addBuffer(ThreadBuffer& to, const ThreadBuffer& from)
+    {
+        for(int i = 0; i < Profiler::maxTimers; i ++)
+        {
+            TimerSlot& slot = to.timers[i];
+            const TimerSlot& other = from.timers[i];
+            if(other.count == 0)
+                continue;
+
+            if(slot.count == 0 || other.minNs < slot.minNs)
+                slot.minNs = other.minNs;
+            if(other.maxNs > slot.maxNs)
+                slot.maxNs = other.maxNs;
+            slot.count += other.count;
+            slot.totalNs += other.totalNs;
+            slot.items += other.items;
+            for(int b = 0; b < numBuckets; b ++)
+                slot.buckets[b] += other.buckets[b];
+        }
+        for(int i = 0; i < Profiler::maxCounters; i ++)
+            to.counters[i] += from.counters[i];
+    }
+
+    // The hardware events counted by one thread. Unlike the
+    // buffers, they are kept after the thread exits, to be
+    // reported per thread; only the counters are closed.
+    struct HardwareRecord
+    {
+        PerfCounters::CounterGroup *group;
+        uint64_t scopes[Profiler::maxTimers];
+        uint64_t items[Profiler::maxTimers];
+        uint64_t events[Profiler::maxTimers][PerfCounters::NUMEVENTS];
+    };
+
+    // The names and the buffers of the running threads. A thread
+    // adds its buffer to the retired one when it exits, and leaves
+    // it to the next thread started.
+    struct Registry
+    {
+        pthread_mutex_t lock;
+        std::vector<std::string> timerNames;
+        std::vector<std::string> counterNames;
+        std::vector<ThreadBuffer *> liveBuffers;
+        std::vector<ThreadBuffer *> freeBuffers;
+        ThreadBuffer retired;
+        pthread_key_t bufferKey;
+        std::vector<HardwareRecord *> hardwareRecords;
+        // The events the first group opened could count
+        bool hardwareEvents[PerfCounters::NUMEVENTS];
+        pthread_key_t hardwareKey;
+        std::string dumpFilename;
+    };
+
+    class ScopedLock
+    {
+        public:
+            explicit ScopedLock(pthread_mutex_t& mutex):_mutex(mutex)
+            {
+                pthread_mutex_lock(&_mutex);
+            }
+            ~ScopedLock() {pthread_mutex_unlock(&_mutex);}
+
+        private:
+            pthread_mutex_t& _mutex;
+    };
+
+    Registry *registry = NULL;
+    pthread_once_t registryOnce = PTHREAD_ONCE_INIT;
+    __thread ThreadBuffer *threadBuffer = NULL;
+    __thread HardwareRecord *threadHardware = NULL;
+    // Set once, before the threads counting are started
+    bool hardwareEnabled = false;
+
+    void retireBuffer(void *arg)
+    {
+        ThreadBuffer *buffer = static_cast<ThreadBuffer *>(arg);
+        ScopedLock lock(registry->lock);
+        addBuffer(registry->retired, *buffer);
+        for(int i = 0; i < (int)registry->liveBuffers.size(); i ++)
+        {
+            if(registry->liveBuffers[i] == buffer)
+            {
+                registry->liveBuffers.erase(registry->liveBuffers.begin() + i);
+                break;
+            }
+        }
+        registry->freeBuffers.push_back(buffer);
+    }
+
+    void closeHardware(void *arg)
+    {
+        HardwareRecord *record = static_cast<HardwareRecord *>(arg);
+        ScopedLock lock(registry->lock);
+        delete record->group;
+        record->group = NULL;
+    }
+
+    // Never destroyed, the threads may record until the very end
+    void createRegistry()
+    {
+        registry = new Registry();
+        pthread_mutex_init(&registry->lock, NULL);
+        memset(&registry->retired, 0, sizeof(ThreadBuffer));
+        pthread_key_create(&registry->bufferKey, retireBuffer);
+        for(int i = 0; i < PerfCounters::NUMEVENTS; i ++)
+            registry->hardwareEvents[i] = false;
+        pthread_key_create(&registry->hardwareKey, closeHardware);
+    }
+
+    Registry& theRegistry()
+    {
+        pthread_once(&registryOnce, createRegistry);
+        return *registry;
+    }
+
+    ThreadBuffer& localBuffer()
+    {
+        if(threadBuffer != NULL)
+            return *threadBuffer;
+
+        Registry& reg = theRegistry();
+        ThreadBuffer *buffer;
+        {
+            ScopedLock lock(reg.lock);
+            if(reg.freeBuffers.empty())
+            {
+                buffer = new ThreadBuffer();
+            }
+            else
+            {
+                buffer = reg.freeBuffers.back();
+                reg.freeBuffers.pop_back();
+            }
+            memset(buffer, 0, sizeof(ThreadBuffer));
+            reg.liveBuffers.push_back(buffer);
+        }
+        pthread_setspecific(reg.bufferKey, buffer);
+        threadBuffer = buffer;
+
+        return *buffer;
+    }
+
+    // The counters of the calling thread, opened on its first
+    // timed scope
+    HardwareRecord& localHardware()
+    {
+        if(threadHardware != NULL)
+            return *threadHardware;
+
+        Registry& reg = theRegistry();
+        HardwareRecord *record = new HardwareRecord();
+        memset(record, 0, sizeof(HardwareRecord));
+        record->group = new PerfCounters::CounterGroup();
+        {
+            ScopedLock lock(reg.lock);
+            reg.hardwareRecords.push_back(record);
+        }
+        pthread_setspecific(reg.hardwareKey, record);
+        threadHardware = record;
+
+        return *record;
+    }
+
+    int findOrAdd(std::vector<std::string>& names, const char *name, int maxNames)
+    {
+        ScopedLock lock(theRegistry().lock);
+        for(int i = 0; i < (int)names.size(); i ++)
+        {
+            if(names[i] == name)
+                return i;
+        }
+        if((int)names.size() >= maxNames)
+            return -1;
+
+        names.push_back(name);
+        return (int)names.size() - 1;
+    }
+
+    int find(const std::vector<std::string>& names, const char *name)
+    {
+        for(int i = 0; i < (int)names.size(); i ++)
+        {
+            if(names[i] == name)
+                return i;
+        }
+        return -1;
+    }
+
+    // The upper bound of the bucket holding the given fraction
+    // of the times
+    uint64_t percentile(const TimerSlot& slot, double fraction)
+    {
+        uint64_t rank = (uint64_t)(fraction * slot.count);
+        if(rank >= slot.count)
+            rank = slot.count - 1;
+
+        uint64_t seen = 0;
+        for(int b = 0; b < numBuckets; b ++)
+        {
+            seen += slot.buckets[b];
+            if(seen > rank)
+                return std::min(bucketUpperBound(b), slot.maxNs);
+        }
+        return slot.maxNs;
+    }
+
+    void mergeBuffers(ThreadBuffer& merged, std::vector<std::string>& timerNames,
+            std::vector<std::string>& counterNames)
+    {
+        Registry& reg = theRegistry();
+        ScopedLock lock(reg.lock);
+        merged = reg.retired;
+        for(int i = 0; i < (int)reg.liveBuffers.size(); i ++)
+            addBuffer(merged, *reg.liveBuffers[i]);
+        timerNames = reg.timerNames;
+        counterNames = reg.counterNames;
+    }
+
+    void addHardware(Profiler::HardwareReport& report, const HardwareRecord& record,
+            int timerId)
+    {
+        report.scopes += record.scopes[timerId];
+        report.items += record.items[timerId];
+        for(int e = 0; e < PerfCounters::NUMEVENTS; e ++)
+            report.events[e] += record.events[timerId][e];
+    }
+
+    void writeRatio(std::ostream& out, uint64_t numerator, uint64_t denominator,
+            bool valid, const char *missing)
+    {
+        if(valid && denominator > 0)
+            out << (double)numerator / denominator;
+        else
+            out << missing;
+    }
+
+    // The events, the instructions per cycle and the events per
+    // item, as JSON members or CSV columns; the events not counted
+    // are null or empty
+    void writeHardwareFields(std::ostream& out, const Profiler::HardwareReport& report,
+            bool json)
+    {
+        bool has[PerfCounters::NUMEVENTS];
+        for(int e = 0; e < PerfCounters::NUMEVENTS; e ++)
+            has[e] = Profiler::hasHardwareEvent(e);
+
+        const char *separator = json ? ", " : ",";
+        const char *missing = json ? "null" : "";
+        for(int e = 0; e < PerfCounters::NUMEVENTS; e ++)
+        {
+            out << separator;
+            if(json)
+                out << "\"" << PerfCounters::eventName(e) << "\": ";
+            if(has[e])
+                out << report.events[e];
+            else
+                out << missing;
+        }
+
+        const char *ratioNames[] = {"ipc", "cycles_per_item",
+            "cache_misses_per_item", "branch_misses_per_item"};
+        const int numerators[] = {PerfCounters::INSTRUCTIONS, PerfCounters::CYCLES,
+            PerfCounters::CACHEMISSES, PerfCounters::BRANCHMISSES};
+        for(int i = 0; i < 4; i ++)
+        {
+            out << separator;
+            if(json)
+                out << "\"" << ratioNames[i] << "\": ";
+            if(i == 0)
+                writeRatio(out, report.events[PerfCounters::INSTRUCTIONS],
+                        report.events[PerfCounters::CYCLES],
+                        has[PerfCounters::INSTRUCTIONS], missing);
+            else
+                writeRatio(out, report.events[numerators[i]], report.items,
+                        has[numerators[i]], missing);
+        }
+    }
+
+    const char *stageName(const std::vector<Profiler::TimerReport>& timers,
+            int timerId)
+    {
+        return timerId >= 0 && timerId < (int)timers.size() ?
+            timers[timerId].name.c_str() : "(unscoped)";
+    }
+
+    void writeAtExit()
+    {
+        Profiler::writeReport(theRegistry().dumpFilename);
+    }
+
+    void *signalMain(void *arg)
+    {
+        sigset_t *signals = static_cast<sigset_t *>(arg);
+        while(true)
+        {
+            int signalNumber;
+            if(sigwait(signals, &signalNumber) == 0)
+                Profiler::writeReport(theRegistry().dumpFilename);
+        }
+
+        return NULL;
+    }
+}
+
+uint64_t Profiler::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int Profiler::timerId(const char *name)
+{
+    return findOrAdd(theRegistry().timerNames, name, maxTimers);
+}
+
+int Profiler::counterId(const char *name)
+{
+    return findOrAdd(theRegistry().counterNames, name, maxCounters);
+}
+
+void Profiler::record(int timerId, uint64_t ns, uint64_t items)
+{
+    if(timerId < 0)
+        return;
+
+    TimerSlot& slot = localBuffer().timers[timerId];
+    if(slot.count == 0 || ns < slot.minNs)
+        slot.minNs = ns;
+    if(ns > slot.maxNs)
+        slot.maxNs = ns;
+    slot.count ++;
+    slot.totalNs += ns;
+    slot.items += items;
+    slot.buckets[bucketOf(ns)] ++;
+}
+
+void Profiler::count(int counterId, uint64_t n)
+{
+    if(counterId < 0)
+        return;
+
+    localBuffer().counters[counterId] += n;
+}
+
+bool Profiler::enableHardwareCounters(std::string& error)
+{
+    Registry& reg = theRegistry();
+    HardwareRecord& record = localHardware();
+    if(!record.group->isOpen())
+    {
+        error = record.group->error();
+        return false;
+    }
+
+    {
+        ScopedLock lock(reg.lock);
+        for(int i = 0; i < PerfCounters::NUMEVENTS; i ++)
+            reg.hardwareEvents[i] = record.group->hasEvent(i);
+    }
+    hardwareEnabled = true;
+    // Some events may be missing
+    error = record.group->error();
+
+    return true;
+}
+
+bool Profiler::hardwareCountersEnabled()
+{
+    return hardwareEnabled;
+}
+
+bool Profiler::hasHardwareEvent(int event)
+{
+    Registry& reg = theRegistry();
+    ScopedLock lock(reg.lock);
+    return hardwareEnabled && reg.hardwareEvents[event];
+}
+
+bool Profiler::startHardwareCounters(uint64_t values[PerfCounters::NUMEVENTS])
+{
+    if(!hardwareEnabled)
+        return false;
+
+    HardwareRecord& record = localHardware();
+    return record.group != NULL && record.group->read(values);
+}
+
+void Profiler::stopHardwareCounters(int timerId, uint64_t items,
+        const uint64_t values[PerfCounters::NUMEVENTS])
+{
+    if(timerId < 0)
+        return;
+
+    uint64_t current[PerfCounters::NUMEVENTS];
+    HardwareRecord& record = localHardware();
+    if(record.group == NULL || !record.group->read(current))
+        return;
+
+    record.scopes[timerId] ++;
+    record.items[timerId] += items;
+    for(int e = 0; e < PerfCounters::NUMEVENTS; e ++)
+        record.events[timerId][e] += current[e] - values[e];
+}
+
+void Profiler::hardwareSnapshot(std::vector<HardwareReport>& reports)
+{
+    reports.clear();
+    if(!hardwareEnabled)
+        return;
+
+    Registry& reg = theRegistry();
+    ScopedLock lock(reg.lock);
+    for(int thread = -1; thread < (int)reg.hardwareRecords.size(); thread ++)
+    {
+        for(int t = 0; t < (int)reg.timerNames.size(); t ++)
+        {
+            HardwareReport report;
+            report.name = reg.timerNames[t];
+            report.thread = thread;
+            report.scopes = report.items = 0;
+            for(int e = 0; e < PerfCounters::NUMEVENTS; e ++)
+                report.events[e] = 0;
+
+            if(thread >= 0)
+            {
+                addHardware(report, *reg.hardwareRecords[thread], t);
+            }
+            else
+            {
+                for(int i = 0; i < (int)reg.hardwareRecords.size(); i ++)
+                    addHardware(report, *reg.hardwareRecords[i], t);
+            }
+
+            if(report.scopes > 0)
+                reports.push_back(report);
+        }
+    }
+}
+
+void Profiler::snapshot(std::vector<TimerReport>& timers,
+        std::vector<CounterReport>& counters)
+{
+    ThreadBuffer *merged = new ThreadBuffer();
+    std::vector<std::string> timerNames;
+    std::vector<std::string> counterNames;
+    mergeBuffers(*merged, timerNames, counterNames);
+
+    timers.resize(timerNames.size());
+    for(int i = 0; i < (int)timerNames.size(); i ++)
+    {
+        const TimerSlot& slot = merged->timers[i];
+        TimerReport& timer = timers[i];
+        timer.name = timerNames[i];
+        timer.count = slot.count;
+        timer.totalNs = slot.totalNs;
+        timer.minNs = slot.minNs;
+        timer.maxNs = slot.maxNs;
+        timer.p50Ns = slot.count > 0 ? percentile(slot, 0.50) : 0;
+        timer.p90Ns = slot.count > 0 ? percentile(slot, 0.90) : 0;
+        timer.p99Ns = slot.count > 0 ? percentile(slot, 0.99) : 0;
+        timer.items = slot.items;
+    }
+
+    counters.resize(counterNames.size());
+    for(int i = 0; i < (int)counterNames.size(); i ++)
+    {
+        counters[i].name = counterNames[i];
+        counters[i].value = merged->counters[i];
+    }
+
+    delete merged;
+}
+
+uint64_t Profiler::totalNs(const char *timerName)
+{
+    std::vector<TimerReport> timers;
+    std::vector<CounterReport> counters;
+    snapshot(timers, counters);
+    for(int i = 0; i < (int)timers.size(); i ++)
+    {
+        if(timers[i].name == timerName)
+            return timers[i].totalNs;
+    }
+    return 0;
+}
+
+uint64_t Profiler::counter(const char *counterName)
+{
+    Registry& reg = theRegistry();
+    ScopedLock lock(reg.lock);
+    int id = find(reg.counterNames, counterName);
+    if(id < 0)
+        return 0;
+
+    uint64_t value = reg.retired.counters[id];
+    for(int i = 0; i < (int)reg.liveBuffers.size(); i ++)
+        value += reg.liveBuffers[i]->counters[id];
+    return value;
+}
+
+void Profiler::reset()
+{
+    Registry& reg = theRegistry();
+    ScopedLock lock(reg.lock);
+    memset(&reg.retired, 0, sizeof(ThreadBuffer));
+    for(int i = 0; i < (int)reg.liveBuffers.size(); i ++)
+        memset(reg.liveBuffers[i], 0, sizeof(ThreadBuffer));
+    for(int i = 0; i < (int)reg.hardwareRecords.size(); i ++)
+    {
+        HardwareRecord& record = *reg.hardwareRecords[i];
+        memset(record.scopes, 0, sizeof(record.scopes));
+        memset(record.items, 0, sizeof(record.items));
+        memset(record.events, 0, sizeof(record.events));
+    }
+}
+
+void Profiler::writeJson(std::ostream& out)
+{
+    std::vector<TimerReport> timers;
+    std::vector<CounterReport> counters;
+    snapshot(timers, counters);
+
+    out << "{\n  \"unit\": \"ns\",\n  \"timers\": [\n";
+    for(int i = 0; i < (int)timers.size(); i ++)
+    {
+        const TimerReport& timer = timers[i];
+        out << "    {\"name\": \"" << timer.name << "\", " <<
+            "\"count\": " << timer.count << ", " <<
+            "\"total_ns\": " << timer.totalNs << ", " <<
+            "\"min_ns\": " << timer.minNs << ", " <<
+            "\"max_ns\": " << timer.maxNs << ", " <<
+            "\"p50_ns\": " << timer.p50Ns << ", " <<
+            "\"p90_ns\": " << timer.p90Ns << ", " <<
+            "\"p99_ns\": " << timer.p99Ns << ", " <<
+            "\"items\": " << timer.items << "}" <<
+            (i + 1 < (int)timers.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"counters\": [\n";
+    for(int i = 0; i < (int)counters.size(); i ++)
+    {
+        out << "    {\"name\": \"" << counters[i].name << "\", " <<
+            "\"value\": " << counters[i].value << "}" <<
+            (i + 1 < (int)counters.size() ? "," : "") << "\n";
+    }
+    out << "  ]";
+
+    std::vector<HardwareReport> hardware;
+    hardwareSnapshot(hardware);
+    if(hardwareEnabled)
+    {
+        out << ",\n  \"hardware\": [\n";
+        for(int i = 0; i < (int)hardware.size(); i ++)
+        {
+            const HardwareReport& report = hardware[i];
+            out << "    {\"name\": \"" << report.name << "\", " <<
+                "\"thread\": " << report.thread << ", " <<
+                "\"scopes\": " << report.scopes << ", " <<
+                "\"items\": " << report.items;
+            writeHardwareFields(out, report, true);
+            out << "}" << (i + 1 < (int)hardware.size() ? "," : "") << "\n";
+        }
+        out << "  ]";
+    }
+
+    if(AllocationTracker::enabled())
+    {
+        std::vector<AllocationTracker::StageReport> stages;
+        AllocationTracker::snapshot(stages);
+        out << ",\n  \"memory\": {\"max_rss_kb\": " << AllocationTracker::maxRssKb() <<
+            ", \"live_bytes\": " << AllocationTracker::liveBytes() <<
+            ", \"peak_live_bytes\": " << AllocationTracker::peakLiveBytes() <<
+            ", \"allocations\": " << AllocationTracker::allocations() << "}";
+        out << ",\n  \"allocations\": [\n";
+        for(int i = 0; i < (int)stages.size(); i ++)
+        {
+            const AllocationTracker::StageReport& stage = stages[i];
+            out << "    {\"name\": \"" << stageName(timers, stage.timerId) << "\", " <<
+                "\"scopes\": " << stage.scopes << ", " <<
+                "\"allocations\": " << stage.allocations << ", " <<
+                "\"frees\": " << stage.frees << ", " <<
+                "\"bytes\": " << stage.bytes << ", " <<
+                "\"peak_live_bytes\": " << stage.peakLiveBytes << ", " <<
+                "\"max_rss_kb\": " << stage.maxRssKb << "}" <<
+                (i + 1 < (int)stages.size() ? "," : "") << "\n";
+        }
+        out << "  ]";
+    }
+    out << "\n}\n";
+}
+
+void Profiler::writeCsv(std::ostream& out)
+{
+    std::vector<TimerReport> timers;
+    std::vector<CounterReport> counters;
+    snapshot(timers, counters);
+
+    // The value of a counter is in the count column, the hardware
+    // rows are per timer, in all the threads (-1) or in one, and
+    // the memory row is of the whole process
+    out << "\"Kind\",\"Name\",\"Count\",\"Total ns\",\"Min ns\",\"Max ns\"," <<
+        "\"P50 ns\",\"P90 ns\",\"P99 ns\",\"Items\",\"Thread\",\"Scopes\"," <<
+        "\"Cycles\",\"Instructions\",\"Cache misses\",\"Branch misses\",\"IPC\"," <<
+        "\"Cycles per item\",\"Cache misses per item\",\"Branch misses per item\"," <<
+        "\"Allocations\",\"Frees\",\"Bytes\",\"Peak live bytes\",\"Max RSS kB\"\n";
+    for(int i = 0; i < (int)timers.size(); i ++)
+    {
+        const TimerReport& timer = timers[i];
+        out << "\"timer\",\"" << timer.name << "\"," << timer.count << "," <<
+            timer.totalNs << "," << timer.minNs << "," << timer.maxNs << "," <<
+            timer.p50Ns << "," << timer.p90Ns << "," << timer.p99Ns << "," <<
+            timer.items << ",,,,,,,,,,,,,,,\n";
+    }
+    for(int i = 0; i < (int)counters.size(); i ++)
+    {
+        out << "\"counter\",\"" << counters[i].name << "\"," <<
+            counters[i].value << ",,,,,,,,,,,,,,,,,,,,,,\n";
+    }
+
+    std::vector<HardwareReport> hardware;
+    hardwareSnapshot(hardware);
+    for(int i = 0; i < (int)hardware.size(); i ++)
+    {
+        const HardwareReport& report = hardware[i];
+        out << "\"hardware\",\"" << report.name << "\",,,,,,,," <<
+            report.items << "," << report.thread << "," << report.scopes;
+        writeHardwareFields(out, report, false);
+        out << ",,,,,\n";
+    }
+
+    if(!AllocationTracker::enabled())
+        return;
+
+    std::vector<AllocationTracker::StageReport> stages;
+    AllocationTracker::snapshot(stages);
+    for(int i = 0; i < (int)stages.size(); i ++)
+    {
+        const AllocationTracker::StageReport& stage = stages[i];
+        out << "\"allocations\",\"" << stageName(timers, stage.timerId) << "\",,,,,,,,,," <<
+            stage.scopes << ",,,,,,,,," << stage.allocations << "," << stage.frees << "," <<
+            stage.bytes << "," << stage.peakLiveBytes << "," << stage.maxRssKb << "\n";
+    }
+    out << "\"memory\",\"process\",,,,,,,,,,,,,,,,,,," << AllocationTracker::allocations() <<
+        ",,," << AllocationTracker::peakLiveBytes() << "," <<
+        AllocationTracker::maxRssKb() << "\n";
+}
+
+void Profiler::writeReport(const std::string& filename)
+{
+    std::ofstream fout(filename.c_str());
+    if(!fout.good())
+        return;
+
+    if(filename.size() >= 4 &&
+            filename.compare(filename.size() - 4, 4, ".csv") == 0)
+        writeCsv(fout);
+    else
+        writeJson(fout);
+}
+
+void Profiler::dumpOnExit(const std::string& filename, int signalNumber)
+{
+    Registry& reg = theRegistry();
+    bool first;
+    {
+        ScopedLock lock(reg.lock);
+        first = reg.dumpFilename.empty();
+        reg.dumpFilename = filename;
+    }
+    if(!first)
+        return;
+
+    atexit(writeAtExit);
+
+    // Inherited by the threads created from now on, so only the
+    // waiting thread receives the signal
+    static sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, signalNumber);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, signalMain, &signals) == 0)
+        pthread_detach(thread);
+}
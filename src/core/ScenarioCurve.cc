@@ -0,0 +1,388 @@
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+#include "ScenarioCurve.h"
+#include "Schedule.h"
+#include "Utility.h"
+
+//////////////////////////////////////////
+// Definition of the class ScenarioQuotes
+//////////////////////////////////////////
+ScenarioQuotes::ScenarioQuotes(const InstrumentValues& base,
+        int numScenarios):
+    _numScenarios(numScenarios)
+{
+    int numQuotes = (int)base.values.size();
+    _values.resize(numQuotes * numScenarios);
+    for(int j = 0; j < numQuotes; j ++)
+    {
+        _quoteIds.push_back(base.values[j].first);
+        std::fill(_values.begin() + j * numScenarios,
+                _values.begin() + (j + 1) * numScenarios,
+                base.values[j].second);
+    }
+}
+
+void ScenarioQuotes::parallelShift(int scenario, double shift)
+{
+    for(int j = 0; j < numQuotes(); j ++)
+        at(j, scenario) += shift;
+}
+
+void ScenarioQuotes::shift(int scenario, const std::vector<double>& shifts)
+{
+    for(int j = 0; j < numQuotes() && j < (int)shifts.size(); j ++)
+        at(j, scenario) += shifts[j];
+}
+
+//////////////////////////////////////////
+// Definition of the class ScenarioCurveSet
+//////////////////////////////////////////
+ScenarioCurveSet::ScenarioCurveSet(const YieldCurveDefinition& ycDef,
+        const ScenarioQuotes& quotes,
+        YieldCurveDefinition::CURVETYPE type,
+        const Date& asOf):
+    _type(type), _compoundFreq(ycDef._compoundFreq),
+    _numScenarios(quotes.numScenarios()),
+    _today(WorkDate(asOf))
+{
+    _plan(ycDef, quotes);
+
+    switch(_type)
+    {
+        case YieldCurveDefinition::ZEROCOUPONRATE:
+            _bootstrap(ZeroCouponRatePolicy(_compoundFreq), quotes);
+            break;
+        case YieldCurveDefinition::DISCOUNTFACTOR:
+            _bootstrap(DiscountFactorPolicy(_compoundFreq), quotes);
+            break;
+        case YieldCurveDefinition::CONTINUOUSRATE:
+            _bootstrap(ContinuousRatePolicy(_compoundFreq), quotes);
+            break;
+        case YieldCurveDefinition::LOGDISCOUNTFACTOR:
+            _bootstrap(LogDiscountFactorPolicy(_compoundFreq), quotes);
+            break;
+        default:
+            {
+                std::string errorMessage("Invalid Yield Curve"
+                        " Instance Type");
+                throw YieldCurveException(errorMessage);
+            }
+    }
+}
+
+ScenarioCurveSet::~ScenarioCurveSet()
+{
+}
+
+bool ScenarioCurveSet::_locate(const Date& date, int numPoints,
+        Lookup& lookup) const
+{
+    // The same points YieldCurveInstance::operator[] uses
+    std::vector<Date>::const_iterator begin = _pillarDates.begin();
+    std::vector<Date>::const_iterator end = begin + numPoints;
+    std::vector<Date>::const_iterator iter = std::lower_bound(begin, end, date);
+
+    if(iter != end && *iter == date)
+    {
+        lookup.lower = (int)(iter - begin);
+        lookup.upper = iter + 1 == end ? lookup.lower : lookup.lower + 1;
+    }
+    else if(iter == end || iter == begin)
+    {
+        return false;
+    }
+    else
+    {
+        lookup.upper = (int)(iter - begin);
+        lookup.lower = lookup.upper - 1;
+    }
+
+    lookup.upperWeight = Interpolation::linearInterpolation(
+            _pillarDates[lookup.lower], 0.0,
+            _pillarDates[lookup.upper], 1.0, date);
+    lookup.deltaT = normDiffDate(_today, date, Date::ACT365);
+    lookup.accrual = 1.0;
+    return true;
+}
+
+void ScenarioCurveSet::_lookup(const Date& date, int numPoints,
+        Lookup& lookup) const
+{
+    if(!_locate(date, numPoints, lookup))
+    {
+        std::string errorMessage("Cannot get the value on the "
+                "Yield Curve of the giving Date. The date is "
+                "out of the range.");
+        throw YieldCurveException(errorMessage);
+    }
+}
+
+void ScenarioCurveSet::_plan(const YieldCurveDefinition& ycDef,
+        const ScenarioQuotes& quotes)
+{
+    // The structure of bindData, without the values
+    InstrumentValues ids;
+    for(int j = 0; j < quotes.numQuotes(); j ++)
+        ids.values.push_back(std::make_pair(quotes.quoteIds()[j], 0.0));
+    ycDef._checkInstrumentIds(ids);
+
+    const std::vector<InstrumentDefinition>& instrDefs = ycDef._instrDefs;
+    Schedule::Dates pillarDates = ycDef.getPillarDates(_today);
+
+    std::vector<int> quoteOfDef(instrDefs.size(), -1);
+    int lastInstrDefID = -1;
+    for(int j = 0; j < quotes.numQuotes(); j ++)
+    {
+        int instrDefIndex = ycDef._definitionIndex(quotes.quoteIds()[j]);
+        quoteOfDef[instrDefIndex] = j;
+        lastInstrDefID = std::max(lastInstrDefID, instrDefIndex);
+    }
+
+    int prevInstrDefHasValue = 0;
+    int nextInstrDefHasValue = -1;
+    for(int i = 0; i < (int)instrDefs.size(); i ++)
+        if(quoteOfDef[i] >= 0)
+        {
+            nextInstrDefHasValue = i;
+            break;
+        }
+
+    std::vector<InstrumentDefinition::TYPE> pointTypes;
+    ResolvedInstrument instr;
+
+    for(int i = 0; i <= lastInstrDefID; i ++)
+    {
+        const InstrumentDefinition& instrDef = instrDefs[i];
+        Date maturityDate = pillarDates[i];
+        Step step;
+
+        if(i > nextInstrDefHasValue)
+        {
+            prevInstrDefHasValue = nextInstrDefHasValue;
+            for(int j = prevInstrDefHasValue + 1; j <= lastInstrDefID; j ++)
+                if(quoteOfDef[j] >= 0)
+                {
+                    nextInstrDefHasValue = j;
+                    break;
+                }
+        }
+
+        if(quoteOfDef[i] >= 0)
+        {
+            step.rateQuotes[0] = step.rateQuotes[1] = quoteOfDef[i];
+            step.rateWeights[0] = 1.0 / 100.0f;
+            step.rateWeights[1] = 0.0;
+        }
+        else
+        {
+            double endWeight = Interpolation::linearInterpolation(
+                    pillarDates[prevInstrDefHasValue], 0.0,
+                    pillarDates[nextInstrDefHasValue], 1.0, maturityDate);
+            step.rateQuotes[0] = quoteOfDef[prevInstrDefHasValue];
+            step.rateQuotes[1] = quoteOfDef[nextInstrDefHasValue];
+            step.rateWeights[0] = (1.0 - endWeight) / 100.0f;
+            step.rateWeights[1] = endWeight / 100.0f;
+        }
+
+        resolveInstrument(instrDef, _today, maturityDate, _compoundFreq,
+                instr);
+        step.type = instr.type;
+        step.deltaT = instr.accrual;
+        step.deltaTToMaturity = instr.deltaTToMaturity;
+        step.firstLookup = (int)_lookups.size();
+        int numPoints = (int)_pillarDates.size();
+        Lookup lookup;
+
+        // The dfs the step reads, at the start of a FRA or at the
+        // coupons of a swap before its maturity
+        if(instr.type == InstrumentDefinition::FRA)
+        {
+            _lookup(instr.startDate, numPoints, lookup);
+            _lookups.push_back(lookup);
+        }
+        for(int k = 0; k < (int)instr.couponDates.size(); k ++)
+        {
+            _lookup(instr.couponDates[k], numPoints, lookup);
+            lookup.accrual = instr.couponAccruals[k];
+            _lookups.push_back(lookup);
+        }
+        step.numLookups = (int)_lookups.size() - step.firstLookup;
+
+        // Where YieldCurveInstance::insert() would put the point
+        InstrumentDefinition::TYPE pointType = instrDef.type();
+        if(numPoints > 0 && _pillarDates.back() == maturityDate)
+        {
+            InstrumentDefinition::TYPE keptType = pointTypes.back();
+            if(pointType == InstrumentDefinition::SWAP ||
+                    (pointType == InstrumentDefinition::FRA &&
+                     keptType != InstrumentDefinition::SWAP) ||
+                    (pointType == InstrumentDefinition::CASH &&
+                     keptType == InstrumentDefinition::CASH))
+            {
+                step.point = numPoints - 1;
+                pointTypes.back() = pointType;
+                _pillarDeltaTs.back() = step.deltaTToMaturity;
+            }
+            else
+            {
+                step.point = -1;
+            }
+        }
+        else if(numPoints == 0 || _pillarDates.back() < maturityDate)
+        {
+            step.point = numPoints;
+            _pillarDates.push_back(maturityDate);
+            _pillarDeltaTs.push_back(step.deltaTToMaturity);
+            pointTypes.push_back(pointType);
+        }
+        else
+        {
+            std::string errorMessage("The pillar dates of the curve "
+                    "definition are not ascending");
+            throw YieldCurveException(errorMessage);
+        }
+
+        _steps.push_back(step);
+    }
+}
+
+template<class POLICY>
+void ScenarioCurveSet::_lookupDfs(const POLICY& policy,
+        const Lookup& lookup, double *dfs) const
+{
+    int numScenarios = _numScenarios;
+
+    // On a pillar, the df itself
+    if(lookup.upperWeight == 0.0 &&
+            lookup.deltaT == _pillarDeltaTs[lookup.lower])
+    {
+        const double *__restrict__ pillarDfs = &_dfs[lookup.lower * numScenarios];
+        for(int s = 0; s < numScenarios; s ++)
+            dfs[s] = pillarDfs[s];
+        return;
+    }
+
+    const double *__restrict__ lower = &_values[lookup.lower * numScenarios];
+    const double *__restrict__ upper = &_values[lookup.upper * numScenarios];
+    double weight = lookup.upperWeight;
+    double deltaT = lookup.deltaT;
+    for(int s = 0; s < numScenarios; s ++)
+        dfs[s] = policy.toDf(lower[s] + weight * (upper[s] - lower[s]), deltaT);
+}
+
+template<class POLICY>
+void ScenarioCurveSet::_bootstrap(const POLICY& policy,
+        const ScenarioQuotes& quotes)
+{
+    int numScenarios = _numScenarios;
+    int numPillars = (int)_pillarDates.size();
+    _values.assign(numPillars * numScenarios, 0.0);
+    _dfs.assign(numPillars * numScenarios, 0.0);
+
+    std::vector<double> rateRow(numScenarios);
+    std::vector<double> sumRow(numScenarios);
+    std::vector<double> lookupRow(numScenarios);
+    std::vector<double> dfRow(numScenarios);
+    double *__restrict__ rates = &rateRow[0];
+    double *__restrict__ sums = &sumRow[0];
+    double *__restrict__ lookupDfs = &lookupRow[0];
+    double *__restrict__ dfs = &dfRow[0];
+
+    for(int i = 0; i < (int)_steps.size(); i ++)
+    {
+        const Step& step = _steps[i];
+
+        const double *__restrict__ quote0 = quotes.row(step.rateQuotes[0]);
+        const double *__restrict__ quote1 = quotes.row(step.rateQuotes[1]);
+        double weight0 = step.rateWeights[0];
+        double weight1 = step.rateWeights[1];
+        for(int s = 0; s < numScenarios; s ++)
+            rates[s] = weight0 * quote0[s] + weight1 * quote1[s];
+
+        double deltaT = step.deltaT;
+        switch(step.type)
+        {
+            case InstrumentDefinition::CASH:
+                for(int s = 0; s < numScenarios; s ++)
+                    dfs[s] = InstrumentPricing::cashDf(rates[s], deltaT);
+                break;
+            case InstrumentDefinition::FRA:
+                _lookupDfs(policy, _lookups[step.firstLookup], lookupDfs);
+                for(int s = 0; s < numScenarios; s ++)
+                    dfs[s] = InstrumentPricing::fraDf(rates[s], deltaT,
+                            lookupDfs[s]);
+                break;
+            case InstrumentDefinition::SWAP:
+                std::fill(sumRow.begin(), sumRow.end(), 0.0);
+                for(int k = 0; k < step.numLookups; k ++)
+                {
+                    const Lookup& lookup = _lookups[step.firstLookup + k];
+                    _lookupDfs(policy, lookup, lookupDfs);
+                    double accrual = lookup.accrual;
+                    for(int s = 0; s < numScenarios; s ++)
+                        sums[s] += accrual * lookupDfs[s];
+                }
+                for(int s = 0; s < numScenarios; s ++)
+                    dfs[s] = InstrumentPricing::swapDf(rates[s], deltaT,
+                            sums[s]);
+                break;
+            default:
+                break;
+        }
+
+        if(step.point < 0)
+            continue;
+
+        double *__restrict__ values = &_values[step.point * numScenarios];
+        double *__restrict__ pillarDfs = &_dfs[step.point * numScenarios];
+        double deltaTToMaturity = step.deltaTToMaturity;
+        for(int s = 0; s < numScenarios; s ++)
+        {
+            values[s] = policy.fromDf(dfs[s], deltaTToMaturity);
+            pillarDfs[s] = policy.toDf(values[s], deltaTToMaturity);
+        }
+    }
+}
+
+template<class POLICY>
+void ScenarioCurveSet::_getDfs(const POLICY& policy,
+        const std::vector<Date>& dates, std::vector<double>& dfs,
+        std::vector<char>& found) const
+{
+    int numDates = (int)dates.size();
+    dfs.resize(numDates * _numScenarios);
+    found.resize(numDates);
+
+    for(int i = 0; i < numDates; i ++)
+    {
+        Lookup lookup;
+        found[i] = _locate(WorkDate(dates[i]),
+                (int)_pillarDates.size(), lookup);
+        if(found[i])
+            _lookupDfs(policy, lookup, &dfs[i * _numScenarios]);
+    }
+}
+
+void ScenarioCurveSet::getDfs(const std::vector<Date>& dates,
+        std::vector<double>& dfs, std::vector<char>& found) const
+{
+    switch(_type)
+    {
+        case YieldCurveDefinition::ZEROCOUPONRATE:
+            _getDfs(ZeroCouponRatePolicy(_compoundFreq), dates, dfs, found);
+            break;
+        case YieldCurveDefinition::DISCOUNTFACTOR:
+            _getDfs(DiscountFactorPolicy(_compoundFreq), dates, dfs, found);
+            break;
+        case YieldCurveDefinition::CONTINUOUSRATE:
+            _getDfs(ContinuousRatePolicy(_compoundFreq), dates, dfs, found);
+            break;
+        case YieldCurveDefinition::LOGDISCOUNTFACTOR:
+            _getDfs(LogDiscountFactorPolicy(_compoundFreq), dates, dfs, found);
+            break;
+        default:
+            break;
+    }
+}
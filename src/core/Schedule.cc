@@ -0,0 +1,282 @@
+#include <pthread.h>
+#include <stdint.h>
+
+#include "Schedule.h"
+
+struct Schedule::Dates::Shared
+{
+    volatile int references;
+    std::vector<Date> dates;
+};
+
+namespace
+{
+    typedef Schedule::Dates::Shared SharedDates;
+
+    const int numShards = 16;
+    const int entriesPerShard = 32;
+
+    struct CacheEntry
+    {
+        uint64_t hash;
+        long asOf;
+        unsigned long calendarId;
+        std::vector<Tenor> tenors;
+        // The reference of the cache
+        SharedDates *shared;
+        uint64_t lastUsed;
+    };
+
+    struct Shard
+    {
+        Shard():clock(0){pthread_mutex_init(&lock, NULL);}
+
+        pthread_mutex_t lock;
+        // Guarded by lock
+        std::vector<CacheEntry> entries;
+        uint64_t clock;
+    };
+
+    Shard *shards()
+    {
+        static Shard theShards[numShards];
+        return theShards;
+    }
+
+    class ScopedLock
+    {
+        public:
+            explicit ScopedLock(pthread_mutex_t& lock):
+                _lock(lock){pthread_mutex_lock(&_lock);}
+            ~ScopedLock(){pthread_mutex_unlock(&_lock);}
+
+        private:
+            pthread_mutex_t& _lock;
+    };
+
+    inline void acquire(SharedDates *shared)
+    {
+        __sync_add_and_fetch(&shared->references, 1);
+    }
+
+    inline void release(SharedDates *shared)
+    {
+        if(__sync_sub_and_fetch(&shared->references, 1) == 0)
+            delete shared;
+    }
+
+    // FNV-1a over the words of a key
+    inline uint64_t mix(uint64_t hash, uint64_t value)
+    {
+        return (hash ^ value) * 1099511628211ULL;
+    }
+
+    // The tenors of a schedule, generated on the fly so a lookup
+    // does not build a vector of them
+    struct TenorList
+    {
+        explicit TenorList(const std::vector<Duration>& tenors):
+            _tenors(tenors){};
+        inline int size() const {return (int)_tenors.size();}
+        inline Tenor operator[](int i) const {return _tenors[i].tenor();}
+
+        const std::vector<Duration>& _tenors;
+    };
+
+    // Multiples of the exact tenor of the period
+    struct PeriodicTenors
+    {
+        PeriodicTenors(const Duration& period, int n):
+            _period(period.tenor()), _n(n > 0 ? n : 0){};
+        inline int size() const {return _n;}
+        inline Tenor operator[](int i) const {return _period * (i + 1);}
+
+        Tenor _period;
+        int _n;
+    };
+
+    struct SingleTenor
+    {
+        explicit SingleTenor(const Duration& tenor):_tenor(tenor.tenor()){};
+        inline int size() const {return 1;}
+        inline Tenor operator[](int) const {return _tenor;}
+
+        Tenor _tenor;
+    };
+
+    template<class TENORS>
+    bool matches(const CacheEntry& entry, uint64_t hash, long asOf,
+            unsigned long calendarId, const TENORS& tenors)
+    {
+        if(entry.hash != hash || entry.asOf != asOf ||
+                entry.calendarId != calendarId ||
+                (int)entry.tenors.size() != tenors.size())
+            return false;
+
+        for(int i = 0; i < tenors.size(); i ++)
+            if(entry.tenors[i] != tenors[i])
+                return false;
+        return true;
+    }
+
+    // The cached schedule with a new reference, NULL if none;
+    // with the lock of the shard held
+    template<class TENORS>
+    SharedDates *find(Shard& shard, uint64_t hash, long asOf,
+            unsigned long calendarId, const TENORS& tenors)
+    {
+        for(int i = 0; i < (int)shard.entries.size(); i ++)
+        {
+            CacheEntry& entry = shard.entries[i];
+            if(matches(entry, hash, asOf, calendarId, tenors))
+            {
+                entry.lastUsed = ++ shard.clock;
+                acquire(entry.shared);
+                return entry.shared;
+            }
+        }
+        return NULL;
+    }
+
+    template<class TENORS>
+    Schedule::Dates lookup(const Date& asOf, const TENORS& tenors,
+            const Calendar& calendar)
+    {
+        long day = (long)asOf.get().day_number();
+        unsigned long calendarId = calendar.id();
+        uint64_t hash = mix(mix(mix(14695981039346656037ULL, day),
+                    calendarId), tenors.size());
+        for(int i = 0; i < tenors.size(); i ++)
+        {
+            Tenor tenor = tenors[i];
+            hash = mix(mix(hash, tenor.months()), tenor.days());
+        }
+
+        Shard& shard = shards()[hash % numShards];
+        {
+            ScopedLock lock(shard.lock);
+            SharedDates *shared = find(shard, hash, day, calendarId, tenors);
+            if(shared != NULL)
+                return Schedule::Dates(shared);
+        }
+
+        // Generate outside of the lock, if another thread inserts
+        // the same schedule meanwhile its dates are kept
+        CacheEntry entry;
+        entry.hash = hash;
+        entry.asOf = day;
+        entry.calendarId = calendarId;
+        entry.tenors.reserve(tenors.size());
+        entry.shared = new SharedDates();
+        entry.shared->references = 1;
+        entry.shared->dates.reserve(tenors.size());
+        for(int i = 0; i < tenors.size(); i ++)
+        {
+            entry.tenors.push_back(tenors[i]);
+            entry.shared->dates.push_back(calendar.adjust(asOf + entry.tenors[i]));
+        }
+
+        ScopedLock lock(shard.lock);
+        SharedDates *shared = find(shard, hash, day, calendarId, tenors);
+        if(shared != NULL)
+        {
+            release(entry.shared);
+            return Schedule::Dates(shared);
+        }
+
+        acquire(entry.shared);
+        entry.lastUsed = ++ shard.clock;
+        if((int)shard.entries.size() < entriesPerShard)
+        {
+            shard.entries.push_back(entry);
+        }
+        else
+        {
+            int oldest = 0;
+            for(int i = 1; i < (int)shard.entries.size(); i ++)
+                if(shard.entries[i].lastUsed < shard.entries[oldest].lastUsed)
+                    oldest = i;
+
+            release(shard.entries[oldest].shared);
+            shard.entries[oldest] = entry;
+        }
+        return Schedule::Dates(entry.shared);
+    }
+}
+
+//////////////////////////////////////////
+// Definition of the class Schedule::Dates
+//////////////////////////////////////////
+Schedule::Dates::Dates(Shared *shared):
+    _shared(shared), _dates(&shared->dates)
+{
+}
+
+Schedule::Dates::Dates(const Dates& rhs):
+    _shared(rhs._shared), _dates(rhs._dates)
+{
+    acquire(_shared);
+}
+
+Schedule::Dates& Schedule::Dates::operator=(const Dates& rhs)
+{
+    acquire(rhs._shared);
+    release(_shared);
+    _shared = rhs._shared;
+    _dates = rhs._dates;
+    return *this;
+}
+
+Schedule::Dates::~Dates()
+{
+    release(_shared);
+}
+
+//////////////////////////////////////////
+// Definition of the class Schedule
+//////////////////////////////////////////
+Schedule::Dates Schedule::tenorDates(const Date& asOf,
+        const std::vector<Duration>& tenors, const Calendar& calendar)
+{
+    return lookup(asOf, TenorList(tenors), calendar);
+}
+
+Schedule::Dates Schedule::periodicDates(const Date& asOf,
+        const Duration& period, int n, const Calendar& calendar)
+{
+    return lookup(asOf, PeriodicTenors(period, n), calendar);
+}
+
+Date Schedule::tenorDate(const Date& asOf, const Duration& tenor,
+        const Calendar& calendar)
+{
+    return lookup(asOf, SingleTenor(tenor), calendar)[0];
+}
+
+size_t Schedule::size()
+{
+    size_t numSchedules = 0;
+    for(int s = 0; s < numShards; s ++)
+    {
+        ScopedLock lock(shards()[s].lock);
+        numSchedules += shards()[s].entries.size();
+    }
+    return numSchedules;
+}
+
+size_t Schedule::capacity()
+{
+    return (size_t)numShards * entriesPerShard;
+}
+
+void Schedule::clear()
+{
+    for(int s = 0; s < numShards; s ++)
+    {
+        Shard& shard = shards()[s];
+        ScopedLock lock(shard.lock);
+        for(int i = 0; i < (int)shard.entries.size(); i ++)
+            release(shard.entries[i].shared);
+        shard.entries.clear();
+    }
+}
@@ -0,0 +1,177 @@
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "Trace.h"
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        const char *argName;
+        int64_t arg;
+        uint64_t beginNs;
+        uint64_t endNs;
+    };
+
+    // The events of one thread. Only the owner writes them: it
+    // claims the slot of the next event, writes the event and then
+    // moves the head past it, so a reader knows which slots are
+    // complete and which may have changed while it read them.
+    struct EventRing
+    {
+        int thread;
+        size_t mask;
+        Event *events;
+        volatile size_t claimed;
+        volatile size_t head;
+    };
+
+    // The rings are kept after their threads exit, to be exported
+    pthread_mutex_t ringsLock = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<EventRing *> rings;
+    size_t ringCapacity = 1 << 16;
+    uint64_t originNs = 0;
+    std::string exitFilename;
+
+    __thread EventRing *threadRing = NULL;
+
+    EventRing& localRing()
+    {
+        if(threadRing != NULL)
+            return *threadRing;
+
+        EventRing *ring = new EventRing();
+        ring->mask = ringCapacity - 1;
+        ring->events = new Event[ringCapacity];
+        ring->claimed = ring->head = 0;
+
+        pthread_mutex_lock(&ringsLock);
+        ring->thread = (int)rings.size();
+        rings.push_back(ring);
+        pthread_mutex_unlock(&ringsLock);
+
+        threadRing = ring;
+        return *ring;
+    }
+
+    // The events of the ring which are not being overwritten
+    void copyEvents(const EventRing& ring, std::vector<Event>& events)
+    {
+        size_t capacity = ring.mask + 1;
+        size_t head = ring.head;
+        __sync_synchronize();
+        size_t first = head > capacity ? head - capacity : 0;
+        std::vector<Event> copied;
+        copied.reserve(head - first);
+        for(size_t i = first; i < head; i ++)
+            copied.push_back(ring.events[i & ring.mask]);
+
+        // The writer may have moved on while we read, the slots it
+        // claimed since are left out
+        __sync_synchronize();
+        size_t claimed = ring.claimed;
+        size_t valid = claimed > capacity ? claimed - capacity : 0;
+        for(size_t i = first; i < head; i ++)
+        {
+            if(i >= valid)
+                events.push_back(copied[i - first]);
+        }
+    }
+
+    void writeAtExit()
+    {
+        Trace::writeJson(exitFilename);
+    }
+}
+
+volatile bool Trace::tracing = false;
+
+void Trace::enable(size_t eventsPerThread)
+{
+    size_t capacity = 1;
+    while(capacity < eventsPerThread)
+        capacity <<= 1;
+
+    pthread_mutex_lock(&ringsLock);
+    ringCapacity = capacity;
+    originNs = Profiler::now();
+    pthread_mutex_unlock(&ringsLock);
+
+    __sync_synchronize();
+    tracing = true;
+}
+
+void Trace::complete(const char *name, uint64_t beginNs, uint64_t endNs,
+        const char *argName, int64_t arg)
+{
+    EventRing& ring = localRing();
+    size_t head = ring.head;
+    ring.claimed = head + 1;
+    __sync_synchronize();
+    Event& event = ring.events[head & ring.mask];
+    event.name = name;
+    event.argName = argName;
+    event.arg = arg;
+    event.beginNs = beginNs;
+    event.endNs = endNs;
+    // Publish the event before the new head
+    __sync_synchronize();
+    ring.head = head + 1;
+}
+
+void Trace::writeJson(std::ostream& out)
+{
+    std::vector<EventRing *> allRings;
+    pthread_mutex_lock(&ringsLock);
+    allRings = rings;
+    pthread_mutex_unlock(&ringsLock);
+
+    int pid = (int)getpid();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for(int r = 0; r < (int)allRings.size(); r ++)
+    {
+        int thread = allRings[r]->thread;
+        out << (first ? "" : ",\n") <<
+            "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid <<
+            ", \"tid\": " << thread << ", \"args\": {\"name\": \"thread " <<
+            thread << "\"}}";
+        first = false;
+
+        std::vector<Event> events;
+        copyEvents(*allRings[r], events);
+        for(int i = 0; i < (int)events.size(); i ++)
+        {
+            const Event& event = events[i];
+            out << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", " <<
+                "\"pid\": " << pid << ", \"tid\": " << thread << ", " <<
+                "\"ts\": " << (double)(int64_t)(event.beginNs - originNs) / 1000.0 << ", " <<
+                "\"dur\": " << (double)(event.endNs - event.beginNs) / 1000.0;
+            if(event.argName != NULL)
+                out << ", \"args\": {\"" << event.argName << "\": " << event.arg << "}";
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+void Trace::writeJson(const std::string& filename)
+{
+    std::ofstream fout(filename.c_str());
+    if(fout.good())
+        writeJson(fout);
+}
+
+void Trace::writeOnExit(const std::string& filename)
+{
+    bool first = exitFilename.empty();
+    exitFilename = filename;
+    if(first)
+        atexit(writeAtExit);
+}
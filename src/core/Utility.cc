@@ -3,6 +3,7 @@
 #include <sstream>
 #include <stdexcept>
 #include "Utility.h"
+#include "Profiler.h"
 
 using namespace Volatility;
 using namespace RandomNumberGenerator;
@@ -70,14 +71,17 @@ double NewtonRaphsonMethod::operator()(const FormulaClass& formula,
 {
     double currX, nextX;
     double fx, fpx;
+    int iterations = 0;
     currX = formula.getInitialGuess();
     fx = formula.f(currX);
 
     while(fabs(fx) >= maxError)
     {
+        iterations ++;
         fpx = formula.fprime(currX);
         if(fpx == 0)
         {
+            PROFILE_COUNT("newtonIterations", iterations);
             std::ostringstream oss;
             oss << "f'(" << currX << ") == 0";
             std::string errorMessage(oss.str());
@@ -87,6 +91,7 @@ double NewtonRaphsonMethod::operator()(const FormulaClass& formula,
         currX = nextX;
         fx = formula.f(currX);
     };
+    PROFILE_COUNT("newtonIterations", iterations);
 
     return currX;
 }
@@ -100,8 +105,8 @@ void boxMullerM2RNG::_genNumbers()
     
     do
     {
-        x = (double)(rand() % 10001) / 5000.0 - 1.0;
-        y = (double)(rand() % 10001) / 5000.0 - 1.0;
+        x = (double)(_uniform() % 10001) / 5000.0 - 1.0;
+        y = (double)(_uniform() % 10001) / 5000.0 - 1.0;
         r = x * x + y * y;
     }while(r >= 1.0 || r == 0);
 
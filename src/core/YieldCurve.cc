@@ -3,21 +3,245 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <limits>
+#include <map>
 
 #include "YieldCurve.h"
 #include "Instrument.h"
 #include "Date.h"
 #include "Utility.h"
+#include "Schedule.h"
+#include "ColumnarFile.h"
 
 
+namespace
+{
+    // The gradients of the dfs of the curve points to the quotes,
+    // propagated through the bootstrap when a jacobian is wanted
+    typedef std::map<Date, std::vector<double> > PointGradients;
+
+    // gradient += scale * rhs
+    inline void addScaled(std::vector<double>& gradient, double scale,
+            const std::vector<double>& rhs)
+    {
+        for(int i = 0; i < (int)gradient.size(); i ++)
+            gradient[i] += scale * rhs[i];
+    }
+
+    // The points of a curve as its lookups read them, the dates
+    // as day counts: the ones the curve holds
+    class HeldPoints
+    {
+        public:
+            explicit HeldPoints(const std::vector<CurvePoint_t>& points):
+                _points(points){};
+
+            static inline long dayOf(const Date& date)
+                {return (long)date.get().day_number();}
+
+            inline int size() const {return (int)_points.size();}
+            inline long day(int i) const {return dayOf(_points[i].date);}
+            inline Date date(int i) const {return _points[i].date;}
+            inline double value(int i) const {return _points[i].value;}
+            inline double deltaT(int i) const {return _points[i].deltaT;}
+            inline InstrumentDefinition::TYPE instrType(int i) const
+                {return _points[i].instrType;}
+
+        private:
+            const std::vector<CurvePoint_t>& _points;
+    };
+
+    // and the ones of a view, read in place
+    class ViewPoints
+    {
+        public:
+            explicit ViewPoints(const CurvePointArrays& points):
+                _points(points){};
+
+            static inline long dayOf(const Date& date)
+                {return Columnar::toDate32(date);}
+
+            inline int size() const {return _points.numPoints;}
+            inline long day(int i) const {return _points.dates[i];}
+            inline Date date(int i) const
+                {return Columnar::fromDate32(_points.dates[i]);}
+            inline double value(int i) const {return _points.values[i];}
+            inline double deltaT(int i) const {return _points.deltaTs[i];}
+            inline InstrumentDefinition::TYPE instrType(int) const
+                {return InstrumentDefinition::FAKE;}
+
+        private:
+            const CurvePointArrays& _points;
+    };
+
+    // The first of the first numPoints points not before the day
+    template<class POINTS>
+    int lowerBound(const POINTS& points, int numPoints, long day)
+    {
+        int first = 0;
+        while(numPoints > 0)
+        {
+            int half = numPoints / 2;
+            if(points.day(first + half) < day)
+            {
+                first += half + 1;
+                numPoints -= half + 1;
+            }
+            else
+            {
+                numPoints = half;
+            }
+        }
+
+        return first;
+    }
+
+    // Interpolation::linearInterpolation on day counts
+    inline double interpolate(long day1, double value1, long day2,
+            double value2, long day)
+    {
+        if(day1 == day2)
+            return value1;
+
+        return value1 + (double)(day - day1) * (value2 - value1) /
+            (double)(day2 - day1);
+    }
+
+    // Bind the values of one historical date
+    class BindJob : public Concurrency::Runnable
+    {
+        public:
+            BindJob(YieldCurveDefinition& ycDef, InstrumentValues& values,
+                    const Date& asOf, YieldCurveDefinition::CURVETYPE type,
+                    YieldCurveInstance *& curve):
+                _ycDef(ycDef), _values(values), _asOf(asOf),
+                _type(type), _curve(curve){};
+
+            virtual void run()
+            {
+                _curve = _ycDef.bindData(&_values, _type, _asOf);
+            }
+
+        private:
+            YieldCurveDefinition& _ycDef;
+            InstrumentValues& _values;
+            Date _asOf;
+            YieldCurveDefinition::CURVETYPE _type;
+            YieldCurveInstance *& _curve;
+    };
+
+    // The par rate strip of one curve of a batch
+    class StripJob : public Concurrency::Runnable
+    {
+        public:
+            StripJob(const YieldCurveInstance& curve,
+                    const std::vector<Duration>& tenors,
+                    double compoundFreq, ParRateStrip& strip):
+                _curve(curve), _tenors(tenors),
+                _compoundFreq(compoundFreq), _strip(strip){};
+
+            virtual void run()
+            {
+                Schedule::Dates maturityDates =
+                    Schedule::tenorDates(_curve.startDate(), _tenors);
+                getParRateStrip(_curve, maturityDates.get(), _compoundFreq, _strip);
+            }
+
+        private:
+            const YieldCurveInstance& _curve;
+            const std::vector<Duration>& _tenors;
+            double _compoundFreq;
+            ParRateStrip& _strip;
+    };
+
+    class ScopedLock
+    {
+        public:
+            explicit ScopedLock(pthread_mutex_t& lock):
+                _lock(lock){pthread_mutex_lock(&_lock);}
+            ~ScopedLock(){pthread_mutex_unlock(&_lock);}
+
+        private:
+            pthread_mutex_t& _lock;
+    };
+}
+
+// A bootstrap in progress, kept so it can be resumed pillar by
+// pillar when the curve is queried further out. It is owned by
+// the curve it solves once attached, and only used with the
+// lock of the curve held.
+class CurveBootstrap
+{
+    public:
+        // Nothing is solved yet; withGradients propagates the
+        // derivatives to the quotes for getJacobian()
+        CurveBootstrap(const YieldCurveDefinition& ycDef,
+                const InstrumentValues& instrVals, const Date& today,
+                YieldCurveInstance& curve, bool withGradients);
+
+        // Hand over to the curve, which solves on demand
+        void attach();
+
+        inline bool done() const {return _next > _lastInstrDefID;}
+
+        // Solve until a point after the date is published to
+        // the readers of the curve, or until done
+        void solveBeyond(const Date& date);
+        void solveAll();
+
+        void getJacobian(CurveJacobian& jacobian) const;
+
+    private:
+        // Solve the next pillar
+        void _solveNext();
+        // Publish the points no later pillar can move or replace
+        void _publish();
+
+        // The df of a date and its gradient on the points solved
+        // so far, published or not
+        double _df(Date& date) const;
+        void _dfGradient(Date& date, std::vector<double>& gradient) const;
+
+        YieldCurveInstance& _curve;
+        Date _today;
+        double _compoundFreq;
+        // The definitions up to the last one with a value and
+        // their maturity dates
+        std::vector<InstrumentDefinition> _instrDefs;
+        std::vector<Date> _pillarDates;
+        // _minPillarDates[i] is the earliest of the pillar dates
+        // from i on, no later pillar inserts a point before it
+        std::vector<Date> _minPillarDates;
+        std::vector<std::pair<int, double> > _values;
+
+        // the instrument value index of every instrument
+        // definition, -1 if it has no value
+        std::vector<int> _instrValIndices;
+        // last instrument definition that has value
+        int _lastInstrDefID;
+        int _prevInstrDefHasValue;
+        int _nextInstrDefHasValue;
+        // the next pillar to solve
+        int _next;
+
+        bool _withGradients;
+        int _numQuotes;
+        PointGradients _pointGradients;
+        // d df / d quotes and d compRate / d quotes of the current
+        // instrument, only maintained for the jacobian
+        std::vector<double> _gradient;
+        std::vector<double> _rateGradient;
+        // The instrument of the current pillar, its coupons kept
+        // from pillar to pillar
+        ResolvedInstrument _instr;
+};
+
 //////////////////////////////////////////
 // Definition of the class YieldCurveDefinition
 //////////////////////////////////////////
-YieldCurveDefinition::YieldCurveDefinition(std::vector<InstrumentDefinition *>& instrDefs, double compoundFreq):
-    _compoundFreq(compoundFreq)
-{
-    _instrDefs = instrDefs;
-    
+YieldCurveDefinition::YieldCurveDefinition(const std::vector<InstrumentDefinition>& instrDefs, double compoundFreq):
+    _instrDefs(instrDefs), _compoundFreq(compoundFreq)
+{    
     // check if there are at least three instrument 
     // Definitions, which should at least include O/N
     // and 3M
@@ -25,10 +249,10 @@ YieldCurveDefinition::YieldCurveDefinition(std::vector<InstrumentDefinition *>&
     bool find3M = false;
     for(int i = 0; i < (int)_instrDefs.size(); i ++)
     {
-        Duration duration = _instrDefs[i]->maturity();
-        if(duration.getDuration(Duration::DAY) == 1)
+        const Tenor& tenor = _instrDefs[i].maturityTenor();
+        if(tenor == Tenor(0, 1))
             findON = true;
-        if(duration.getDuration(Duration::MONTH) == 3)
+        if(tenor == Tenor(3, 0))
             find3M = true;
 
         if(findON && find3M)
@@ -52,47 +276,40 @@ YieldCurveDefinition::YieldCurveDefinition(std::vector<InstrumentDefinition *>&
     // interpolation
     _insertFakeInstrumentDefs();
 
+    _maturities.clear();
+    for(int i = 0; i < (int)_instrDefs.size(); i ++)
+        _maturities.push_back(_instrDefs[i].maturity());
+
     // Build mapping between instrument index to 
     // the instrument definition location in the vector
-    std::map<int, int>().swap(_instrDefIndicesMap);
+    _instrDefIndices.clear();
     for(int i = 0; i < (int)_instrDefs.size(); i ++)
     {
-        int index = _instrDefs[i]->index();
+        int index = _instrDefs[i].index();
         
         if(index >= 0)
-            _instrDefIndicesMap[_instrDefs[i]->index()] = i;    
+            _instrDefIndices.push_back(std::make_pair(index, i));
     }
+    std::sort(_instrDefIndices.begin(), _instrDefIndices.end());
 }
 
 YieldCurveDefinition::~YieldCurveDefinition()
 {
-    std::vector<InstrumentDefinition *>::iterator iter;
-    // dispose all the fake instrument
-    for(iter = _instrDefs.begin(); iter != _instrDefs.end(); iter ++)
-    {
-        InstrumentDefinition* ptrInstrDef = *iter;
-        if(ptrInstrDef->type() == InstrumentDefinition::FAKE)
-        {
-            _instrDefs.erase(iter);
-            delete ptrInstrDef;
-        }
-    }
-
 }
 
 
 void YieldCurveDefinition::_insertFakeInstrumentDefs()
 {
-    std::vector<InstrumentDefinition *> instrDefsCopy(_instrDefs);
+    std::vector<InstrumentDefinition> instrDefsCopy(_instrDefs);
 
-    std::vector<InstrumentDefinition *>::iterator iterCurr =
+    std::vector<InstrumentDefinition>::const_iterator iterCurr =
         _instrDefs.begin();
 
     iterCurr ++;
 
     while(iterCurr != _instrDefs.end())
     {
-        InstrumentDefinition& currInstrDef = *(*iterCurr);
+        const InstrumentDefinition& currInstrDef = *iterCurr;
 
 
         switch(currInstrDef.type())
@@ -104,27 +321,21 @@ void YieldCurveDefinition::_insertFakeInstrumentDefs()
             case InstrumentDefinition::FRA:
                 {
                     // We need the df of the start Date
-                    Duration startDuration(
-                            dynamic_cast<FRAInstrDefinition&>
-                            (currInstrDef).startDuration()
-                            );
+                    Duration startDuration(currInstrDef.startDuration());
                     
-                    std::pair<std::vector<InstrumentDefinition *>::iterator,
-                        std::vector<InstrumentDefinition*>::iterator> result;
-
-                    // Allocate the Fake Instrument Definition
-                    // using the startDuration first,
-                    // and then use InstrumentDefinitionCompare()
-                    // as the comparator
-                    InstrumentDefinition *stubInstr = new FAKEInstrDefinition(
+                    std::pair<std::vector<InstrumentDefinition>::iterator,
+                        std::vector<InstrumentDefinition>::iterator> result;
+
+                    // Look up the Fake Instrument Definition
+                    // of the startDuration, using
+                    // InstrumentDefinitionCompare() as the comparator
+                    InstrumentDefinition fakeInstr(InstrumentDefinition::FAKE,
                             startDuration, -1);
 
                     // FIX: actually the upper bound can be 
                     // the current iterator instead of iterEnd
                     result = std::equal_range(instrDefsCopy.begin(), instrDefsCopy.end(),
-                            stubInstr, InstrumentDefinitionCompare());
-
-                    delete stubInstr;
+                            fakeInstr, InstrumentDefinitionCompare());
 
                     // The definition is already there
                     // So break, no need to interpolate
@@ -137,9 +348,7 @@ void YieldCurveDefinition::_insertFakeInstrumentDefs()
                     // Mark the index as -1 to indicate
                     // this is a manually inserted fake
                     // Instrument Definition
-                    InstrumentDefinition *ptrNewInstrDef = 
-                        new FAKEInstrDefinition(startDuration, -1);
-                    instrDefsCopy.insert(result.first, ptrNewInstrDef);  
+                    instrDefsCopy.insert(result.first, fakeInstr);  
                     break;
                 }
             case InstrumentDefinition::SWAP:
@@ -153,29 +362,25 @@ void YieldCurveDefinition::_insertFakeInstrumentDefs()
 
                     // Check all the necessary instrument, and
                     // add if there is no cooresponding definition
-                    int n = floor(maturityDuration / deltaDuration);
+                    int n = maturityDuration.periods(deltaDuration);
                     for(int i = 1; i < n; i ++)
                     {
                         Duration currDuration = deltaDuration * i;
 
-                        InstrumentDefinition *stubInstr = new FAKEInstrDefinition(
+                        InstrumentDefinition fakeInstr(InstrumentDefinition::FAKE,
                                 currDuration, -1);
 
-                        std::pair<std::vector<InstrumentDefinition *>::iterator,
-                            std::vector<InstrumentDefinition *>::iterator> result;
+                        std::pair<std::vector<InstrumentDefinition>::iterator,
+                            std::vector<InstrumentDefinition>::iterator> result;
 
                         result = std::equal_range(instrDefsCopy.begin(),
-                                instrDefsCopy.end(), stubInstr,
+                                instrDefsCopy.end(), fakeInstr,
                                 InstrumentDefinitionCompare());
 
-                        delete stubInstr;
-
                         if(result.first != result.second)
                             continue;
 
-                        InstrumentDefinition *ptrNewInstrDef = 
-                            new FAKEInstrDefinition(currDuration, -1);
-                        instrDefsCopy.insert(result.first, ptrNewInstrDef);  
+                        instrDefsCopy.insert(result.first, fakeInstr);  
                     }
                     break;
                 }
@@ -194,16 +399,32 @@ void YieldCurveDefinition::_insertFakeInstrumentDefs()
     _instrDefs.swap(instrDefsCopy);
 }
 
-YieldCurveInstance* YieldCurveDefinition::bindData(
-        InstrumentValues *instrVals,
-        YieldCurveDefinition::CURVETYPE type)
+int YieldCurveDefinition::_definitionIndex(int id) const
+{
+    std::vector<std::pair<int, int> >::const_iterator iter =
+        std::lower_bound(_instrDefIndices.begin(), _instrDefIndices.end(),
+                std::make_pair(id, -1));
+    if(iter == _instrDefIndices.end() || iter->first != id)
+        return -1;
+
+    return iter->second;
+}
+
+Schedule::Dates YieldCurveDefinition::getPillarDates(
+        const Date& asOf) const
+{
+    return Schedule::tenorDates(asOf, _maturities);
+}
+
+void YieldCurveDefinition::_checkInstrumentIds(
+        const InstrumentValues& instrVals) const
 {
     // Sanity check for the new values
-    for(std::vector<std::pair<int, double> >::iterator iter = instrVals->values.begin();
-            iter != instrVals->values.end(); iter ++)
+    for(std::vector<std::pair<int, double> >::const_iterator iter = instrVals.values.begin();
+            iter != instrVals.values.end(); iter ++)
     {
-        std::pair<int, double>& val = *iter;
-        if(_instrDefIndicesMap.find(val.first) == _instrDefIndicesMap.end())
+        const std::pair<int, double>& val = *iter;
+        if(_definitionIndex(val.first) < 0)
         {
             std::ostringstream oss;
             oss << "Invalid instrument data index " << val.first;
@@ -212,30 +433,28 @@ YieldCurveInstance* YieldCurveDefinition::bindData(
         }
     }
 
-    Date today = WorkDate(Date::today());
-
     // check if there are at least three instrument 
     // rata, which should at least include O/N
     // and 3M
     // TODO: Provide test case to cover this
     bool findON = false;
     bool find3M = false;
-    for(int i = 0; i < (int)instrVals->values.size(); i ++)
+    for(int i = 0; i < (int)instrVals.values.size(); i ++)
     {
-        int instrDefIndex = instrVals->values[i].first;
-        int instrDefVecIndex = _instrDefIndicesMap[instrDefIndex]; 
-        Duration duration = _instrDefs[instrDefVecIndex]->maturity();
+        int instrDefIndex = instrVals.values[i].first;
+        int instrDefVecIndex = _definitionIndex(instrDefIndex);
+        const Tenor& tenor = _instrDefs[instrDefVecIndex].maturityTenor();
 
-        if(duration.getDuration(Duration::DAY) == 1)
+        if(tenor == Tenor(0, 1))
             findON = true;
-        if(duration.getDuration(Duration::MONTH) == 3)
+        if(tenor == Tenor(3, 0))
             find3M = true;
 
         if(findON && find3M)
             break;
     }
 
-    if(!(findON && find3M) || (int)instrVals->values.size() < 3)
+    if(!(findON && find3M) || (int)instrVals.values.size() < 3)
     {
         std::string errorMessage("There should be"
                 "at least three instrument data, "
@@ -243,380 +462,996 @@ YieldCurveInstance* YieldCurveDefinition::bindData(
 
         throw YieldCurveException(errorMessage);
     }
+}
+
+YieldCurveInstance* YieldCurveDefinition::bindData(
+        InstrumentValues *instrVals,
+        YieldCurveDefinition::CURVETYPE type,
+        CurveJacobian *jacobian)
+{
+    return bindData(instrVals, type, WorkDate(Date::today()), jacobian);
+}
+
+YieldCurveInstance* YieldCurveDefinition::bindData(
+        InstrumentValues *instrVals,
+        YieldCurveDefinition::CURVETYPE type,
+        const Date& asOf,
+        CurveJacobian *jacobian)
+{
+    _checkInstrumentIds(*instrVals);
+
+    Date today = WorkDate(asOf);
 
     // Allocate new Yield Curve Instance
-    YieldCurveInstance *ptrNewInstance = NULL;
-    switch(type)
+    YieldCurveInstance *ptrNewInstance =
+        YieldCurveInstance::create(type, _compoundFreq, today);
+
+    if(jacobian == NULL)
     {
-        case YieldCurveDefinition::ZEROCOUPONRATE:
-            ptrNewInstance = new ZeroCouponRateCurve(
-                    _compoundFreq, today);
-            break;
-        default:
-            {
-                std::string errorMessage("Invalid Yield Curve"
-                        " Instance Type");
-                throw YieldCurveException(errorMessage);
-            }
+        // The curve owns the bootstrap and solves it on demand
+        (new CurveBootstrap(*this, *instrVals, today, *ptrNewInstance,
+                            false))->attach();
+        return ptrNewInstance;
     }
 
-    // map from the vector index of the instrument definition
-    // to the instrument value index
-    std::map<int, int> instrValIndicesMap;
-    std::vector<int> instrDefHasValue(_instrDefs.size());
-    // last instrument definition that has value
-    int lastInstrDefID = -1;
+    CurveBootstrap bootstrap(*this, *instrVals, today, *ptrNewInstance, true);
+    bootstrap.solveAll();
+    bootstrap.getJacobian(*jacobian);
+
+    return ptrNewInstance;
+}
 
-    for(int i = 0; i < (int)instrVals->values.size(); i ++)
+void YieldCurveDefinition::bindHistory(
+        std::vector<InstrumentValues>& values,
+        const std::vector<Date>& asOfs,
+        YieldCurveDefinition::CURVETYPE type, int numThreads,
+        std::vector<YieldCurveInstance *>& curves)
+{
+    if(values.size() != asOfs.size())
     {
-        std::pair<int, double>& val = instrVals->values[i];
-        int instrDefIndex = _instrDefIndicesMap[val.first];
+        std::string errorMessage("The number of historical values "
+                "and as-of dates differ");
+        throw YieldCurveException(errorMessage);
+    }
 
-        instrValIndicesMap[instrDefIndex] = i;
-        instrDefHasValue[instrDefIndex] = 1;
+    int numDates = (int)asOfs.size();
+    std::vector<YieldCurveInstance *> newCurves(numDates,
+            (YieldCurveInstance *)NULL);
+    std::vector<Concurrency::Runnable *> jobs;
+    for(int i = 0; i < numDates; i ++)
+        jobs.push_back(new BindJob(*this, values[i], asOfs[i], type,
+                    newCurves[i]));
 
-        if(instrDefIndex > lastInstrDefID)
-            lastInstrDefID = instrDefIndex;
+    try
+    {
+        Concurrency::runAll(jobs, numThreads);
     }
-
-    int prevInstrDefHasValue = 0;
-    int nextInstrDefHasValue = -1;
-    for(int i = 0; i < _instrDefs.size(); i ++)
-        if(instrDefHasValue[i] == 1)
-        {
-            nextInstrDefHasValue = i;
-            break;
-        }
-    
-    // TODO: Un-optimized brute force loop
-    // Loop start
-    for(int i = 0; i <= lastInstrDefID; i ++)
-    {
-        InstrumentDefinition& instrDef = *_instrDefs[i];
-        double df;
-        double deltaT;
-        double deltaTToMaturity;
-        double compRate;
-        Date maturityDate = WorkDate(today + instrDef.maturity());
-
-        if(i > nextInstrDefHasValue)
+    catch(Concurrency::ConcurrencyException& e)
+    {
+        for(int i = 0; i < numDates; i ++)
         {
-            prevInstrDefHasValue = nextInstrDefHasValue;
-            for(int j = prevInstrDefHasValue + 1; 
-                    j <= lastInstrDefID; j ++)
-                if(instrDefHasValue[j] == 1)
-                {
-                    nextInstrDefHasValue = j;
-                    break;
-                }
+            delete jobs[i];
+            delete newCurves[i];
         }
 
-        std::map<int, int>::iterator iter;
-        if((iter = instrValIndicesMap.find(i)) !=
-                instrValIndicesMap.end())
-        {
-            // If the definition has input compounding rate value
-            compRate = instrVals->values[(*iter).second].second 
-                / 100.0f;
-        }
-        else
-        {
-            // If we cannot find compounding rate value in its input,
-            // then use linear-interpolation to generate this value
-            std::pair<Date, double> startPoint(WorkDate(today + _instrDefs[prevInstrDefHasValue]->maturity()), instrVals->values[instrValIndicesMap[prevInstrDefHasValue]].second);
-            std::pair<Date, double> endPoint(WorkDate(today + _instrDefs[nextInstrDefHasValue]->maturity()), instrVals->values[instrValIndicesMap[nextInstrDefHasValue]].second);
-            compRate = Interpolation::linearInterpolation(
-                    startPoint, endPoint, maturityDate) / 100.0f;
-        }
+        std::string errorMessage(e.what());
+        throw YieldCurveException(errorMessage);
+    }
 
-        InstrumentDefinition::TYPE instrDefType = instrDef.type();
-        if(instrDefType == InstrumentDefinition::FAKE)
-        {
-            static const Duration threeMonth(1, Duration::MONTH);
-            static const Duration oneYear(1, Duration::YEAR);
-
-            if(instrDef.maturity() < threeMonth)
-                instrDefType = InstrumentDefinition::CASH;
-            else if(instrDef.maturity() < oneYear)
-                instrDefType = InstrumentDefinition::FRA;
-            else 
-                instrDefType = InstrumentDefinition::SWAP;
-        }
+    for(int i = 0; i < numDates; i ++)
+        delete jobs[i];
+    curves.swap(newCurves);
+}
 
+const InstrumentDefinition& 
+YieldCurveDefinition::getDefinitionByID(int id) const
+{
+    int index = _definitionIndex(id);
+    if(index >= 0)
+    {
+        return _instrDefs[index];
+    }
+    else
+    {
+        std::ostringstream oss;
+        oss << "Invalid instrument definition ID " <<
+            id;
+        std::string errorMessage(oss.str());
+        throw YieldCurveException(errorMessage);
+    }
+}
+//////////////////////////////////////////
+// Definition of the class CurveBootstrap
+//////////////////////////////////////////
+CurveBootstrap::CurveBootstrap(const YieldCurveDefinition& ycDef,
+        const InstrumentValues& instrVals, const Date& today,
+        YieldCurveInstance& curve, bool withGradients):
+    _curve(curve), _today(today), _compoundFreq(ycDef._compoundFreq),
+    _values(instrVals.values), _lastInstrDefID(-1), _next(0),
+    _withGradients(withGradients), _numQuotes((int)instrVals.values.size())
+{
+    _instrValIndices.assign(ycDef._instrDefs.size(), -1);
+    for(int i = 0; i < (int)_values.size(); i ++)
+    {
+        int instrDefIndex = ycDef._definitionIndex(_values[i].first);
 
-        switch(instrDefType)
-        {
-            case InstrumentDefinition::CASH:
-                {
-                    deltaT = normDiffDate(today, maturityDate,
-                            Date::ACT365);
-                    deltaTToMaturity = deltaT;
+        _instrValIndices[instrDefIndex] = i;
 
-                    df = 1.0f / (1.0f + compRate * deltaT);
-                    break;
-                }
-            case InstrumentDefinition::FRA:
-                {
-                    Duration startDuration; 
-                    if(instrDef.type() == InstrumentDefinition::FRA)
-                    {
-                        startDuration = 
-                            dynamic_cast<FRAInstrDefinition&>(instrDef).startDuration();
-                    }
-                    else
-                    {
-                        startDuration = 
-                            instrDef.maturity() - Duration(3, Duration::MONTH);
-                    }
+        if(instrDefIndex > _lastInstrDefID)
+            _lastInstrDefID = instrDefIndex;
+    }
 
-                    Date startDate = WorkDate(today + startDuration);
+    _prevInstrDefHasValue = 0;
+    _nextInstrDefHasValue = -1;
+    for(int i = 0; i < (int)_instrValIndices.size(); i ++)
+        if(_instrValIndices[i] >= 0)
+        {
+            _nextInstrDefHasValue = i;
+            break;
+        }
 
-                    deltaT = normDiffDate(startDate, maturityDate,
-                            Date::ACT365);
-                    deltaTToMaturity = normDiffDate(today, maturityDate,
-                            Date::ACT365);
+    Schedule::Dates pillarDates = ycDef.getPillarDates(today);
+    _instrDefs.assign(ycDef._instrDefs.begin(),
+            ycDef._instrDefs.begin() + _lastInstrDefID + 1);
+    _pillarDates.assign(pillarDates.get().begin(),
+            pillarDates.get().begin() + _lastInstrDefID + 1);
 
-                    double dfStart = ptrNewInstance->getDf(startDate);
-                    df = dfStart / (1.0f + compRate * deltaT);
-                    break;
-                }
-            case InstrumentDefinition::SWAP:
-                {
-                    Duration maturityDuration(instrDef.maturity());
-                    Duration deltaDuration(Duration(1, Duration::YEAR) / _compoundFreq);
+    _minPillarDates.resize(_pillarDates.size());
+    for(int i = (int)_pillarDates.size() - 1; i >= 0; i --)
+    {
+        _minPillarDates[i] = _pillarDates[i];
+        if(i + 1 < (int)_pillarDates.size() &&
+                _minPillarDates[i + 1] < _minPillarDates[i])
+            _minPillarDates[i] = _minPillarDates[i + 1];
+    }
 
-                    Date prevDate = today;
-                    double sumDeltaTxDf = 0.0; 
-                    int n = floor(maturityDuration / deltaDuration);
-                    for(int i = 1; i <= n; i ++)
-                    {
-                        Duration currDuration = deltaDuration * i;
-                        Date currDate = WorkDate(today + currDuration);
+    // At most a point per pillar: the points published to the
+    // readers never move while the curve is extended
+    _curve._curveData.reserve(_pillarDates.size());
+}
 
-                        deltaT = normDiffDate(prevDate, currDate,
-                                Date::ACT365);
+void CurveBootstrap::attach()
+{
+    _curve._complete = 0;
+    _curve._bootstrap = this;
+}
 
-                        if(i >= n)
-                            break;
+void CurveBootstrap::solveBeyond(const Date& date)
+{
+    while(!done())
+    {
+        int numPoints = _curve._numVisiblePoints;
+        if(numPoints > 0 && date < _curve._curveData[numPoints - 1].date)
+            break;
 
-                        df = ptrNewInstance->getDf(currDate);
-                        sumDeltaTxDf += deltaT * df;
+        _solveNext();
+        _publish();
+    }
+}
 
-                        prevDate = currDate;
-                    }
+void CurveBootstrap::solveAll()
+{
+    while(!done())
+        _solveNext();
+    _publish();
+}
 
-                    df = (1.0 - compRate * sumDeltaTxDf) / 
-                        (1.0 + compRate * deltaT);
+void CurveBootstrap::getJacobian(CurveJacobian& jacobian) const
+{
+    jacobian.pillarDates.clear();
+    jacobian.quoteIds.clear();
+    jacobian.dDfdQuote.clear();
 
-                    deltaTToMaturity = normDiffDate(today, maturityDate,
-                            Date::ACT365);
+    for(int j = 0; j < _numQuotes; j ++)
+        jacobian.quoteIds.push_back(_values[j].first);
 
-                    break;
-                }
-            default:
-                {
-                    std::string errorMessage("Invalid Instrument"
-                            "Definition type");
-                    throw YieldCurveException(errorMessage);
-                    break;
-                }
-        }
+    for(PointGradients::const_iterator iter = _pointGradients.begin();
+            iter != _pointGradients.end(); iter ++)
+    {
+        jacobian.pillarDates.push_back(iter->first);
+        jacobian.dDfdQuote.insert(jacobian.dDfdQuote.end(),
+                iter->second.begin(), iter->second.end());
+    }
+}
 
-        // Insert the point to the Curve
-        CurvePoint_t point(maturityDate, df, deltaTToMaturity,
-                instrDef.type());
-        ptrNewInstance->insert(point);
+void CurveBootstrap::_publish()
+{
+    std::vector<CurvePoint_t>& curveData = _curve._curveData;
+    int numVisible = (int)curveData.size();
+    if(!done())
+    {
+        Date bound = _minPillarDates[_next];
+        CurvePoint_t boundPoint(bound, 0, 0, InstrumentDefinition::FAKE);
+        numVisible = (int)(std::lower_bound(curveData.begin(),
+                    curveData.end(), boundPoint) - curveData.begin());
     }
 
-    return ptrNewInstance;
+    // The points are written before they are published
+    __sync_synchronize();
+    _curve._numVisiblePoints = numVisible;
+    if(done())
+    {
+        __sync_synchronize();
+        _curve._complete = 1;
+    }
 }
 
-std::vector<InstrumentDefinition *> YieldCurveDefinition::getAllDefinitions() const
+double CurveBootstrap::_df(Date& date) const
 {
-    std::vector<InstrumentDefinition *> allInstrDefs;
+    Date workDate = WorkDate(date);
+    double value = _curve._value(workDate, (int)_curve._curveData.size());
+    double deltaT = normDiffDate(_curve._startDate, workDate, Date::ACT365);
 
-    for(int i = 0; i < (int)_instrDefs.size(); i ++)
+    return _curve._convertSpecificToDf(value, deltaT);
+}
+
+void CurveBootstrap::_dfGradient(Date& date,
+        std::vector<double>& gradient) const
+{
+    std::vector<std::pair<Date, double> > weights;
+    _curve._dfWeights(WorkDate(date), (int)_curve._curveData.size(), weights);
+
+    for(int i = 0; i < (int)gradient.size(); i ++)
+        gradient[i] = 0.0;
+    for(int i = 0; i < (int)weights.size(); i ++)
     {
-        allInstrDefs.push_back(_instrDefs[i]->clone());
+        PointGradients::const_iterator iter =
+            _pointGradients.find(weights[i].first);
+        if(iter != _pointGradients.end())
+            addScaled(gradient, weights[i].second, iter->second);
     }
-
-    return allInstrDefs;
 }
 
-InstrumentDefinition* 
-YieldCurveDefinition::getDefinitionByID(int id)
+void CurveBootstrap::_solveNext()
 {
-    std::map<int, int>::iterator iter;
-    if((iter = _instrDefIndicesMap.find(id)) 
-            != _instrDefIndicesMap.end())
+    int i = _next;
+    const InstrumentDefinition& instrDef = _instrDefs[i];
+    double df = 0.0;
+    double compRate;
+    Date maturityDate = _pillarDates[i];
+
+    if(i > _nextInstrDefHasValue)
     {
-        int vecIndex = (*iter).second;
-        InstrumentDefinition* ptr = _instrDefs[vecIndex];
+        _prevInstrDefHasValue = _nextInstrDefHasValue;
+        for(int j = _prevInstrDefHasValue + 1; 
+                j <= _lastInstrDefID; j ++)
+            if(_instrValIndices[j] >= 0)
+            {
+                _nextInstrDefHasValue = j;
+                break;
+            }
+    }
+
+    int valueIndex = _instrValIndices[i];
+    if(valueIndex >= 0)
+    {
+        // If the definition has input compounding rate value
+        compRate = _values[valueIndex].second 
+            / 100.0f;
 
-        return ptr->clone();
+        if(_withGradients)
+        {
+            _rateGradient.assign(_numQuotes, 0.0);
+            _rateGradient[valueIndex] = 1.0 / 100.0f;
+        }
     }
     else
     {
-        std::ostringstream oss;
-        oss << "Invalid instrument definition ID " <<
-            id;
-        std::string errorMessage(oss.str());
-        throw YieldCurveException(errorMessage);
+        // If we cannot find compounding rate value in its input,
+        // then use linear-interpolation to generate this value
+        int prevValueIndex = _instrValIndices[_prevInstrDefHasValue];
+        int nextValueIndex = _instrValIndices[_nextInstrDefHasValue];
+        std::pair<Date, double> startPoint(_pillarDates[_prevInstrDefHasValue], _values[prevValueIndex].second);
+        std::pair<Date, double> endPoint(_pillarDates[_nextInstrDefHasValue], _values[nextValueIndex].second);
+        compRate = Interpolation::linearInterpolation(
+                startPoint, endPoint, maturityDate) / 100.0f;
+
+        if(_withGradients)
+        {
+            double endWeight = Interpolation::linearInterpolation(
+                    startPoint.first, 0.0, endPoint.first, 1.0,
+                    maturityDate);
+            _rateGradient.assign(_numQuotes, 0.0);
+            _rateGradient[prevValueIndex] +=
+                (1.0 - endWeight) / 100.0f;
+            _rateGradient[nextValueIndex] +=
+                endWeight / 100.0f;
+        }
     }
+
+    resolveInstrument(instrDef, _today, maturityDate, _compoundFreq, _instr);
+    double deltaT = _instr.accrual;
+
+    switch(_instr.type)
+    {
+        case InstrumentDefinition::CASH:
+            {
+                df = InstrumentPricing::cashDf(compRate, deltaT);
+
+                if(_withGradients)
+                {
+                    _gradient.assign(_numQuotes, 0.0);
+                    addScaled(_gradient, -deltaT * df * df, _rateGradient);
+                }
+                break;
+            }
+        case InstrumentDefinition::FRA:
+            {
+                Date startDate = _instr.startDate;
+                double dfStart = _df(startDate);
+                df = InstrumentPricing::fraDf(compRate, deltaT, dfStart);
+
+                if(_withGradients)
+                {
+                    double accrual = 1.0 / (1.0 + compRate * deltaT);
+                    _gradient.assign(_numQuotes, 0.0);
+                    _dfGradient(startDate, _gradient);
+                    for(int j = 0; j < _numQuotes; j ++)
+                        _gradient[j] *= accrual;
+                    addScaled(_gradient, -df * deltaT * accrual, _rateGradient);
+                }
+                break;
+            }
+        case InstrumentDefinition::SWAP:
+            {
+                double sumDeltaTxDf = 0.0; 
+                std::vector<double> sumGradient;
+                std::vector<double> couponGradient;
+                if(_withGradients)
+                {
+                    sumGradient.assign(_numQuotes, 0.0);
+                    couponGradient.assign(_numQuotes, 0.0);
+                }
+
+                for(int k = 0; k < (int)_instr.couponDates.size(); k ++)
+                {
+                    Date currDate = _instr.couponDates[k];
+                    double couponAccrual = _instr.couponAccruals[k];
+
+                    sumDeltaTxDf += couponAccrual * _df(currDate);
+
+                    if(_withGradients)
+                    {
+                        _dfGradient(currDate, couponGradient);
+                        addScaled(sumGradient, couponAccrual, couponGradient);
+                    }
+                }
+
+                df = InstrumentPricing::swapDf(compRate, deltaT, sumDeltaTxDf);
+
+                if(_withGradients)
+                {
+                    double accrual = 1.0 / (1.0 + compRate * deltaT);
+                    _gradient.assign(_numQuotes, 0.0);
+                    addScaled(_gradient, -compRate * accrual, sumGradient);
+                    addScaled(_gradient,
+                            -(sumDeltaTxDf + df * deltaT) * accrual,
+                            _rateGradient);
+                }
+                break;
+            }
+        default:
+            break;
+    }
+
+    // Insert the point to the Curve
+    CurvePoint_t point(maturityDate, df, _instr.deltaTToMaturity,
+            instrDef.type());
+    if(_curve.insert(point) && _withGradients)
+        _pointGradients[maturityDate] = _gradient;
+
+    _next ++;
 }
+
 //////////////////////////////////////////
 // Definition of the class YieldCurveInstance
 //////////////////////////////////////////
 YieldCurveInstance::YieldCurveInstance(const Date& startDate):
-    _startDate(startDate)
+    _startDate(startDate), _bootstrap(NULL), _numVisiblePoints(0),
+    _complete(1)
 {
+    pthread_mutex_init(&_bootstrapLock, NULL);
 }
 
 YieldCurveInstance::YieldCurveInstance(const YieldCurveInstance& rhs):
-    _startDate(rhs._startDate)
+    _startDate(rhs._startDate), _bootstrap(NULL), _numVisiblePoints(0),
+    _complete(1)
 {
+    pthread_mutex_init(&_bootstrapLock, NULL);
     *this = this->operator=(rhs);
 }
 
+YieldCurveInstance::~YieldCurveInstance()
+{
+    delete _bootstrap;
+    pthread_mutex_destroy(&_bootstrapLock);
+}
+
+YieldCurveInstance* YieldCurveInstance::create(
+        YieldCurveDefinition::CURVETYPE type, double compoundFreq,
+        const Date& startDate)
+{
+    switch(type)
+    {
+        case YieldCurveDefinition::ZEROCOUPONRATE:
+            return new ZeroCouponRateCurve(compoundFreq, startDate);
+        case YieldCurveDefinition::DISCOUNTFACTOR:
+            return new DiscountFactorCurve(compoundFreq, startDate);
+        case YieldCurveDefinition::CONTINUOUSRATE:
+            return new ContinuousRateCurve(compoundFreq, startDate);
+        case YieldCurveDefinition::LOGDISCOUNTFACTOR:
+            return new LogDiscountFactorCurve(compoundFreq, startDate);
+        default:
+            {
+                std::string errorMessage("Invalid Yield Curve"
+                        " Instance Type");
+                throw YieldCurveException(errorMessage);
+            }
+    }
+}
+
+YieldCurveInstance* YieldCurveInstance::createView(
+        YieldCurveDefinition::CURVETYPE type, double compoundFreq,
+        const Date& startDate, const CurvePointArrays& points)
+{
+    YieldCurveInstance *curve = create(type, compoundFreq, startDate);
+    curve->_view = points;
+    curve->_numVisiblePoints = points.numPoints;
+
+    return curve;
+}
+
 YieldCurveInstance& YieldCurveInstance::operator=(
         const YieldCurveInstance& rhs)
 {
-    std::vector<CurvePoint_t>(rhs._curveData).swap(_curveData); 
-    std::map<Date, int>(rhs._curveDataIndicesMap).swap(_curveDataIndicesMap);
+    if(this == &rhs)
+        return *this;
+
+    // The copy is complete
+    rhs.solveAll();
+    solveAll();
+
+    if(rhs._view.dates != NULL)
+    {
+        // and holds the points of a view itself
+        std::vector<CurvePoint_t> curveData;
+        curveData.reserve(rhs._view.numPoints);
+        for(int i = 0; i < rhs._view.numPoints; i ++)
+        {
+            Date date = Columnar::fromDate32(rhs._view.dates[i]);
+            curveData.push_back(CurvePoint_t(date, rhs._view.values[i],
+                        rhs._view.deltaTs[i], InstrumentDefinition::FAKE));
+        }
+        curveData.swap(_curveData);
+    }
+    else
+    {
+        std::vector<CurvePoint_t>(rhs._curveData).swap(_curveData);
+    }
+    _view = CurvePointArrays();
     _startDate = rhs._startDate;
+    _numVisiblePoints = (int)_curveData.size();
     return *this;
 }
 
-void YieldCurveInstance::insert(CurvePoint_t& data)
+int YieldCurveInstance::_solvedPoints(const Date& workDate) const
+{
+    if(_complete)
+    {
+        __sync_synchronize();
+        return _numVisiblePoints;
+    }
+
+    // The points published are final, enough of them if one is
+    // after the date
+    int numPoints = _numVisiblePoints;
+    __sync_synchronize();
+    if(numPoints > 0 && workDate < _curveData[numPoints - 1].date)
+        return numPoints;
+
+    ScopedLock lock(_bootstrapLock);
+    if(_bootstrap != NULL)
+    {
+        _bootstrap->solveBeyond(workDate);
+        if(_bootstrap->done())
+        {
+            delete _bootstrap;
+            _bootstrap = NULL;
+        }
+    }
+
+    return _numVisiblePoints;
+}
+
+void YieldCurveInstance::solveAll() const
+{
+    ScopedLock lock(_bootstrapLock);
+    if(_bootstrap != NULL)
+    {
+        _bootstrap->solveAll();
+        delete _bootstrap;
+        _bootstrap = NULL;
+    }
+}
+
+bool YieldCurveInstance::insert(CurvePoint_t& data)
 {
+    if(_view.dates != NULL)
+    {
+        std::string errorMessage("Cannot insert into a view of a "
+                "Yield Curve");
+        throw YieldCurveException(errorMessage);
+    }
+
     CurvePoint_t newData(data);
 
     newData.value = _convertDfToSpecific(
             newData.value, newData.deltaT);
 
-    std::map<Date, int>::iterator iter;
-
-    iter = _curveDataIndicesMap.find(newData.date);
+    std::vector<CurvePoint_t>::iterator ptIter;
 
+    ptIter = lower_bound(_curveData.begin(),
+            _curveData.end(), newData);
 
-    if(iter != _curveDataIndicesMap.end())
+    if(ptIter != _curveData.end() && ptIter->date == newData.date)
     {
-        int index = (*iter).second;
-        InstrumentDefinition::TYPE iterDataType = 
-            _curveData[index].instrType;
+        InstrumentDefinition::TYPE iterDataType = ptIter->instrType;
 
         if(data.instrType == InstrumentDefinition::SWAP ||
-                (data.instrType == InstrumentDefinition::FRA && 
+                (data.instrType == InstrumentDefinition::FRA &&
                  iterDataType != InstrumentDefinition::SWAP) ||
                 (data.instrType == InstrumentDefinition::CASH &&
                  iterDataType == InstrumentDefinition::CASH))
         {
-            _curveData[index] = newData;
+            *ptIter = newData;
+            return true;
         }
-    } 
+
+        return false;
+    }
     else
     {
-        std::vector<CurvePoint_t>::iterator ptIter;
+        _curveData.insert(ptIter, newData);
 
-        ptIter = upper_bound(_curveData.begin(),
-                _curveData.end(), newData);
-        ptIter = _curveData.insert(ptIter, newData);
-
-        _curveDataIndicesMap[newData.date] = distance(
-                _curveData.begin(), ptIter);
+        // A bootstrap publishes its points itself
+        if(_bootstrap == NULL)
+            _numVisiblePoints = (int)_curveData.size();
     }
+
+    return true;
+}
+
+void YieldCurveInstance::getPointDates(std::vector<Date>& dates) const
+{
+    solveAll();
+
+    if(_view.dates != NULL)
+        _getPointDatesOf(ViewPoints(_view), dates);
+    else
+        _getPointDatesOf(HeldPoints(_curveData), dates);
 }
 
 double YieldCurveInstance::operator[](Date& date) const
 {
-    std::pair<std::vector<CurvePoint_t>::const_iterator,
-        std::vector<CurvePoint_t>::const_iterator> iterRange;
+    Date workDate = WorkDate(date);
+    return _value(workDate, _solvedPoints(workDate));
+}
+
+double YieldCurveInstance::_value(const Date& workDate, int numPoints) const
+{
+    if(_view.dates != NULL)
+        return _valueOf(ViewPoints(_view), workDate, numPoints);
+
+    return _valueOf(HeldPoints(_curveData), workDate, numPoints);
+}
+
+double YieldCurveInstance::getDf(Date& date) const
+{
+    double value = this->operator[](date);
 
     Date workDate = WorkDate(date);
-    CurvePoint_t fakePoint(workDate, 0, 0, InstrumentDefinition::FAKE);
-
-    iterRange = equal_range(_curveData.begin(),
-            _curveData.end(), fakePoint);
-     
-    int distUD = distance(iterRange.first, iterRange.second);
-    
-    if(distUD == 0)
-        if(iterRange.first == _curveData.end() || 
-                iterRange.first == _curveData.begin())
-        {
-            std::string errorMessage("Cannot get the value on the "
-                    "Yield Curve of the giving Date. The date is "
-                    "out of the range.");
+    double deltaT = normDiffDate(_startDate, workDate, Date::ACT365);
+    value = _convertSpecificToDf(value, deltaT);
 
-            throw YieldCurveException(errorMessage);
+    return value;
+}
+
+void YieldCurveInstance::getDfWeights(Date& date,
+        std::vector<std::pair<Date, double> >& weights) const
+{
+    Date workDate = WorkDate(date);
+    _dfWeights(workDate, _solvedPoints(workDate), weights);
+}
+
+void YieldCurveInstance::_dfWeights(const Date& workDate, int numPoints,
+        std::vector<std::pair<Date, double> >& weights) const
+{
+    if(_view.dates != NULL)
+        _dfWeightsOf(ViewPoints(_view), workDate, numPoints, weights);
+    else
+        _dfWeightsOf(HeldPoints(_curveData), workDate, numPoints, weights);
+}
+
+void YieldCurveInstance::sweepSorted(const std::vector<Date>& sortedDates,
+        std::vector<double>& values, std::vector<double>& dfs,
+        std::vector<char>& found) const
+{
+    std::vector<double> deltaTs;
+    _sweepValues(sortedDates, values, deltaTs, found);
+
+    int numDates = (int)sortedDates.size();
+    dfs.resize(numDates);
+    for(int i = 0; i < numDates; i ++)
+        if(found[i])
+            dfs[i] = _convertSpecificToDf(values[i], deltaTs[i]);
+}
+
+void YieldCurveInstance::_sweepValues(const std::vector<Date>& sortedDates,
+        std::vector<double>& values, std::vector<double>& deltaTs,
+        std::vector<char>& found) const
+{
+    if(_view.dates != NULL)
+        _sweepValuesOf(ViewPoints(_view), sortedDates, values, deltaTs,
+                found);
+    else
+        _sweepValuesOf(HeldPoints(_curveData), sortedDates, values,
+                deltaTs, found);
+}
+
+void YieldCurveInstance::lookupSorted(const std::vector<Date>& sortedDates,
+        EXTRAPOLATION extrapolation, std::vector<double>& values,
+        std::vector<double>& dfs, std::vector<LOOKUPSTATUS>& status) const
+{
+    std::vector<char> found;
+    sweepSorted(sortedDates, values, dfs, found);
+
+    // The sweep has solved the points the dates out of range
+    // need: the first one, and all of them if a date is after
+    // the last one
+    int numPoints = _numVisiblePoints;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    int numDates = (int)sortedDates.size();
+    status.resize(numDates);
+    for(int i = 0; i < numDates; i ++)
+    {
+        if(found[i])
+        {
+            status[i] = INRANGE;
+        }
+        else if(extrapolation == NOEXTRAPOLATION || numPoints == 0 ||
+                sortedDates[i] < _startDate)
+        {
+            values[i] = nan;
+            dfs[i] = nan;
+            status[i] = OUTOFRANGE;
         }
         else
         {
-            iterRange.first --;
+            _extrapolate(sortedDates[i], extrapolation, numPoints,
+                    values[i], dfs[i]);
+            status[i] = EXTRAPOLATED;
         }
-    else
-    {
-        if(iterRange.second == _curveData.end())
-            iterRange.second --;
     }
+}
 
-    double value;
-    CurvePoint_t lowerElement = *(iterRange.first);
-    CurvePoint_t upperElement = *(iterRange.second);
+void YieldCurveInstance::lookup(const std::vector<Date>& dates,
+        EXTRAPOLATION extrapolation, std::vector<double>& values,
+        std::vector<double>& dfs, std::vector<LOOKUPSTATUS>& status) const
+{
+    // (julian day number, position) to sort the dates
+    int numDates = (int)dates.size();
+    std::vector<std::pair<unsigned long, int> > keys(numDates);
+    for(int i = 0; i < numDates; i ++)
+        keys[i] = std::make_pair(dates[i].get().day_number(), i);
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Date> sortedDates;
+    sortedDates.reserve(numDates);
+    for(int i = 0; i < numDates; i ++)
+        sortedDates.push_back(dates[keys[i].second]);
+
+    std::vector<double> sortedValues, sortedDfs;
+    std::vector<LOOKUPSTATUS> sortedStatus;
+    lookupSorted(sortedDates, extrapolation, sortedValues, sortedDfs,
+            sortedStatus);
+
+    values.resize(numDates);
+    dfs.resize(numDates);
+    status.resize(numDates);
+    for(int i = 0; i < numDates; i ++)
+    {
+        int pos = keys[i].second;
+        values[pos] = sortedValues[i];
+        dfs[pos] = sortedDfs[i];
+        status[pos] = sortedStatus[i];
+    }
+}
 
-    value = Interpolation::linearInterpolation(
-            lowerElement.date, lowerElement.value,
-            upperElement.date, upperElement.value,
-            workDate);
+YieldCurveInstance* YieldCurveInstance::rollForward(
+        const Date& newStartDate) const
+{
+    std::vector<Date> newStartDates(1, newStartDate);
+    std::vector<YieldCurveInstance *> curves;
+    rollForward(newStartDates, curves);
 
-    return value;
+    return curves[0];
 }
 
-double YieldCurveInstance::getDf(Date& date) const
+void YieldCurveInstance::rollForward(const std::vector<Date>& newStartDates,
+        std::vector<YieldCurveInstance *>& curves) const
 {
-    double value = this->operator[](date);
+    solveAll();
 
-    Date today = WorkDate(Date::today());
-    Date workDate = WorkDate(date);
-    double deltaT = normDiffDate(today, workDate, Date::ACT365);
-    value = _convertSpecificToDf(value, deltaT);
+    if(_view.dates != NULL)
+        _rollForwardOf(ViewPoints(_view), newStartDates, curves);
+    else
+        _rollForwardOf(HeldPoints(_curveData), newStartDates, curves);
+}
 
-    return value;
+void YieldCurveInstance::_extrapolate(const Date& workDate,
+        EXTRAPOLATION extrapolation, int numPoints,
+        double& value, double& df) const
+{
+    if(_view.dates != NULL)
+        _extrapolateOf(ViewPoints(_view), workDate, extrapolation,
+                numPoints, value, df);
+    else
+        _extrapolateOf(HeldPoints(_curveData), workDate, extrapolation,
+                numPoints, value, df);
 }
 
-//////////////////////////////////////////
-// Definition of the class ZeroCouponRateCurve
-//////////////////////////////////////////
-ZeroCouponRateCurve::ZeroCouponRateCurve(
-        double compoundFreq, const Date& startDate):
-    _compoundFreq(compoundFreq), YieldCurveInstance(startDate)
+template<class POINTS>
+void YieldCurveInstance::_getPointDatesOf(const POINTS& points,
+        std::vector<Date>& dates) const
 {
+    dates.resize(points.size());
+    for(int i = 0; i < points.size(); i ++)
+        dates[i] = points.date(i);
 }
 
-ZeroCouponRateCurve::ZeroCouponRateCurve(const ZeroCouponRateCurve& rhs):
-    YieldCurveInstance(rhs)
+template<class POINTS>
+double YieldCurveInstance::_valueOf(const POINTS& points,
+        const Date& workDate, int numPoints) const
 {
-    _compoundFreq = rhs._compoundFreq;
+    long day = POINTS::dayOf(workDate);
+    int upper = lowerBound(points, numPoints, day);
+
+    if(upper != numPoints && points.day(upper) == day)
+        return points.value(upper);
+
+    if(upper == numPoints || upper == 0)
+    {
+        std::string errorMessage("Cannot get the value on the "
+                "Yield Curve of the giving Date. The date is "
+                "out of the range.");
+
+        throw YieldCurveException(errorMessage);
+    }
+
+    int lower = upper - 1;
+    return interpolate(points.day(lower), points.value(lower),
+            points.day(upper), points.value(upper), day);
 }
 
-ZeroCouponRateCurve::~ZeroCouponRateCurve()
+template<class POINTS>
+void YieldCurveInstance::_dfWeightsOf(const POINTS& points,
+        const Date& workDate, int numPoints,
+        std::vector<std::pair<Date, double> >& weights) const
 {
+    weights.clear();
+
+    // The same points operator[] interpolates between
+    long day = POINTS::dayOf(workDate);
+    int lower = lowerBound(points, numPoints, day);
+    int upper;
+
+    if(lower != numPoints && points.day(lower) == day)
+    {
+        upper = lower + 1;
+        if(upper == numPoints)
+            upper --;
+    }
+    else if(lower == numPoints || lower == 0)
+    {
+        std::string errorMessage("Cannot get the value on the "
+                "Yield Curve of the giving Date. The date is "
+                "out of the range.");
+
+        throw YieldCurveException(errorMessage);
+    }
+    else
+    {
+        upper = lower;
+        lower --;
+    }
+
+    double upperWeight = interpolate(points.day(lower), 0.0,
+            points.day(upper), 1.0, day);
+    double value = points.value(lower) +
+        upperWeight * (points.value(upper) - points.value(lower));
+
+    double deltaT = normDiffDate(_startDate, workDate, Date::ACT365);
+    double dDfdValue = _dSpecificToDf(value, deltaT);
+
+    // d value / d df of a point
+    double lowerDf = _convertSpecificToDf(points.value(lower),
+            points.deltaT(lower));
+    weights.push_back(std::make_pair(points.date(lower), dDfdValue *
+                (1.0 - upperWeight) *
+                _dDfToSpecific(lowerDf, points.deltaT(lower))));
+
+    if(upper != lower)
+    {
+        double upperDf = _convertSpecificToDf(points.value(upper),
+                points.deltaT(upper));
+        weights.push_back(std::make_pair(points.date(upper), dDfdValue *
+                    upperWeight * _dDfToSpecific(upperDf,
+                        points.deltaT(upper))));
+    }
 }
 
-YieldCurveInstance& ZeroCouponRateCurve::operator=(YieldCurveInstance& rhs)
+template<class POINTS>
+void YieldCurveInstance::_sweepValuesOf(const POINTS& points,
+        const std::vector<Date>& sortedDates, std::vector<double>& values,
+        std::vector<double>& deltaTs, std::vector<char>& found) const
 {
-    ZeroCouponRateCurve& zrhs = static_cast<ZeroCouponRateCurve&>(rhs);
-    *this = ZeroCouponRateCurve::operator=(zrhs);
+    int numDates = (int)sortedDates.size();
+    values.resize(numDates);
+    deltaTs.resize(numDates);
+    found.resize(numDates);
 
-    return *this;
+    int iter = 0;
+    int end = 0;
+    if(numDates > 0)
+        end = _solvedPoints(sortedDates[numDates - 1]);
+
+    for(int i = 0; i < numDates; i ++)
+    {
+        const Date& date = sortedDates[i];
+        long day = POINTS::dayOf(date);
+
+        // Move to the first point not earlier than the date,
+        // the same point operator[] finds
+        while(iter != end && points.day(iter) < day)
+            iter ++;
+
+        double value;
+        if(iter == end)
+        {
+            found[i] = 0;
+            continue;
+        }
+        else if(points.day(iter) == day)
+        {
+            value = points.value(iter);
+        }
+        else if(iter == 0)
+        {
+            found[i] = 0;
+            continue;
+        }
+        else
+        {
+            value = interpolate(points.day(iter - 1), points.value(iter - 1),
+                    points.day(iter), points.value(iter), day);
+        }
+
+        values[i] = value;
+        deltaTs[i] = normDiffDate(_startDate, date, Date::ACT365);
+        found[i] = 1;
+    }
 }
 
-ZeroCouponRateCurve& ZeroCouponRateCurve::operator=(ZeroCouponRateCurve& rhs)
+template<class POINTS>
+void YieldCurveInstance::_rollForwardOf(const POINTS& points,
+        const std::vector<Date>& newStartDates,
+        std::vector<YieldCurveInstance *>& curves) const
 {
-    YieldCurveInstance::operator=(rhs);
-    _compoundFreq = rhs._compoundFreq;
+    int numPoints = points.size();
+    std::vector<Date> workDates;
+    for(int h = 0; h < (int)newStartDates.size(); h ++)
+    {
+        Date workDate = WorkDate(newStartDates[h]);
+        if(numPoints == 0 || workDate < _startDate ||
+                POINTS::dayOf(workDate) >= points.day(numPoints - 1))
+        {
+            std::string errorMessage("Cannot roll the Yield Curve "
+                    "to the giving Date. The date is out of the range.");
 
-    return *this;
+            throw YieldCurveException(errorMessage);
+        }
+        workDates.push_back(workDate);
+    }
+
+    // The dfs of the points, shared by all the horizons
+    std::vector<double> pointDfs(numPoints);
+    for(int i = 0; i < numPoints; i ++)
+        pointDfs[i] = _convertSpecificToDf(points.value(i),
+                points.deltaT(i));
+
+    curves.clear();
+    curves.reserve(workDates.size());
+    for(int h = 0; h < (int)workDates.size(); h ++)
+    {
+        const Date& workDate = workDates[h];
+        long day = POINTS::dayOf(workDate);
+
+        // The df of the new start date on this curve
+        double value, startDf;
+        if(day < points.day(0))
+        {
+            _extrapolateOf(points, workDate, FLATZERO, numPoints,
+                    value, startDf);
+        }
+        else
+        {
+            value = _valueOf(points, workDate, numPoints);
+            startDf = _convertSpecificToDf(value,
+                    normDiffDate(_startDate, workDate, Date::ACT365));
+        }
+
+        // The points after the new start date
+        int first = lowerBound(points, numPoints, day + 1);
+
+        YieldCurveInstance *curve = _newCurve(workDate);
+        curves.push_back(curve);
+        curve->_curveData.reserve(numPoints - first);
+        for(int i = first; i < numPoints; i ++)
+        {
+            Date date = points.date(i);
+            double deltaT = normDiffDate(workDate, date, Date::ACT365);
+            CurvePoint_t point(date, curve->_convertDfToSpecific(
+                        pointDfs[i] / startDf, deltaT),
+                    deltaT, points.instrType(i));
+
+            curve->_curveData.push_back(point);
+        }
+        curve->_numVisiblePoints = (int)curve->_curveData.size();
+    }
+}
+
+template<class POINTS>
+void YieldCurveInstance::_extrapolateOf(const POINTS& points,
+        const Date& workDate, EXTRAPOLATION extrapolation, int numPoints,
+        double& value, double& df) const
+{
+    bool longEnd = points.day(numPoints - 1) < POINTS::dayOf(workDate);
+    int point = longEnd ? numPoints - 1 : 0;
+    double pointValue = points.value(point);
+    double pointDeltaT = points.deltaT(point);
+    double pointDf = _convertSpecificToDf(pointValue, pointDeltaT);
+
+    if(extrapolation == CLAMP)
+    {
+        value = pointValue;
+        df = pointDf;
+        return;
+    }
+
+    // Continuously compounded: the zero rate of the point, and
+    // the forward rate the df decays at from the point
+    double zeroRate = -log(pointDf) / pointDeltaT;
+    double forwardRate = zeroRate;
+    if(extrapolation == FLATFORWARD && longEnd && numPoints > 1)
+    {
+        double prevDeltaT = points.deltaT(numPoints - 2);
+        double prevDf = _convertSpecificToDf(points.value(numPoints - 2),
+                prevDeltaT);
+        forwardRate = log(prevDf / pointDf) / (pointDeltaT - prevDeltaT);
+    }
+
+    double deltaT = normDiffDate(_startDate, workDate, Date::ACT365);
+    df = pointDf * exp(-forwardRate * (deltaT - pointDeltaT));
+
+    // The rates of the start date itself are their limit, the
+    // zero rate of the short end held flat
+    if(deltaT > 0.0 || (curveType() != YieldCurveDefinition::ZEROCOUPONRATE &&
+                curveType() != YieldCurveDefinition::CONTINUOUSRATE))
+        value = _convertDfToSpecific(df, deltaT);
+    else
+        value = pointValue;
 }
 
 //////////////////////////////////////////
@@ -628,13 +1463,114 @@ bool CurvePoint_t::operator<(const CurvePoint_t& rhs) const
     return (this->date < rhs.date);
 }
 
+//////////////////////////////////////////
+// Definition of the struct CurveJacobian
+//////////////////////////////////////////
+void CurveJacobian::bucketedRho(const YieldCurveInstance& instYC,
+        Date& date, std::vector<double>& rho) const
+{
+    std::vector<std::pair<Date, double> > weights;
+    instYC.getDfWeights(date, weights);
+
+    int numQuotes = (int)quoteIds.size();
+    rho.assign(numQuotes, 0.0);
+    for(int i = 0; i < (int)weights.size(); i ++)
+    {
+        std::vector<Date>::const_iterator iter = std::lower_bound(
+                pillarDates.begin(), pillarDates.end(), weights[i].first);
+        if(iter == pillarDates.end() || !(*iter == weights[i].first))
+        {
+            std::string errorMessage("The curve was not produced "
+                    "with this jacobian");
+            throw YieldCurveException(errorMessage);
+        }
+
+        int pillar = (int)(iter - pillarDates.begin());
+        for(int j = 0; j < numQuotes; j ++)
+            rho[j] += weights[i].second * derivative(pillar, j);
+    }
+}
+
 //////////////////////////////////////////
 // Definition of the miscellaneous non-member funcitons
 //////////////////////////////////////////
+void resolveInstrument(const InstrumentDefinition& instrDef,
+        const Date& today, const Date& maturityDate, double compoundFreq,
+        ResolvedInstrument& instr)
+{
+    static const Duration oneMonth(1, Duration::MONTH);
+    static const Duration threeMonth(3, Duration::MONTH);
+    static const Duration oneYear(1, Duration::YEAR);
+
+    instr.type = instrDef.type();
+    if(instr.type == InstrumentDefinition::FAKE)
+    {
+        if(instrDef.maturity() < oneMonth)
+            instr.type = InstrumentDefinition::CASH;
+        else if(instrDef.maturity() < oneYear)
+            instr.type = InstrumentDefinition::FRA;
+        else
+            instr.type = InstrumentDefinition::SWAP;
+    }
+
+    instr.maturityDate = maturityDate;
+    instr.deltaTToMaturity = normDiffDate(today, maturityDate, Date::ACT365);
+    instr.accrual = 0.0;
+    instr.startDate = today;
+    instr.couponDates.clear();
+    instr.couponAccruals.clear();
+
+    switch(instr.type)
+    {
+        case InstrumentDefinition::CASH:
+            instr.accrual = instr.deltaTToMaturity;
+            break;
+        case InstrumentDefinition::FRA:
+            {
+                // The FRA of a FAKE pillar covers its last 3M
+                Duration startDuration = instrDef.type() == InstrumentDefinition::FRA ?
+                    instrDef.startDuration() : instrDef.maturity() - threeMonth;
+                instr.startDate = Schedule::tenorDate(today, startDuration);
+                instr.accrual = normDiffDate(instr.startDate, maturityDate,
+                        Date::ACT365);
+                break;
+            }
+        case InstrumentDefinition::SWAP:
+            {
+                Duration deltaDuration(oneYear / compoundFreq);
+                int n = instrDef.maturity().periods(deltaDuration);
+                Schedule::Dates couponDates =
+                    Schedule::periodicDates(today, deltaDuration, n);
+
+                Date prevDate = today;
+                for(int k = 1; k <= n; k ++)
+                {
+                    const Date& currDate = couponDates[k - 1];
+                    instr.accrual = normDiffDate(prevDate, currDate,
+                            Date::ACT365);
+                    if(k >= n)
+                        break;
+
+                    instr.couponDates.push_back(currDate);
+                    instr.couponAccruals.push_back(instr.accrual);
+                    prevDate = currDate;
+                }
+                break;
+            }
+        default:
+            {
+                std::string errorMessage("Invalid Instrument"
+                        "Definition type");
+                throw YieldCurveException(errorMessage);
+            }
+    }
+}
+
 double getCompoundRate(YieldCurveInstance& instYC, Date& theDate,
         InstrumentDefinition::TYPE type, double compoundFreq)
 {
-    Date today = WorkDate(Date::today());
+    // Rates are measured from the as-of date of the curve
+    Date today = instYC.startDate();
     Date theWorkDate = WorkDate(theDate);
     try
     {
@@ -645,9 +1581,8 @@ double getCompoundRate(YieldCurveInstance& instYC, Date& theDate,
                     double deltaT = normDiffDate(today, theWorkDate,
                             Date::ACT365);
 
-                    double compRate = 
-                        (1.0f / instYC.getDf(theWorkDate) - 1.0f) / 
-                        deltaT;
+                    double compRate = InstrumentPricing::cashRate(
+                            instYC.getDf(theWorkDate), deltaT);
 
                     return compRate * 100.0f;
                 }
@@ -660,7 +1595,8 @@ double getCompoundRate(YieldCurveInstance& instYC, Date& theDate,
                     double deltaT = normDiffDate(startDate, theWorkDate,
                             Date::ACT365);
 
-                    double compRate = (dfStart / dfMature - 1.0f) / deltaT;
+                    double compRate = InstrumentPricing::fraRate(dfMature,
+                            deltaT, dfStart);
                     return compRate * 100.0f;
                 }
             case InstrumentDefinition::SWAP:
@@ -668,26 +1604,32 @@ double getCompoundRate(YieldCurveInstance& instYC, Date& theDate,
                     Duration maturityDuration(theWorkDate - today);
                     Duration deltaDuration(Duration(1, Duration::YEAR) / compoundFreq);
 
-                    int n = floor(maturityDuration / deltaDuration);
+                    int n = maturityDuration.periods(deltaDuration);
 
-                    double sumDeltaTxDf = 0;
-                    double dfn;
+                    // The annuity of the coupons before the last
+                    double annuity = 0;
+                    double dfn = 1.0;
+                    double deltaT = 0.0;
                     Date prevDate = today;
+                    Schedule::Dates couponDates =
+                        Schedule::periodicDates(today, deltaDuration, n);
                     for(int i = 1; i <= n; i ++)
                     {
-                        Duration currDuration = deltaDuration * i;
-                        Date currDate = WorkDate(today + currDuration);
-                        double deltaT = normDiffDate(prevDate,
-                                currDate, Date::ACT365);
+                        Date currDate = couponDates[i - 1];
+                        deltaT = normDiffDate(prevDate, currDate, Date::ACT365);
                         double df = instYC.getDf(currDate);
-                        sumDeltaTxDf += deltaT * df;
                         if(i == n)
+                        {
                             dfn = df;
+                            break;
+                        }
+                        annuity += deltaT * df;
 
                         prevDate = currDate;
                     }
 
-                    double compRate = (1.0f - dfn) / sumDeltaTxDf;
+                    double compRate = InstrumentPricing::swapRate(dfn,
+                            deltaT, annuity);
                     return compRate * 100.0f;
                 }
             default:
@@ -703,3 +1645,129 @@ double getCompoundRate(YieldCurveInstance& instYC, Date& theDate,
         throw e;
     }
 }
+
+void getParRateStrip(const YieldCurveInstance& instYC,
+        const std::vector<Date>& maturityDates, double compoundFreq,
+        ParRateStrip& strip)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    Date today = instYC.startDate();
+    int numMaturities = (int)maturityDates.size();
+
+    strip.maturityDates = maturityDates;
+    strip.cashRates.assign(numMaturities, nan);
+    strip.fraRates.assign(numMaturities, nan);
+    strip.swapRates.assign(numMaturities, nan);
+    if(numMaturities == 0)
+        return;
+
+    // The FRA start dates are sorted as well
+    std::vector<Date> startDates;
+    startDates.reserve(numMaturities);
+    for(int i = 0; i < numMaturities; i ++)
+        startDates.push_back(WorkDate(maturityDates[i] - Duration(3, Duration::MONTH)));
+
+    std::vector<double> values, dfs, startDfs;
+    std::vector<char> found, startFound;
+    instYC.sweepSorted(maturityDates, values, dfs, found);
+    instYC.sweepSorted(startDates, values, startDfs, startFound);
+
+    // The number of coupons of every swap, as getCompoundRate
+    // counts them
+    Duration deltaDuration(Duration(1, Duration::YEAR) / compoundFreq);
+    std::vector<int> numCoupons(numMaturities);
+    int maxCoupons = 0;
+    for(int i = 0; i < numMaturities; i ++)
+    {
+        Duration maturityDuration(maturityDates[i] - today);
+        numCoupons[i] = maturityDuration.periods(deltaDuration);
+        maxCoupons = std::max(maxCoupons, numCoupons[i]);
+    }
+
+    // annuities[k]: the sum of deltaT x df of the first k coupons,
+    // accruals[k] the deltaT of coupon k, couponFound[k - 1] if
+    // the first k coupons are on the curve
+    Schedule::Dates couponDates =
+        Schedule::periodicDates(today, deltaDuration, maxCoupons);
+    std::vector<double> couponDfs;
+    std::vector<char> couponFound;
+    instYC.sweepSorted(couponDates.get(), values, couponDfs, couponFound);
+
+    std::vector<double> annuities(maxCoupons + 1, 0.0);
+    std::vector<double> accruals(maxCoupons + 1, 0.0);
+    Date prevDate = today;
+    for(int k = 1; k <= maxCoupons; k ++)
+    {
+        Date currDate = couponDates[k - 1];
+        accruals[k] = normDiffDate(prevDate, currDate, Date::ACT365);
+        annuities[k] = annuities[k - 1] + accruals[k] * couponDfs[k - 1];
+        if(!couponFound[k - 1] || (k > 1 && !couponFound[k - 2]))
+            couponFound[k - 1] = 0;
+
+        prevDate = currDate;
+    }
+
+    for(int i = 0; i < numMaturities; i ++)
+    {
+        const Date& maturityDate = maturityDates[i];
+        if(found[i])
+        {
+            double deltaT = normDiffDate(today, maturityDate, Date::ACT365);
+            strip.cashRates[i] = InstrumentPricing::cashRate(dfs[i],
+                    deltaT) * 100.0f;
+        }
+
+        if(found[i] && startFound[i])
+        {
+            double deltaT = normDiffDate(startDates[i], maturityDate,
+                    Date::ACT365);
+            strip.fraRates[i] = InstrumentPricing::fraRate(dfs[i], deltaT,
+                    startDfs[i]) * 100.0f;
+        }
+
+        int n = numCoupons[i];
+        if(n > 0 && couponFound[n - 1])
+            strip.swapRates[i] = InstrumentPricing::swapRate(couponDfs[n - 1],
+                    accruals[n], annuities[n - 1]) * 100.0f;
+    }
+}
+
+void getParRateStrip(const YieldCurveInstance& instYC,
+        const Duration& maxMaturity, const Duration& period,
+        double compoundFreq, ParRateStrip& strip)
+{
+    int n = maxMaturity.periods(period);
+    Schedule::Dates maturityDates =
+        Schedule::periodicDates(instYC.startDate(), period, n);
+
+    getParRateStrip(instYC, maturityDates.get(), compoundFreq, strip);
+}
+
+void getParRateStrips(const std::vector<YieldCurveInstance *>& curves,
+        const std::vector<Duration>& tenors, double compoundFreq,
+        int numThreads, std::vector<ParRateStrip>& strips)
+{
+    int numCurves = (int)curves.size();
+    strips.resize(numCurves);
+
+    std::vector<Concurrency::Runnable *> jobs;
+    for(int i = 0; i < numCurves; i ++)
+        jobs.push_back(new StripJob(*curves[i], tenors, compoundFreq,
+                    strips[i]));
+
+    try
+    {
+        Concurrency::runAll(jobs, numThreads);
+    }
+    catch(Concurrency::ConcurrencyException& e)
+    {
+        for(int i = 0; i < numCurves; i ++)
+            delete jobs[i];
+
+        std::string errorMessage(e.what());
+        throw YieldCurveException(errorMessage);
+    }
+
+    for(int i = 0; i < numCurves; i ++)
+        delete jobs[i];
+}
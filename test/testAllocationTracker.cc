@@ -0,0 +1,93 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+
+class AllocationTrackerTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing AllocationTracker --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing AllocationTracker --------"
+                << std::endl << std::endl;
+        }
+};
+
+namespace
+{
+    const AllocationTracker::StageReport *findStage(
+            const std::vector<AllocationTracker::StageReport>& stages, int timerId)
+    {
+        for(int i = 0; i < (int)stages.size(); i ++)
+        {
+            if(stages[i].timerId == timerId)
+                return &stages[i];
+        }
+        return NULL;
+    }
+}
+
+TEST_F(AllocationTrackerTest, ChargesTheInnermostScope)
+{
+    // The buffer of the thread is allocated on its first record
+    Profiler::count(Profiler::counterId("testAllocationWarmUp"), 1);
+    int outerId = Profiler::timerId("testAllocationOuter");
+    int innerId = Profiler::timerId("testAllocationInner");
+    ASSERT_TRUE(AllocationTracker::enable());
+    AllocationTracker::reset();
+    int64_t liveBefore = AllocationTracker::liveBytes();
+
+    std::vector<char> *kept = NULL;
+    {
+        Profiler::ScopedTimer outer(outerId);
+        {
+            Profiler::ScopedTimer inner(innerId);
+            // Freed within the scope, only the peak shows it
+            std::vector<char> temporary(1 << 20);
+            temporary[0] = 1;
+        }
+        kept = new std::vector<char>(1000);
+    }
+
+    std::vector<AllocationTracker::StageReport> stages;
+    AllocationTracker::snapshot(stages);
+    const AllocationTracker::StageReport *inner = findStage(stages, innerId);
+    const AllocationTracker::StageReport *outer = findStage(stages, outerId);
+    ASSERT_TRUE(inner != NULL);
+    ASSERT_TRUE(outer != NULL);
+
+    EXPECT_EQ(1ULL, inner->scopes);
+    EXPECT_EQ(1ULL, inner->allocations);
+    EXPECT_EQ(1ULL, inner->frees);
+    EXPECT_EQ((uint64_t)(1 << 20), inner->bytes);
+    EXPECT_GE(inner->peakLiveBytes, 1 << 20);
+    EXPECT_GT(inner->maxRssKb, 0);
+
+    // The vector and its elements
+    EXPECT_EQ(2ULL, outer->allocations);
+    EXPECT_EQ(0ULL, outer->frees);
+    EXPECT_GE(outer->bytes, 1000ULL);
+    // The peak of the inner scope counts for the outer one
+    EXPECT_GE(outer->peakLiveBytes, 1 << 20);
+
+    EXPECT_GE(AllocationTracker::liveBytes() - liveBefore, 1000);
+    EXPECT_GE(AllocationTracker::peakLiveBytes() - liveBefore, 1 << 20);
+    delete kept;
+
+    std::ostringstream json;
+    Profiler::writeJson(json);
+    EXPECT_NE(std::string::npos, json.str().find("\"memory\": {\"max_rss_kb\": "));
+    EXPECT_NE(std::string::npos, json.str().find(
+                "{\"name\": \"testAllocationInner\", \"scopes\": 1, "
+                "\"allocations\": 1, \"frees\": 1, \"bytes\": 1048576, "));
+}
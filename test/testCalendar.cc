@@ -0,0 +1,107 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "Date.h"
+#include "Calendar.h"
+
+using boost::gregorian::date;
+
+class CalendarTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing Calendar Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing Calendar Class --------"
+                << std::endl << std::endl;
+        }
+};
+
+TEST_F(CalendarTest, WeekendCalendarMatchesWeekdays)
+{
+    Calendar calendar;
+    date day(2012, 1, 1);
+    for(int i = 0; i < 3000; i ++, day += boost::gregorian::date_duration(1))
+    {
+        boost::gregorian::greg_weekday gw = day.day_of_week();
+        bool weekend = gw == boost::gregorian::Saturday || gw == boost::gregorian::Sunday;
+        date expected = weekend ? boost::gregorian::next_weekday(day,
+                boost::gregorian::greg_weekday(boost::gregorian::Monday)) : day;
+
+        EXPECT_EQ(!weekend, calendar.isBusinessDay(Date(day)));
+        EXPECT_EQ(Date(expected), calendar.adjust(Date(day)));
+    }
+
+    // Out of the tables, weekends are still skipped
+    EXPECT_EQ(Date(date(2300, 1, 1)), calendar.adjust(Date(date(2299, 12, 31))));
+}
+
+TEST_F(CalendarTest, HolidayCalendar)
+{
+    Calendar calendar = Calendar::fromCSV("testCalendarData/holidays.csv", "TEST");
+    EXPECT_EQ(4u, calendar.holidays().size());
+
+    EXPECT_FALSE(calendar.isBusinessDay(Date(date(2013, 12, 25))));
+    EXPECT_EQ(Date(date(2013, 12, 27)), calendar.adjust(Date(date(2013, 12, 25))));
+    EXPECT_EQ(Date(date(2013, 12, 24)),
+            calendar.adjust(Date(date(2013, 12, 26)), Calendar::PRECEDING));
+
+    // Following would move to June, so go back over the holiday
+    EXPECT_EQ(Date(date(2014, 6, 2)), calendar.adjust(Date(date(2014, 5, 31))));
+    EXPECT_EQ(Date(date(2014, 5, 29)),
+            calendar.adjust(Date(date(2014, 5, 31)), Calendar::MODIFIEDFOLLOWING));
+
+    EXPECT_EQ(Date(date(2013, 12, 27)), calendar.addBusinessDays(Date(date(2013, 12, 24)), 1));
+    EXPECT_EQ(Date(date(2013, 12, 30)), calendar.addBusinessDays(Date(date(2013, 12, 25)), 2));
+    EXPECT_EQ(Date(date(2013, 12, 24)), calendar.addBusinessDays(Date(date(2013, 12, 27)), -1));
+    EXPECT_EQ(Date(date(2013, 12, 30)), calendar.addBusinessDays(Date(date(2013, 12, 28)), 0));
+
+    EXPECT_EQ(3, calendar.businessDaysBetween(Date(date(2013, 12, 23)), Date(date(2013, 12, 30))));
+    EXPECT_EQ(-3, calendar.businessDaysBetween(Date(date(2013, 12, 30)), Date(date(2013, 12, 23))));
+
+    // Against stepping one day at a time
+    date start(2013, 11, 20);
+    for(int n = -30; n <= 30; n ++)
+    {
+        date day = start;
+        int remaining = n;
+        while(remaining != 0)
+        {
+            day += boost::gregorian::date_duration(remaining > 0 ? 1 : -1);
+            if(calendar.isBusinessDay(Date(day)))
+                remaining += remaining > 0 ? -1 : 1;
+        }
+        if(n != 0)
+        {
+            EXPECT_EQ(Date(day), calendar.addBusinessDays(Date(start), n)) << "n = " << n;
+        }
+    }
+
+    EXPECT_THROW(Calendar::fromCSV("testCalendarData/none.csv", "NONE"), CalendarException);
+}
+
+TEST_F(CalendarTest, JointCalendarAndWorkDate)
+{
+    Calendar first = Calendar::fromCSV("testCalendarData/holidays.csv", "TEST");
+    std::vector<Date> holidays;
+    holidays.push_back(Date(date(2013, 12, 24)));
+    Calendar second("EVE", holidays, date(2000, 1, 1), date(2050, 12, 31));
+
+    Calendar joint = Calendar::joint(first, second);
+    EXPECT_EQ("TEST+EVE", joint.name());
+    EXPECT_EQ(3, joint.businessDaysBetween(Date(date(2013, 12, 23)), Date(date(2013, 12, 31))));
+    EXPECT_EQ(Date(date(2013, 12, 27)), joint.adjust(Date(date(2013, 12, 24))));
+    EXPECT_THROW(joint.addBusinessDays(Date(date(2051, 1, 3)), 1), CalendarException);
+
+    Calendar::setWorkCalendar(joint);
+    EXPECT_EQ(Date(date(2013, 12, 27)), WorkDate(Date(date(2013, 12, 24))));
+    Calendar::setWorkCalendar(Calendar());
+    EXPECT_EQ(Date(date(2013, 12, 24)), WorkDate(Date(date(2013, 12, 24))));
+}
@@ -0,0 +1,144 @@
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "ColumnarFile.h"
+
+using namespace Columnar;
+
+class ColumnarFileTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing Columnar File --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing Columnar File --------"
+                << std::endl << std::endl;
+        }
+
+        virtual void SetUp()
+        {
+            char nameTemplate[] = "/tmp/testColumnarFileXXXXXX";
+            int fd = mkstemp(nameTemplate);
+            close(fd);
+            filename = nameTemplate;
+        }
+
+        virtual void TearDown()
+        {
+            unlink(filename.c_str());
+        }
+
+        std::string filename;
+};
+
+TEST_F(ColumnarFileTest, WriteAndMapBack)
+{
+    Schema schema;
+    schema.push_back(std::make_pair(std::string("Date"), DATE32));
+    schema.push_back(std::make_pair(std::string("Count"), INT64));
+    schema.push_back(std::make_pair(std::string("Discount Factor"), FLOAT64));
+
+    const int numRows = 2500;
+    boost::gregorian::date startDate(2013, boost::gregorian::Jan, 22);
+    {
+        ColumnarWriter writer(filename, schema, 1000);
+        for(int i = 0; i < numRows; i ++)
+        {
+            writer.setDate(0, Date(startDate + boost::gregorian::date_duration(i)));
+            writer.setInt64(1, 10000000000LL + i);
+            writer.setFloat64(2, 1.0 / (1.0 + i));
+            writer.endRow();
+        }
+
+        EXPECT_THROW(writer.setFloat64(0, 1.0), ColumnarFileException);
+    }
+
+    ColumnarReader reader(filename);
+    ASSERT_EQ(3, reader.numColumns());
+    EXPECT_EQ("Date", reader.columnName(0));
+    EXPECT_EQ("Discount Factor", reader.columnName(2));
+    EXPECT_EQ(FLOAT64, reader.columnType(2));
+    EXPECT_EQ(1, reader.findColumn("Count"));
+    EXPECT_EQ(-1, reader.findColumn("Rate"));
+    EXPECT_EQ((uint64_t)numRows, reader.numRows());
+    ASSERT_EQ(3, reader.numChunks());
+    EXPECT_EQ(500u, reader.chunkRows(2));
+
+    int row = 0;
+    for(int chunk = 0; chunk < reader.numChunks(); chunk ++)
+    {
+        const int32_t *dates = reader.int32Column(chunk, 0);
+        const int64_t *counts = reader.int64Column(chunk, 1);
+        const double *dfs = reader.float64Column(chunk, 2);
+
+        EXPECT_EQ(0u, (size_t)dates % alignment);
+        EXPECT_EQ(0u, (size_t)counts % alignment);
+        EXPECT_EQ(0u, (size_t)dfs % alignment);
+
+        for(uint64_t i = 0; i < reader.chunkRows(chunk); i ++, row ++)
+        {
+            EXPECT_EQ(Date(startDate + boost::gregorian::date_duration(row)),
+                    fromDate32(dates[i]));
+            EXPECT_EQ(10000000000LL + row, counts[i]);
+            EXPECT_EQ(1.0 / (1.0 + row), dfs[i]);
+        }
+    }
+    EXPECT_EQ(numRows, row);
+
+    EXPECT_THROW(reader.float64Column(0, 1), ColumnarFileException);
+}
+
+TEST_F(ColumnarFileTest, IncompleteRowAndBadFile)
+{
+    Schema schema;
+    schema.push_back(std::make_pair(std::string("A"), INT32));
+    schema.push_back(std::make_pair(std::string("B"), FLOAT64));
+
+    {
+        ColumnarWriter writer(filename, schema);
+        writer.setInt32(0, 1);
+        EXPECT_THROW(writer.endRow(), ColumnarFileException);
+    }
+
+    {
+        ColumnarWriter writer(filename, schema);
+    }
+    ColumnarReader emptyReader(filename);
+    EXPECT_EQ(0u, emptyReader.numRows());
+    EXPECT_EQ(0, emptyReader.numChunks());
+
+    EXPECT_THROW(ColumnarReader reader("testColumnarFile.cc"), ColumnarFileException);
+}
+
+TEST_F(ColumnarFileTest, OtherByteOrder)
+{
+    Schema schema;
+    schema.push_back(std::make_pair(std::string("A"), INT32));
+    {
+        ColumnarWriter writer(filename, schema);
+        writer.setInt32(0, 1);
+        writer.endRow();
+    }
+
+    // As a host of the other byte order would have written it
+    ColumnarFileHeader header;
+    FILE *file = fopen(filename.c_str(), "r+b");
+    ASSERT_TRUE(file != NULL);
+    ASSERT_EQ(1u, fread(&header, sizeof(header), 1, file));
+    EXPECT_EQ(byteOrderMark, header.byteOrder);
+    header.byteOrder = 0x04030201;
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+
+    EXPECT_THROW(ColumnarReader reader(filename), ColumnarFileException);
+}
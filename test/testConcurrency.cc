@@ -0,0 +1,285 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "Concurrency.h"
+
+using namespace Concurrency;
+
+class ConcurrencyTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing Concurrency --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing Concurrency --------"
+                << std::endl << std::endl;
+        }
+};
+
+namespace
+{
+    // Record the order in which the tasks finish
+    struct ExecutionLog
+    {
+        ExecutionLog():numFinished(0){};
+
+        volatile int numFinished;
+        std::vector<int> finishOrder;
+    };
+
+    class LoggingTask : public Runnable
+    {
+        public:
+            LoggingTask(ExecutionLog& log, int id):_log(log), _id(id){};
+
+            virtual void run()
+            {
+                int slot = __sync_fetch_and_add(&_log.numFinished, 1);
+                _log.finishOrder[slot] = _id;
+            }
+
+        private:
+            ExecutionLog& _log;
+            int _id;
+    };
+
+    class ThrowingTask : public Runnable
+    {
+        public:
+            virtual void run()
+            {
+                throw std::runtime_error("task failed");
+            }
+    };
+
+    // Add a chain of tasks to the graph while running
+    class ExpandingTask : public Runnable
+    {
+        public:
+            ExpandingTask(TaskGraph& graph, ExecutionLog& log):
+                _graph(graph), _log(log){};
+
+            ~ExpandingTask()
+            {
+                for(int i = 0; i < (int)_tasks.size(); i ++)
+                    delete _tasks[i];
+            }
+
+            virtual void run()
+            {
+                TaskGraph::TaskId last = -1;
+                for(int i = 0; i < 50; i ++)
+                {
+                    _tasks.push_back(new LoggingTask(_log, i));
+                    if(last < 0)
+                        last = _graph.addTask(*_tasks.back());
+                    else
+                        last = _graph.addTask(*_tasks.back(), last);
+                }
+            }
+
+        private:
+            TaskGraph& _graph;
+            ExecutionLog& _log;
+            std::vector<Runnable *> _tasks;
+    };
+
+    class Producer : public Runnable
+    {
+        public:
+            Producer(BoundedSPSCQueue<int>& queue, int count):
+                _queue(queue), _count(count){};
+
+            virtual void run()
+            {
+                for(int i = 1; i <= _count; i ++)
+                    _queue.push(i);
+            }
+
+        private:
+            BoundedSPSCQueue<int>& _queue;
+            int _count;
+    };
+
+    // A snapshot whose fields are overwritten when deleted
+    struct Version
+    {
+        explicit Version(int iversion):
+            first(iversion), second(iversion){};
+        ~Version()
+        {
+            first = -1;
+            second = -2;
+            __sync_fetch_and_add(&numDeleted, 1);
+        }
+
+        volatile int first;
+        volatile int second;
+        static volatile int numDeleted;
+    };
+    volatile int Version::numDeleted = 0;
+
+    class SnapshotReader : public Runnable
+    {
+        public:
+            SnapshotReader(SnapshotHolder<Version>& holder,
+                    volatile bool& stop):
+                _holder(holder), _stop(stop), numReads(0), numErrors(0){};
+
+            virtual void run()
+            {
+                int last = 0;
+                while(!_stop)
+                {
+                    SnapshotHolder<Version>::Pin pin(_holder);
+                    int first = pin->first;
+                    sched_yield();
+                    if(first != pin->second || first < last)
+                        numErrors ++;
+                    last = first;
+                    numReads ++;
+                }
+            }
+
+        private:
+            SnapshotHolder<Version>& _holder;
+            volatile bool& _stop;
+
+        public:
+            int numReads;
+            int numErrors;
+    };
+}
+
+TEST_F(ConcurrencyTest, BoundedSPSCQueue)
+{
+    BoundedSPSCQueue<int> small(3);
+    int item;
+    EXPECT_FALSE(small.tryPop(item));
+    for(int i = 0; i < 4; i ++)
+        EXPECT_TRUE(small.tryPush(i));
+    EXPECT_FALSE(small.tryPush(4));
+    EXPECT_TRUE(small.tryPop(item));
+    EXPECT_EQ(0, item);
+
+    const int count = 100000;
+    BoundedSPSCQueue<int> queue(16);
+    Producer producer(queue, count);
+    long long sum = 0;
+    bool inOrder = true;
+    {
+        Thread thread(producer);
+        for(int i = 1; i <= count; i ++)
+        {
+            int value = queue.pop();
+            inOrder = inOrder && value == i;
+            sum += value;
+        }
+    }
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ((long long)count * (count + 1) / 2, sum);
+}
+
+TEST_F(ConcurrencyTest, TaskGraphRespectsDependencies)
+{
+    // A diamond: 0 -> {1, 2} -> 3
+    ExecutionLog log;
+    log.finishOrder.resize(4);
+    std::vector<LoggingTask *> tasks;
+    for(int i = 0; i < 4; i ++)
+        tasks.push_back(new LoggingTask(log, i));
+
+    TaskGraph graph;
+    TaskGraph::TaskId top = graph.addTask(*tasks[0]);
+    std::vector<TaskGraph::TaskId> middle;
+    middle.push_back(graph.addTask(*tasks[1], top));
+    middle.push_back(graph.addTask(*tasks[2], top));
+    graph.addTask(*tasks[3], middle);
+    graph.run(4);
+
+    EXPECT_EQ(4, log.numFinished);
+    EXPECT_EQ(0, log.finishOrder[0]);
+    EXPECT_EQ(3, log.finishOrder[3]);
+
+    // Tasks added from a running task, depending on each other
+    ExecutionLog chainLog;
+    chainLog.finishOrder.resize(50);
+    ExpandingTask expanding(graph, chainLog);
+    graph.addTask(expanding);
+    graph.run(3);
+
+    ASSERT_EQ(50, chainLog.numFinished);
+    for(int i = 0; i < 50; i ++)
+        EXPECT_EQ(i, chainLog.finishOrder[i]);
+
+    while(!tasks.empty())
+    {
+        delete tasks.back();
+        tasks.pop_back();
+    }
+}
+
+TEST_F(ConcurrencyTest, TaskGraphStopsOnError)
+{
+    ExecutionLog log;
+    log.finishOrder.resize(1);
+    ThrowingTask throwing;
+    LoggingTask dependent(log, 0);
+
+    TaskGraph graph;
+    graph.addTask(dependent, graph.addTask(throwing));
+    EXPECT_THROW(graph.run(2), ConcurrencyException);
+    EXPECT_EQ(0, log.numFinished);
+
+    EXPECT_THROW(graph.addTask(dependent, 5), ConcurrencyException);
+}
+
+TEST_F(ConcurrencyTest, SnapshotHolderReclaimsUnpinnedSnapshots)
+{
+    const int numVersions = 2000;
+    Version::numDeleted = 0;
+    {
+        SnapshotHolder<Version> holder(new Version(0), 4);
+        volatile bool stop = false;
+
+        std::vector<SnapshotReader *> readers;
+        std::vector<Thread *> threads;
+        for(int i = 0; i < 3; i ++)
+        {
+            readers.push_back(new SnapshotReader(holder, stop));
+            threads.push_back(new Thread(*readers.back()));
+        }
+
+        for(int i = 1; i <= numVersions; i ++)
+        {
+            holder.publish(new Version(i));
+            if(i % 100 == 0)
+                sched_yield();
+        }
+        stop = true;
+
+        for(int i = 0; i < 3; i ++)
+        {
+            threads[i]->join();
+            EXPECT_EQ(0, readers[i]->numErrors);
+            EXPECT_GT(readers[i]->numReads, 0);
+            delete threads[i];
+            delete readers[i];
+        }
+
+        // Nothing is pinned any more
+        EXPECT_EQ(0u, holder.numRetired());
+        EXPECT_EQ(numVersions, Version::numDeleted);
+
+        SnapshotHolder<Version>::Pin pin(holder);
+        EXPECT_EQ(numVersions, pin->first);
+    }
+    EXPECT_EQ(numVersions + 1, Version::numDeleted);
+}
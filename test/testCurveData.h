@@ -0,0 +1,47 @@
+#ifndef _TEST_TESTCURVEDATA_H_
+#define _TEST_TESTCURVEDATA_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Instrument.h"
+
+// The instrument definitions of a curve definition csv file
+inline void readCurveDefinitions(const std::string& filename,
+        std::vector<InstrumentDefinition>& instrDefs)
+{
+    std::ifstream fin(filename.c_str());
+    std::string line;
+
+    getline(fin, line);
+    while(getline(fin, line))
+        instrDefs.push_back(InstrumentDefinition::parseString(line));
+    fin.close();
+}
+
+// The quotes of a curve data csv file
+inline void readCurveData(const std::string& filename, InstrumentValues& values)
+{
+    std::ifstream fin(filename.c_str());
+    std::string line;
+    char comma;
+    int id;
+    double rate;
+
+    getline(fin, line);
+    while(fin >> id >> comma >> rate)
+        values.values.push_back(std::pair<int, double>(id, rate));
+    fin.close();
+}
+
+// The curve most of the tests bind: curveSpec1.csv and
+// curveDataInput1.csv of testYieldCurveData
+inline void loadCurve1(std::vector<InstrumentDefinition>& instrDefs,
+        InstrumentValues& values)
+{
+    readCurveDefinitions("testYieldCurveData/curveSpec1.csv", instrDefs);
+    readCurveData("testYieldCurveData/curveDataInput1.csv", values);
+}
+
+#endif // _TEST_TESTCURVEDATA_H_
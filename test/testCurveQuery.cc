@@ -0,0 +1,149 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+#include "CurveQuery.h"
+#include "testCurveData.h"
+
+class CurveQueryTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing StreamingCurveQuery Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing StreamingCurveQuery Class --------"
+                << std::endl << std::endl;
+        }
+};
+
+TEST_F(CurveQueryTest, ParseDate)
+{
+    std::string str;
+    Date date;
+
+    str = "2011/04/23";
+    EXPECT_TRUE(StreamingCurveQuery::parseDate(str.data(), str.data() + str.size(), date));
+    EXPECT_EQ(Date(boost::gregorian::date(2011, 4, 23)), date);
+
+    str = "2012-1-5";
+    EXPECT_TRUE(StreamingCurveQuery::parseDate(str.data(), str.data() + str.size(), date));
+    EXPECT_EQ(Date(boost::gregorian::date(2012, 1, 5)), date);
+
+    str = "2012-Feb-29";
+    EXPECT_TRUE(StreamingCurveQuery::parseDate(str.data(), str.data() + str.size(), date));
+    EXPECT_EQ(Date(boost::gregorian::date(2012, 2, 29)), date);
+
+    str = "2011/02/30";
+    EXPECT_FALSE(StreamingCurveQuery::parseDate(str.data(), str.data() + str.size(), date));
+
+    str = "Date";
+    EXPECT_FALSE(StreamingCurveQuery::parseDate(str.data(), str.data() + str.size(), date));
+}
+
+namespace
+{
+    class CollectingSink : public CurveQuerySink
+    {
+        public:
+            CollectingSink():numBatches(0){};
+
+            virtual void consume(const std::vector<CurveQueryResult>& batch)
+            {
+                results.insert(results.end(), batch.begin(), batch.end());
+                numBatches ++;
+            }
+
+            std::vector<CurveQueryResult> results;
+            int numBatches;
+    };
+
+    // Run the query over the text written to a temporary file
+    void runQuery(const StreamingCurveQuery& query, const std::string& text,
+            CollectingSink& sink)
+    {
+        char nameTemplate[] = "/tmp/testCurveQueryXXXXXX";
+        int fd = mkstemp(nameTemplate);
+        ASSERT_EQ((ssize_t)text.size(), write(fd, text.data(), text.size()));
+        lseek(fd, 0, SEEK_SET);
+
+        query.run(fd, true, sink);
+        close(fd);
+        unlink(nameTemplate);
+    }
+}
+
+TEST_F(CurveQueryTest, StreamingQueryMatchesSingleLookups)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+    YieldCurveInstance *yci = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE);
+
+    // Walk back and forth over the curve range and beyond it,
+    // with some invalid dates in between, so that the input is
+    // not sorted and spans many batches
+    std::ostringstream oss;
+    oss << "\"Date\"\n";
+    std::vector<Date> expectedDates;
+    std::vector<double> expectedDfs, expectedRates;
+    Date today = Date::today();
+    for(int i = 0; i < 20000; i ++)
+    {
+        long offset = (i * 7919L) % 1500 - 100;
+        Date date(today.get() + boost::gregorian::date_duration(offset));
+        oss << boost::gregorian::to_iso_extended_string(date.get()) << "\n";
+
+        if(i % 1000 == 0)
+            oss << "2011/13/01\n";
+
+        Date workDate = WorkDate(date);
+        try
+        {
+            double df = yci->getDf(workDate);
+            double rate = (*yci)[workDate];
+            expectedDates.push_back(workDate);
+            expectedDfs.push_back(df);
+            expectedRates.push_back(rate);
+        }
+        catch(YieldCurveException& e)
+        {
+        }
+    }
+    std::string text = oss.str();
+
+    // Default batches, and small ones which make most of the
+    // dates straddle two reads
+    size_t batchBytes[] = {StreamingCurveQuery::defaultBatchBytes, 100};
+    for(int b = 0; b < 2; b ++)
+    {
+        CollectingSink sink;
+        StreamingCurveQuery query(*yci, 3, batchBytes[b]);
+        runQuery(query, text, sink);
+        if(b == 1)
+        {
+            EXPECT_LT(1000, sink.numBatches);
+        }
+
+        ASSERT_EQ(expectedDates.size(), sink.results.size());
+        for(int i = 0; i < (int)sink.results.size(); i ++)
+        {
+            EXPECT_EQ(expectedDates[i], sink.results[i].get<0>()) << "at " << i;
+            EXPECT_DOUBLE_EQ(expectedDfs[i], sink.results[i].get<1>()) << "at " << i;
+            EXPECT_DOUBLE_EQ(expectedRates[i], sink.results[i].get<2>()) << "at " << i;
+        }
+    }
+
+    delete yci;
+}
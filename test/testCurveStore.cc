@@ -0,0 +1,150 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+#include "CurveStore.h"
+#include "testCurveData.h"
+
+class CurveStoreTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing CurveStore Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing CurveStore Class --------"
+                << std::endl << std::endl;
+        }
+};
+
+TEST_F(CurveStoreTest, PublishAndAttach)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    Date today = WorkDate(Date::today());
+    YieldCurveInstance *zcr = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+    YieldCurveInstance *logDf = ycDef.bindData(&values,
+            YieldCurveDefinition::LOGDISCOUNTFACTOR, today);
+
+    std::ostringstream oss;
+    oss << "testCurveStore." << getpid();
+    std::string storeName = oss.str();
+    CurveStoreWriter::remove(storeName);
+
+    CurveStoreWriter writer(storeName);
+    EXPECT_THROW(CurveStoreReader reader(storeName), CurveStoreException);
+
+    // Added lazily bootstrapped, published complete
+    writer.add("USD.ZCR", *zcr);
+    writer.add("USD.LOGDF", *logDf);
+    EXPECT_EQ(1u, writer.publish());
+
+    CurveStoreReader reader(storeName);
+    EXPECT_EQ(1u, reader.version());
+    ASSERT_EQ(2, reader.numCurves());
+    EXPECT_TRUE(reader.find("EUR.ZCR") == NULL);
+
+    const YieldCurveInstance *sharedZcr = reader.find("USD.ZCR");
+    const YieldCurveInstance *sharedLogDf = reader.find("USD.LOGDF");
+    ASSERT_TRUE(sharedZcr != NULL);
+    ASSERT_TRUE(sharedLogDf != NULL);
+    EXPECT_EQ("USD.LOGDF", reader.curveName(0));
+    EXPECT_EQ("USD.ZCR", reader.curveName(1));
+    EXPECT_EQ(sharedZcr, &reader.curve(1));
+    EXPECT_EQ(YieldCurveDefinition::ZEROCOUPONRATE, sharedZcr->curveType());
+    EXPECT_EQ(YieldCurveDefinition::LOGDISCOUNTFACTOR, sharedLogDf->curveType());
+    EXPECT_EQ(zcr->compoundFreq(), sharedZcr->compoundFreq());
+    EXPECT_EQ(zcr->numSolvedPoints(), sharedZcr->numSolvedPoints());
+    EXPECT_EQ(today, sharedZcr->startDate());
+
+    // Evaluated exactly like the curves they came from
+    std::vector<Date> dates;
+    for(int days = 1; days < 3 * 365; days += 11)
+    {
+        Date date = today + Duration(days, Duration::DAY);
+        EXPECT_EQ((*zcr)[date], (*sharedZcr)[date]);
+        EXPECT_EQ(zcr->getDf(date), sharedZcr->getDf(date));
+        EXPECT_EQ(logDf->getDf(date), sharedLogDf->getDf(date));
+        dates.push_back(date);
+    }
+    Date farDate = today + Duration(10, Duration::YEAR);
+    EXPECT_THROW(sharedZcr->getDf(farDate), YieldCurveException);
+
+    // Including the batch lookups and their extrapolation
+    dates.push_back(farDate);
+    std::vector<double> rates, dfs, sharedRates, sharedDfs;
+    std::vector<YieldCurveInstance::LOOKUPSTATUS> status, sharedStatus;
+    zcr->lookup(dates, YieldCurveInstance::FLATFORWARD, rates, dfs, status);
+    sharedZcr->lookup(dates, YieldCurveInstance::FLATFORWARD, sharedRates,
+            sharedDfs, sharedStatus);
+    EXPECT_EQ(rates, sharedRates);
+    EXPECT_EQ(dfs, sharedDfs);
+    EXPECT_EQ(status, sharedStatus);
+    EXPECT_EQ(YieldCurveInstance::EXTRAPOLATED, sharedStatus.back());
+
+    // Read in place, with the points and the sensitivities of the
+    // curves they came from
+    std::vector<Date> pointDates, sharedPointDates;
+    zcr->getPointDates(pointDates);
+    sharedZcr->getPointDates(sharedPointDates);
+    EXPECT_EQ(pointDates, sharedPointDates);
+    std::vector<std::pair<Date, double> > weights, sharedWeights;
+    zcr->getDfWeights(dates[20], weights);
+    sharedZcr->getDfWeights(dates[20], sharedWeights);
+    EXPECT_EQ(weights, sharedWeights);
+
+    Date date = today + Duration(400, Duration::DAY);
+    Date horizon = today + Duration(90, Duration::DAY);
+    YieldCurveInstance *rolled = zcr->rollForward(horizon);
+    YieldCurveInstance *sharedRolled = sharedZcr->rollForward(horizon);
+    EXPECT_EQ(rolled->getDf(date), sharedRolled->getDf(date));
+
+    // A copy holds its own points
+    const ZeroCouponRateCurve *sharedCurve =
+        dynamic_cast<const ZeroCouponRateCurve *>(sharedZcr);
+    ASSERT_TRUE(sharedCurve != NULL);
+    ZeroCouponRateCurve copy(*sharedCurve);
+    double df = sharedZcr->getDf(date);
+    EXPECT_EQ(df, copy.getDf(date));
+
+    // A new snapshot leaves the mapped one readable until refresh
+    writer.add("USD.ZCR", *logDf);
+    EXPECT_EQ(2u, writer.publish());
+    EXPECT_TRUE(reader.isStale());
+    EXPECT_EQ(df, sharedZcr->getDf(date));
+
+    EXPECT_TRUE(reader.refresh());
+    EXPECT_EQ(df, copy.getDf(date));
+    EXPECT_FALSE(reader.isStale());
+    EXPECT_FALSE(reader.refresh());
+    EXPECT_EQ(2u, reader.version());
+    sharedZcr = reader.find("USD.ZCR");
+    ASSERT_TRUE(sharedZcr != NULL);
+    EXPECT_EQ(YieldCurveDefinition::LOGDISCOUNTFACTOR, sharedZcr->curveType());
+    EXPECT_EQ(logDf->getDf(date), sharedZcr->getDf(date));
+
+    CurveStoreReader other(storeName);
+    EXPECT_EQ(2u, other.version());
+
+    CurveStoreWriter::remove(storeName);
+    EXPECT_THROW(CurveStoreReader removed(storeName), CurveStoreException);
+
+    delete zcr;
+    delete logDf;
+    delete rolled;
+    delete sharedRolled;
+}
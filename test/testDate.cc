@@ -451,3 +451,64 @@ TEST_F(DurationTest, DurationArithmetics)
 
     EXPECT_DOUBLE_EQ(2.5, (oneQuarter * 10.0).getDuration(Duration::YEAR));
 }
+
+TEST_F(DurationTest, TenorKeys)
+{
+    std::string str("1Y");
+    EXPECT_EQ(Tenor(12, 0), Duration(str).tenor());
+    str = "2W";
+    EXPECT_EQ(Tenor(0, 14), Duration(str).tenor());
+    str = "ON";
+    EXPECT_EQ(Tenor(0, 1), Duration(str).tenor());
+
+    // Exact tenors, 1M and 30D are no longer equal
+    EXPECT_EQ(Duration(12, Duration::MONTH), Duration(1, Duration::YEAR));
+    EXPECT_EQ(Duration(3, Duration::MONTH), Duration(1, Duration::QUARTER));
+    EXPECT_LT(Duration(30, Duration::DAY), Duration(1, Duration::MONTH));
+    EXPECT_LT(Duration(1, Duration::MONTH), Duration(31, Duration::DAY));
+    EXPECT_LT(Duration(13, Duration::WEEK), Duration(3, Duration::MONTH));
+
+    Tenor quarter(3, 0);
+    EXPECT_EQ(Tenor(30, 0), quarter * 10);
+    EXPECT_EQ(Tenor(3, 7), quarter + Tenor(0, 7));
+    EXPECT_EQ(quarter, Tenor(3, 7) - Tenor(0, 7));
+    EXPECT_LT(Tenor(0, 91), quarter);
+
+    // Months first, keeping the end of the month, then days
+    Date date(boost::gregorian::date(2013, 1, 31));
+    EXPECT_EQ(Date(boost::gregorian::date(2013, 2, 28)), date + Tenor(1, 0));
+    EXPECT_EQ(Date(boost::gregorian::date(2013, 3, 7)), date + Tenor(1, 7));
+    EXPECT_EQ(date + Duration(1, Duration::QUARTER), date + quarter);
+}
+
+TEST_F(DurationTest, ScaledTenorsRound)
+{
+    // A fraction of a year scaled back up is the nearest month,
+    // never one short of it
+    Duration oneYear(1, Duration::YEAR);
+    int freqs[] = {3, 4, 6, 12};
+    for(int f = 0; f < 4; f ++)
+    {
+        Duration period(oneYear / freqs[f]);
+        for(int i = 1; i <= 60; i ++)
+        {
+            EXPECT_EQ(Tenor(i * 12 / freqs[f], 0), (period * i).tenor())
+                << "frequency " << freqs[f] << " period " << i;
+            EXPECT_EQ(i, (period * i).periods(period));
+        }
+    }
+    EXPECT_EQ(Tenor(7, 0), (oneYear / 12 * 7).tenor());
+    EXPECT_EQ(7, Duration(7, Duration::MONTH).periods(oneYear / 12));
+    EXPECT_EQ(7, Duration(28, Duration::MONTH).periods(oneYear / 3));
+    EXPECT_EQ(1, Duration(7, Duration::MONTH).periods(oneYear / 3));
+
+    // A real fraction of a month is kept in days
+    Duration monthAndHalf(1.5, Duration::MONTH);
+    EXPECT_EQ(Tenor(1, 15), monthAndHalf.tenor());
+    EXPECT_FALSE(monthAndHalf == Duration(1, Duration::MONTH));
+    EXPECT_LT(Duration(1, Duration::MONTH), monthAndHalf);
+
+    // A part of a day is dropped
+    EXPECT_EQ(Tenor(0, 1), Duration(1.6, Duration::DAY).tenor());
+    EXPECT_EQ(Tenor(0, 10), Duration(1.5, Duration::WEEK).tenor());
+}
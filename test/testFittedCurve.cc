@@ -0,0 +1,103 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "gtest/gtest.h"
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+#include "FittedCurve.h"
+#include "testCurveData.h"
+
+class FittedCurveTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing FittedCurve Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing FittedCurve Class --------"
+                << std::endl << std::endl;
+        }
+};
+
+TEST_F(FittedCurveTest, ClosedFormEvaluation)
+{
+    NSSParameters params = {0.05, -0.02, 0.01, 0.005, 1.5, 6.0};
+    Date today = WorkDate(Date::today());
+    NelsonSiegelSvenssonCurve curve(params, today);
+
+    // The short end tends to beta0 + beta1, the long end to beta0
+    EXPECT_NEAR(0.03, curve.zeroRate(0.0), 1e-12);
+    EXPECT_NEAR(0.05, curve.zeroRate(1000.0), 1e-4);
+    EXPECT_DOUBLE_EQ(1.0, curve.df(0.0));
+
+    std::vector<Date> dates;
+    for(int months = 1; months <= 360; months += 7)
+        dates.push_back(WorkDate(today + Duration(months, Duration::MONTH)));
+    // not sorted
+    std::swap(dates[0], dates[10]);
+
+    std::vector<double> rates, dfs;
+    curve.getZeroRates(dates, rates);
+    curve.getDfs(dates, dfs);
+    ASSERT_EQ(dates.size(), dfs.size());
+    for(int i = 0; i < (int)dates.size(); i ++)
+    {
+        double t = normDiffDate(today, dates[i], Date::ACT365);
+        EXPECT_DOUBLE_EQ(curve.zeroRate(dates[i]), rates[i]);
+        EXPECT_DOUBLE_EQ(curve.getDf(dates[i]), dfs[i]);
+        EXPECT_NEAR(exp(-rates[i] * t), dfs[i], 1e-14);
+    }
+}
+
+TEST_F(FittedCurveTest, FitToQuotes)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    Date today = WorkDate(Date::today());
+    NelsonSiegelSvenssonCurve fitted = NelsonSiegelSvenssonCurve::fit(ycDef,
+            values, today);
+    EXPECT_EQ(today, fitted.startDate());
+    EXPECT_GT(fitted.numIterations(), 0);
+    EXPECT_GT(fitted.parameters().tau1, 0.0);
+    EXPECT_GT(fitted.parameters().tau2, 0.0);
+
+    // Six parameters cannot reprice fourteen quotes exactly; the
+    // largest miss is the kink between the 6x9 FRA and the 1Y swap
+    const std::vector<double>& quoteResiduals = fitted.quoteResiduals();
+    ASSERT_EQ(values.values.size(), quoteResiduals.size());
+    double sumSquares = 0.0;
+    for(int j = 0; j < (int)quoteResiduals.size(); j ++)
+    {
+        EXPECT_LT(fabs(quoteResiduals[j]), 0.2) << "Quote " << values.values[j].first;
+        sumSquares += quoteResiduals[j] * quoteResiduals[j];
+    }
+    EXPECT_LT(sqrt(sumSquares / quoteResiduals.size()), 0.1);
+
+    // Against the bootstrapped curve at its pillars
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::CONTINUOUSRATE, today);
+    std::vector<Date> dates(ycDef.getPillarDates(today).get());
+    std::vector<double> residuals;
+    double maxResidual = fitted.residuals(*yci, dates, residuals);
+    ASSERT_EQ(dates.size(), residuals.size());
+    EXPECT_LT(maxResidual, 0.2);
+    for(int i = 0; i < (int)dates.size(); i ++)
+    {
+        Date date = dates[i];
+        double t = normDiffDate(today, date, Date::ACT365);
+        double expected = (fitted.zeroRate(date) + log(yci->getDf(date)) / t) * 100.0;
+        EXPECT_NEAR(expected, residuals[i], 1e-10);
+    }
+
+    delete yci;
+}
@@ -38,23 +38,21 @@ TEST_F(InstrumentTest, InstrumentInitializationTest1)
         if(!fin.good())
             break;
 
-        InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
+        InstrumentDefinition instrDef = InstrumentDefinition::parseString(line);
 
         std::string type;
-        if(instrDef->type() == InstrumentDefinition::CASH)
+        if(instrDef.type() == InstrumentDefinition::CASH)
             type = "CASH";
-        else if(instrDef->type() == InstrumentDefinition::FRA)
+        else if(instrDef.type() == InstrumentDefinition::FRA)
             type = "FRA";
-        else if(instrDef->type() == InstrumentDefinition::SWAP)
+        else if(instrDef.type() == InstrumentDefinition::SWAP)
             type = "SWAP";
         else 
             type = "N/A";
 
         EXPECT_EQ(ctype, type);
-        EXPECT_EQ(cmaturity, instrDef->subtype());
-        EXPECT_EQ(cindex, instrDef->index());
-
-        delete instrDef;
+        EXPECT_EQ(cmaturity, instrDef.subtype());
+        EXPECT_EQ(cindex, instrDef.index());
     }
 
     fin.close();
@@ -80,3 +78,21 @@ TEST_F(InstrumentTest, InstrumentInitializationTest2)
 
     fin.close();
 }
+
+TEST_F(InstrumentTest, InstrumentValueSemantics)
+{
+    std::string line("FRA,3x6,9");
+    InstrumentDefinition fra = InstrumentDefinition::parseString(line);
+    InstrumentDefinition copy = fra;
+
+    EXPECT_EQ(InstrumentDefinition::FRA, copy.type());
+    EXPECT_EQ(Duration(3, Duration::MONTH), copy.startDuration());
+    EXPECT_EQ(Duration(6, Duration::MONTH), copy.maturity());
+    EXPECT_EQ(9, copy.index());
+    EXPECT_EQ(fra.subtype(), copy.subtype());
+
+    InstrumentDefinition fake(InstrumentDefinition::FAKE,
+            Duration(1, Duration::YEAR), -1);
+    EXPECT_EQ(InstrumentDefinition::FAKE, fake.type());
+    EXPECT_EQ(-1, fake.index());
+}
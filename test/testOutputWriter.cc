@@ -0,0 +1,117 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "OutputWriter.h"
+
+class BufferedWriterTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing BufferedWriter Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing BufferedWriter Class --------"
+                << std::endl << std::endl;
+        }
+
+        virtual void SetUp()
+        {
+            char nameTemplate[] = "/tmp/testOutputWriterXXXXXX";
+            int fd = mkstemp(nameTemplate);
+            close(fd);
+            filename = nameTemplate;
+        }
+
+        virtual void TearDown()
+        {
+            unlink(filename.c_str());
+        }
+
+        std::string readBack()
+        {
+            std::ifstream fin(filename.c_str());
+            std::ostringstream oss;
+            oss << fin.rdbuf();
+            return oss.str();
+        }
+
+        std::string filename;
+};
+
+TEST_F(BufferedWriterTest, FixedFormatMatchesPrintf)
+{
+    std::string expected;
+    {
+        // Use a small buffer to go through many flushes
+        BufferedWriter writer(filename, 100);
+        char text[512];
+
+        srand(7802);
+        for(int i = 0; i < 100000; i ++)
+        {
+            double value = (rand() - RAND_MAX / 2) / (double)(rand() % 100000 + 1);
+            int precision = i % 10;
+
+            writer.writeFixed(value, precision).put('\n');
+            snprintf(text, sizeof(text), "%.*f\n", precision, value);
+            expected += text;
+        }
+
+        // Ties and special values
+        double specials[] = {0.5, 1.5, 2.5, 0.00005, 0.99995, -0.00001,
+            0.0, -0.0, 1e20, 123456789.123456789};
+        for(int i = 0; i < (int)(sizeof(specials) / sizeof(double)); i ++)
+        {
+            writer.writeFixed(specials[i], 4).put('\n');
+            writer.writeFixed(specials[i], 0).put('\n');
+            snprintf(text, sizeof(text), "%.4f\n%.0f\n", specials[i], specials[i]);
+            expected += text;
+        }
+    }
+
+    EXPECT_EQ(expected, readBack());
+}
+
+TEST_F(BufferedWriterTest, IntegerGeneralAndShortestFormat)
+{
+    {
+        BufferedWriter writer(filename);
+        writer.writeInt(0).put(' ').writeInt(-42).put(' ')
+            .writeInt(1234567890123LL).put(' ')
+            .writeInt(-9223372036854775807LL - 1).put('\n');
+        writer.writeGeneral(89.31, 4).put(' ').writeGeneral(100.125, 4)
+            .put(' ').writeGeneral(95, 4).put('\n');
+        writer.writeShortest(0.1).put(' ').writeShortest(1.0 / 3.0).put('\n');
+    }
+
+    EXPECT_EQ("0 -42 1234567890123 -9223372036854775808\n"
+            "89.31 100.1 95\n"
+            "0.1 0.3333333333333333\n", readBack());
+}
+
+TEST_F(BufferedWriterTest, DateFormatMatchesToString)
+{
+    std::string expected;
+    {
+        BufferedWriter writer(filename, 100);
+        boost::gregorian::date rawDate(1999, boost::gregorian::Dec, 25);
+        for(int i = 0; i < 3000; i ++)
+        {
+            Date date(rawDate + boost::gregorian::date_duration(i * 3));
+            writer.writeDate(date).put('\n');
+            expected += date.toString() + "\n";
+        }
+    }
+
+    EXPECT_EQ(expected, readBack());
+}
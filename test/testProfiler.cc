@@ -0,0 +1,179 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "Profiler.h"
+#include "Concurrency.h"
+
+class ProfilerTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing Profiler --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing Profiler --------"
+                << std::endl << std::endl;
+        }
+};
+
+namespace
+{
+    // Record a known number of times and counts on its own thread
+    class RecordingTask : public Concurrency::Runnable
+    {
+        public:
+            virtual void run()
+            {
+                int id = Profiler::timerId("testTimer");
+                for(int i = 1; i <= 100; i ++)
+                {
+                    Profiler::record(id, i * 1000);
+                    PROFILE_COUNT("testCounter", 2);
+                }
+            }
+    };
+
+    const Profiler::TimerReport *findTimer(
+            const std::vector<Profiler::TimerReport>& timers, const char *name)
+    {
+        for(int i = 0; i < (int)timers.size(); i ++)
+        {
+            if(timers[i].name == name)
+                return &timers[i];
+        }
+        return NULL;
+    }
+}
+
+TEST_F(ProfilerTest, MergesThreadBuffers)
+{
+    Profiler::reset();
+
+    // The buffers of the threads are merged when they exit
+    std::vector<Concurrency::Runnable *> tasks;
+    for(int i = 0; i < 4; i ++)
+        tasks.push_back(new RecordingTask());
+    Concurrency::runAll(tasks, 4);
+    for(int i = 0; i < (int)tasks.size(); i ++)
+        delete tasks[i];
+
+    EXPECT_EQ(800ULL, Profiler::counter("testCounter"));
+    EXPECT_EQ(4ULL * 5050000ULL, Profiler::totalNs("testTimer"));
+
+    std::vector<Profiler::TimerReport> timers;
+    std::vector<Profiler::CounterReport> counters;
+    Profiler::snapshot(timers, counters);
+    const Profiler::TimerReport *timer = findTimer(timers, "testTimer");
+    ASSERT_TRUE(timer != NULL);
+    EXPECT_EQ(400ULL, timer->count);
+    EXPECT_EQ(1000ULL, timer->minNs);
+    EXPECT_EQ(100000ULL, timer->maxNs);
+
+    // The percentiles are bucket bounds, within 25% of the times
+    EXPECT_GE(timer->p50Ns, 50000ULL);
+    EXPECT_LE(timer->p50Ns, 62500ULL);
+    EXPECT_GE(timer->p99Ns, 99000ULL);
+    EXPECT_LE(timer->p99Ns, 100000ULL);
+
+    Profiler::reset();
+    EXPECT_EQ(0ULL, Profiler::counter("testCounter"));
+    EXPECT_EQ(0ULL, Profiler::totalNs("testTimer"));
+    EXPECT_EQ(0ULL, Profiler::counter("notRegistered"));
+}
+
+TEST_F(ProfilerTest, ScopedTimer)
+{
+    Profiler::reset();
+    {
+        PROFILE_TIMER(timer, "testScope");
+        uint64_t start = Profiler::now();
+        while(Profiler::now() - start < 1000000)
+            ;
+        EXPECT_GE(timer.elapsedNs(), 1000000ULL);
+        timer.stop();
+    }
+    {
+        PROFILE_SCOPE("testScope");
+    }
+
+    std::vector<Profiler::TimerReport> timers;
+    std::vector<Profiler::CounterReport> counters;
+    Profiler::snapshot(timers, counters);
+    const Profiler::TimerReport *timer = findTimer(timers, "testScope");
+    ASSERT_TRUE(timer != NULL);
+    // Stopped once, not again at the end of the scope
+    EXPECT_EQ(2ULL, timer->count);
+    EXPECT_GE(timer->maxNs, 1000000ULL);
+}
+
+TEST_F(ProfilerTest, Reports)
+{
+    Profiler::reset();
+    Profiler::record(Profiler::timerId("testReport"), 2000);
+    Profiler::count(Profiler::counterId("testReportCounter"), 7);
+
+    std::ostringstream json;
+    Profiler::writeJson(json);
+    EXPECT_NE(std::string::npos, json.str().find(
+                "{\"name\": \"testReport\", \"count\": 1, \"total_ns\": 2000, "
+                "\"min_ns\": 2000, \"max_ns\": 2000"));
+    EXPECT_NE(std::string::npos, json.str().find(
+                "{\"name\": \"testReportCounter\", \"value\": 7}"));
+
+    std::ostringstream csv;
+    Profiler::writeCsv(csv);
+    EXPECT_NE(std::string::npos, csv.str().find(
+                "\"timer\",\"testReport\",1,2000,2000,2000,"));
+    EXPECT_NE(std::string::npos, csv.str().find(
+                "\"counter\",\"testReportCounter\",7,,,,,,"));
+}
+
+TEST_F(ProfilerTest, HardwareCounters)
+{
+    Profiler::reset();
+    std::string error;
+    bool enabled = Profiler::enableHardwareCounters(error);
+    {
+        PROFILE_TIMER(timer, "testHardware");
+        double sum = 0.0;
+        for(int i = 0; i < 100000; i ++)
+            sum += i * 0.5;
+        timer.addItems(100);
+        EXPECT_GT(sum, 0.0);
+    }
+
+    std::vector<Profiler::HardwareReport> hardware;
+    Profiler::hardwareSnapshot(hardware);
+    std::ostringstream json;
+    Profiler::writeJson(json);
+    if(!enabled)
+    {
+        // Only the times are recorded, the report says nothing else
+        EXPECT_FALSE(error.empty());
+        EXPECT_FALSE(Profiler::hardwareCountersEnabled());
+        EXPECT_TRUE(hardware.empty());
+        EXPECT_EQ(std::string::npos, json.str().find("\"hardware\""));
+        EXPECT_GT(Profiler::totalNs("testHardware"), 0ULL);
+        return;
+    }
+
+    // The merged report of the timer comes first, then the thread's
+    ASSERT_EQ(2, (int)hardware.size());
+    EXPECT_EQ(-1, hardware[0].thread);
+    EXPECT_EQ(std::string("testHardware"), hardware[0].name);
+    EXPECT_EQ(1ULL, hardware[0].scopes);
+    EXPECT_EQ(100ULL, hardware[0].items);
+    EXPECT_GT(hardware[0].events[PerfCounters::CYCLES], 0ULL);
+    EXPECT_EQ(hardware[0].events[PerfCounters::CYCLES],
+            hardware[1].events[PerfCounters::CYCLES]);
+    EXPECT_NE(std::string::npos, json.str().find(
+                "{\"name\": \"testHardware\", \"thread\": -1, \"scopes\": 1, \"items\": 100, "
+                "\"cycles\": "));
+}
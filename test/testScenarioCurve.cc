@@ -0,0 +1,100 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "Date.h"
+#include "Instrument.h"
+#include "YieldCurve.h"
+#include "ScenarioCurve.h"
+#include "testCurveData.h"
+
+class ScenarioCurveTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing ScenarioCurve Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing ScenarioCurve Class --------"
+                << std::endl << std::endl;
+        }
+};
+
+TEST_F(ScenarioCurveTest, LockStepBootstrapMatchesBindData)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    // Base, parallel shifts and a twist
+    const int numScenarios = 5;
+    ScenarioQuotes quotes(values, numScenarios);
+    quotes.parallelShift(1, 0.01);
+    quotes.parallelShift(2, -0.5);
+    std::vector<double> twist;
+    for(int j = 0; j < quotes.numQuotes(); j ++)
+        twist.push_back(-0.2 + 0.4 * j / quotes.numQuotes());
+    quotes.shift(3, twist);
+    quotes.parallelShift(4, 1.0);
+
+    YieldCurveDefinition::CURVETYPE types[] = {
+        YieldCurveDefinition::ZEROCOUPONRATE,
+        YieldCurveDefinition::DISCOUNTFACTOR,
+        YieldCurveDefinition::CONTINUOUSRATE,
+        YieldCurveDefinition::LOGDISCOUNTFACTOR};
+
+    Date today = WorkDate(Date::today());
+    std::vector<Date> queryDates;
+    for(int days = 0; days < 11000; days += 97)
+        queryDates.push_back(today + Duration(days, Duration::DAY));
+
+    for(int t = 0; t < 4; t ++)
+    {
+        ScenarioCurveSet curves(ycDef, quotes, types[t], today);
+        ASSERT_EQ(numScenarios, curves.numScenarios());
+
+        std::vector<double> dfs;
+        std::vector<char> found;
+        curves.getDfs(queryDates, dfs, found);
+
+        for(int s = 0; s < numScenarios; s ++)
+        {
+            InstrumentValues scenario(values);
+            for(int j = 0; j < quotes.numQuotes(); j ++)
+                scenario.values[j].second = quotes.at(j, s);
+            YieldCurveInstance *yci = ycDef.bindData(&scenario, types[t], today);
+
+            for(int i = 0; i < (int)curves.pillarDates().size(); i ++)
+            {
+                Date date = curves.pillarDates()[i];
+                EXPECT_NEAR(yci->getDf(date), curves.pillarDfs(i)[s], 1e-12) <<
+                    "Curve type " << t << "; scenario " << s << "; pillar " << date.toString();
+            }
+
+            std::vector<double> values, sweepDfs;
+            std::vector<char> sweepFound;
+            std::vector<Date> workDates;
+            for(int i = 0; i < (int)queryDates.size(); i ++)
+                workDates.push_back(WorkDate(queryDates[i]));
+            yci->sweepSorted(workDates, values, sweepDfs, sweepFound);
+            for(int i = 0; i < (int)queryDates.size(); i ++)
+            {
+                ASSERT_EQ(sweepFound[i], found[i]);
+                if(found[i])
+                {
+                    EXPECT_NEAR(sweepDfs[i], dfs[i * numScenarios + s], 1e-12) <<
+                        "Curve type " << t << "; scenario " << s << "; date " <<
+                        queryDates[i].toString();
+                }
+            }
+
+            delete yci;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "Date.h"
+#include "Calendar.h"
+#include "Schedule.h"
+
+using boost::gregorian::date;
+
+class ScheduleTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing Schedule Class --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing Schedule Class --------"
+                << std::endl << std::endl;
+        }
+};
+
+TEST_F(ScheduleTest, TenorDatesMatchWorkDates)
+{
+    Schedule::clear();
+    Date asOf(date(2013, 1, 31));
+
+    std::vector<Duration> tenors;
+    tenors.push_back(Duration(1, Duration::DAY));
+    tenors.push_back(Duration(1, Duration::WEEK));
+    tenors.push_back(Duration(1, Duration::MONTH));
+    tenors.push_back(Duration(1, Duration::QUARTER));
+    tenors.push_back(Duration(30, Duration::YEAR));
+
+    Schedule::Dates dates = Schedule::tenorDates(asOf, tenors);
+    ASSERT_EQ(tenors.size(), dates.size());
+    for(int i = 0; i < (int)tenors.size(); i ++)
+        EXPECT_EQ(WorkDate(asOf + tenors[i]), dates[i]);
+
+    // The same schedule is returned from the cache
+    EXPECT_EQ(&dates.get(), &Schedule::tenorDates(asOf, tenors).get());
+    EXPECT_EQ(1u, Schedule::size());
+
+    // 12M and 1Y add the same months
+    std::vector<Duration> months(1, Duration(12, Duration::MONTH));
+    std::vector<Duration> years(1, Duration(1, Duration::YEAR));
+    EXPECT_EQ(&Schedule::tenorDates(asOf, months).get(),
+            &Schedule::tenorDates(asOf, years).get());
+    EXPECT_EQ(2u, Schedule::size());
+}
+
+TEST_F(ScheduleTest, PeriodicDatesAndCalendars)
+{
+    Schedule::clear();
+    Date asOf(date(2013, 6, 14));
+    Duration quarter(Duration(1, Duration::YEAR) / 4.0);
+
+    Schedule::Dates coupons = Schedule::periodicDates(asOf, quarter, 8);
+    ASSERT_EQ(8u, coupons.size());
+    for(int i = 1; i <= 8; i ++)
+        EXPECT_EQ(WorkDate(asOf + quarter * i), coupons[i - 1]);
+
+    // Another as-of date or calendar is another schedule
+    std::vector<Date> holidays(1, Date(date(2013, 9, 16)));
+    Calendar calendar("TEST", holidays);
+    Schedule::Dates adjusted =
+        Schedule::periodicDates(asOf, quarter, 8, calendar);
+    EXPECT_EQ(Date(date(2013, 9, 16)), coupons[0]);
+    EXPECT_EQ(Date(date(2013, 9, 17)), adjusted[0]);
+    EXPECT_EQ(coupons[1], adjusted[1]);
+
+    Date nextDay(date(2013, 6, 17));
+    EXPECT_EQ(WorkDate(nextDay + quarter),
+            Schedule::tenorDate(nextDay, quarter));
+    EXPECT_EQ(3u, Schedule::size());
+}
+
+TEST_F(ScheduleTest, PeriodicDatesScaleExactTenor)
+{
+    Schedule::clear();
+    Date asOf(date(2012, 6, 1));
+    Duration month(Duration(1, Duration::YEAR) / 12.0);
+
+    // 7, 14, 25, 28 and 31 months are neither repeated nor skipped
+    Schedule::Dates coupons = Schedule::periodicDates(asOf, month, 31);
+    ASSERT_EQ(31u, coupons.size());
+    for(int i = 1; i <= 31; i ++)
+    {
+        EXPECT_EQ(WorkDate(asOf + Tenor(i, 0)), coupons[i - 1]);
+        if(i > 1)
+        {
+            EXPECT_LT(coupons[i - 2], coupons[i - 1]);
+        }
+    }
+}
+
+TEST_F(ScheduleTest, BoundedCache)
+{
+    Schedule::clear();
+    Date asOf(date(2013, 1, 31));
+    std::vector<Duration> tenors(1, Duration(3, Duration::MONTH));
+    Schedule::Dates first = Schedule::tenorDates(asOf, tenors);
+
+    // Many more as-of dates than the cache holds, e.g. a history
+    int numDates = (int)Schedule::capacity() * 4;
+    for(int i = 1; i <= numDates; i ++)
+        Schedule::tenorDates(asOf + Duration(i, Duration::DAY), tenors);
+    EXPECT_LE(Schedule::size(), Schedule::capacity());
+
+    // The first schedule was dropped from the cache, but its
+    // dates live on
+    EXPECT_NE(&first.get(), &Schedule::tenorDates(asOf, tenors).get());
+    EXPECT_EQ(WorkDate(asOf + tenors[0]), first[0]);
+
+    Schedule::clear();
+    EXPECT_EQ(0u, Schedule::size());
+    EXPECT_EQ(WorkDate(asOf + tenors[0]), first[0]);
+}
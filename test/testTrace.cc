@@ -0,0 +1,112 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "Trace.h"
+#include "Concurrency.h"
+
+class TraceTest : public testing::Test
+{
+    protected:
+        static void SetUpTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Start Testing Trace --------"
+                << std::endl;
+        }
+
+        static void TearDownTestCase()
+        {
+            std::cout << "\t\t\t\t\t-------- Finish Testing Trace --------"
+                << std::endl << std::endl;
+        }
+};
+
+namespace
+{
+    // Record the given number of numbered events on its own thread
+    class TracingTask : public Concurrency::Runnable
+    {
+        public:
+            TracingTask(const char *name, int numEvents):
+                _name(name), _numEvents(numEvents){};
+
+            virtual void run()
+            {
+                for(int i = 0; i < _numEvents; i ++)
+                    TRACE_SCOPE_ARG(_name, "index", i);
+            }
+
+        private:
+            const char *_name;
+            int _numEvents;
+    };
+
+    int countOccurrences(const std::string& text, const std::string& pattern)
+    {
+        int count = 0;
+        for(size_t pos = text.find(pattern); pos != std::string::npos;
+                pos = text.find(pattern, pos + 1))
+            count ++;
+        return count;
+    }
+}
+
+TEST_F(TraceTest, Disabled)
+{
+    ASSERT_FALSE(Trace::enabled());
+    {
+        TRACE_SCOPE("testDisabled");
+    }
+
+    std::ostringstream json;
+    Trace::writeJson(json);
+    EXPECT_EQ(0, json.str().find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["));
+    EXPECT_EQ(std::string::npos, json.str().find("testDisabled"));
+}
+
+TEST_F(TraceTest, CompleteEventsPerThread)
+{
+    Trace::enable();
+    {
+        TRACE_SCOPE("testMain");
+    }
+    TracingTask task("testWorker", 3);
+    {
+        Concurrency::Thread thread(task);
+    }
+
+    std::ostringstream json;
+    Trace::writeJson(json);
+    std::string text = json.str();
+    EXPECT_EQ(1, countOccurrences(text, "{\"name\": \"testMain\", \"ph\": \"X\""));
+    EXPECT_EQ(3, countOccurrences(text, "{\"name\": \"testWorker\", \"ph\": \"X\""));
+    EXPECT_NE(std::string::npos, text.find("\"args\": {\"index\": 2}}"));
+    EXPECT_EQ("\n]}\n", text.substr(text.size() - 4));
+
+    // The two threads are told apart
+    size_t mainPos = text.find("\"testMain\"");
+    size_t workerPos = text.find("\"testWorker\"");
+    std::string mainTid = text.substr(text.find("\"tid\"", mainPos), 12);
+    std::string workerTid = text.substr(text.find("\"tid\"", workerPos), 12);
+    EXPECT_NE(mainTid, workerTid);
+}
+
+TEST_F(TraceTest, RingKeepsTheLatestEvents)
+{
+    // Only the rings of the threads started from now on are smaller
+    Trace::enable(4);
+    TracingTask task("testOverflow", 10);
+    {
+        Concurrency::Thread thread(task);
+    }
+    Trace::enable();
+
+    std::ostringstream json;
+    Trace::writeJson(json);
+    std::string text = json.str();
+    EXPECT_EQ(4, countOccurrences(text, "{\"name\": \"testOverflow\", \"ph\": \"X\""));
+    EXPECT_EQ(std::string::npos, text.find("\"args\": {\"index\": 5}}"));
+    EXPECT_NE(std::string::npos, text.find("\"args\": {\"index\": 6}}"));
+    EXPECT_NE(std::string::npos, text.find("\"args\": {\"index\": 9}}"));
+}
@@ -136,3 +136,33 @@ TEST_F(RNGTest, Test_BoxMullerM2RNG_NONANTITHETIC_Fitting_StardardNormalDistribu
 
 }
 
+
+// A seeded generator and its copies advance their own sequence,
+// which the same seed repeats and rand() does not move
+TEST_F(RNGTest, Test_BoxMullerM2RNG_SeededSequence)
+{
+    unsigned int seed1 = 20130122;
+    unsigned int seed2 = 20130122;
+    unsigned int otherSeed = 20130123;
+
+    srand(1);
+    int before = rand();
+    srand(1);
+
+    vector<double> first;
+    for(int i = 0; i < 100; i ++)
+        first.push_back(boxMullerM2RNG(boxMullerM2RNG::NONANTITHETIC, &seed1).get());
+
+    boxMullerM2RNG rng(boxMullerM2RNG::NONANTITHETIC, &seed2);
+    boxMullerM2RNG other(boxMullerM2RNG::NONANTITHETIC, &otherSeed);
+    int differences = 0;
+    for(int i = 0; i < 100; i ++)
+    {
+        EXPECT_EQ(first[i], rng.get()) << "at " << i;
+        if(other.get() != first[i])
+            differences ++;
+    }
+    EXPECT_EQ(seed1, seed2);
+    EXPECT_GT(differences, 90);
+    EXPECT_EQ(before, rand());
+}
@@ -1,10 +1,13 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cmath>
 
 #include "gtest/gtest.h"
 #include "Instrument.h"
 #include "YieldCurve.h"
+#include "Concurrency.h"
+#include "testCurveData.h"
 
 class YieldCurveDefinitionTest : public testing::Test
 {
@@ -38,8 +41,32 @@ class YieldCurveInstanceTest : public testing::Test
         }
 };
 
+// Query a curve shared with other threads
+class CurveReader : public Concurrency::Runnable
+{
+    public:
+        CurveReader(const YieldCurveInstance& curve,
+                const std::vector<Date>& dates, std::vector<double>& dfs):
+            _curve(curve), _dates(dates), _dfs(dfs){};
+
+        virtual void run()
+        {
+            _dfs.resize(_dates.size());
+            for(int i = 0; i < (int)_dates.size(); i ++)
+            {
+                Date date = _dates[i];
+                _dfs[i] = _curve.getDf(date);
+            }
+        }
+
+    private:
+        const YieldCurveInstance& _curve;
+        std::vector<Date> _dates;
+        std::vector<double>& _dfs;
+};
+
 void testEqualYieldCurveDefinition(InstrumentDefinition::TYPE stype, Duration smaturity,
-        int sid, InstrumentDefinition& tInstrDef)
+        int sid, const InstrumentDefinition& tInstrDef)
 {
     EXPECT_EQ(stype, tInstrDef.type())
         << "Standard: " <<
@@ -70,7 +97,7 @@ TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction1)
 {
     std::ifstream fin("testYieldCurveData/curveSpec1.csv");
     std::string line;
-    std::vector<InstrumentDefinition *> instrDefs;
+    std::vector<InstrumentDefinition> instrDefs;
 
     getline(fin, line);
     
@@ -80,89 +107,75 @@ TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction1)
         if(!fin.good())
             break;
 
-        InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
-        instrDefs.push_back(instrDef);
+        instrDefs.push_back(InstrumentDefinition::parseString(line));
     }
 
     YieldCurveDefinition ycDef(instrDefs, 4.0);
-    std::vector<InstrumentDefinition *> generatedInstrDefs = ycDef.getAllDefinitions();
-    std::vector<InstrumentDefinition *>& gdefs = generatedInstrDefs;
+    const std::vector<InstrumentDefinition>& gdefs = ycDef.getAllDefinitions();
 
     {
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(1, Duration::DAY), 1, *gdefs[0]);
+                Duration(1, Duration::DAY), 1, gdefs[0]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(2, Duration::DAY), 2, *gdefs[1]);
+                Duration(2, Duration::DAY), 2, gdefs[1]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(1, Duration::WEEK), 3, *gdefs[2]);
+                Duration(1, Duration::WEEK), 3, gdefs[2]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(2, Duration::WEEK), 4, *gdefs[3]);
+                Duration(2, Duration::WEEK), 4, gdefs[3]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(1, Duration::MONTH), 5, *gdefs[4]);
+                Duration(1, Duration::MONTH), 5, gdefs[4]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(2, Duration::MONTH), 6, *gdefs[5]);
+                Duration(2, Duration::MONTH), 6, gdefs[5]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(3, Duration::MONTH), 7, *gdefs[6]);
+                Duration(3, Duration::MONTH), 7, gdefs[6]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FRA,
-                Duration(4, Duration::MONTH), 8, *gdefs[7]);
+                Duration(4, Duration::MONTH), 8, gdefs[7]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FRA,
-                Duration(5, Duration::MONTH), 9, *gdefs[8]);
+                Duration(5, Duration::MONTH), 9, gdefs[8]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FRA,
-                Duration(6, Duration::MONTH), 10, *gdefs[9]);
+                Duration(6, Duration::MONTH), 10, gdefs[9]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FRA,
-                Duration(9, Duration::MONTH), 11, *gdefs[10]);
+                Duration(9, Duration::MONTH), 11, gdefs[10]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::SWAP,
-                Duration(1, Duration::YEAR), 12, *gdefs[11]);
+                Duration(1, Duration::YEAR), 12, gdefs[11]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1.25, Duration::YEAR), -1, *gdefs[12]);
+                Duration(1.25, Duration::YEAR), -1, gdefs[12]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1.5, Duration::YEAR), -1, *gdefs[13]);
+                Duration(1.5, Duration::YEAR), -1, gdefs[13]);
         
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1.75, Duration::YEAR), -1, *gdefs[14]);
+                Duration(1.75, Duration::YEAR), -1, gdefs[14]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::SWAP,
-                Duration(2, Duration::YEAR), 13, *gdefs[15]);
+                Duration(2, Duration::YEAR), 13, gdefs[15]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2.25, Duration::YEAR), -1, *gdefs[16]);
+                Duration(2.25, Duration::YEAR), -1, gdefs[16]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2.5, Duration::YEAR), -1, *gdefs[17]);
+                Duration(2.5, Duration::YEAR), -1, gdefs[17]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2.75, Duration::YEAR), -1, *gdefs[18]);
+                Duration(2.75, Duration::YEAR), -1, gdefs[18]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::SWAP,
-                Duration(3, Duration::YEAR), 14, *gdefs[19]);
+                Duration(3, Duration::YEAR), 14, gdefs[19]);
     }
 
-    while(!gdefs.empty())
-    {
-        InstrumentDefinition *instrDef = gdefs.back();
-        gdefs.pop_back();
-        delete instrDef;
-    }
 
-    while(!instrDefs.empty())
-    {
-        InstrumentDefinition *instrDef = instrDefs.back();
-        instrDefs.pop_back();
-        delete instrDef;
-    }
 
     fin.close();
 }
@@ -171,7 +184,7 @@ TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction2)
 {
     std::ifstream fin("testYieldCurveData/curveSpec2.csv");
     std::string line;
-    std::vector<InstrumentDefinition *> instrDefs;
+    std::vector<InstrumentDefinition> instrDefs;
 
     getline(fin, line);
     
@@ -181,77 +194,92 @@ TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction2)
         if(!fin.good())
             break;
 
-        InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
-        instrDefs.push_back(instrDef);
+        instrDefs.push_back(InstrumentDefinition::parseString(line));
     }
 
     YieldCurveDefinition ycDef(instrDefs, 4.0);
-    std::vector<InstrumentDefinition *> generatedInstrDefs = ycDef.getAllDefinitions();
-    std::vector<InstrumentDefinition *>& gdefs = generatedInstrDefs;
+    const std::vector<InstrumentDefinition>& gdefs = ycDef.getAllDefinitions();
 
     {
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(1, Duration::DAY), 2, *gdefs[0]);
+                Duration(1, Duration::DAY), 2, gdefs[0]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::CASH,
-                Duration(3, Duration::MONTH), 3, *gdefs[1]);
+                Duration(3, Duration::MONTH), 3, gdefs[1]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(6, Duration::MONTH), -1, *gdefs[2]);
+                Duration(6, Duration::MONTH), -1, gdefs[2]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(9, Duration::MONTH), -1, *gdefs[3]);
+                Duration(9, Duration::MONTH), -1, gdefs[3]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1, Duration::YEAR), -1, *gdefs[4]);
+                Duration(1, Duration::YEAR), -1, gdefs[4]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1.25, Duration::YEAR), -1, *gdefs[5]);
+                Duration(1.25, Duration::YEAR), -1, gdefs[5]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1.5, Duration::YEAR), -1, *gdefs[6]);
+                Duration(1.5, Duration::YEAR), -1, gdefs[6]);
         
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(1.75, Duration::YEAR), -1, *gdefs[7]);
+                Duration(1.75, Duration::YEAR), -1, gdefs[7]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2, Duration::YEAR), -1, *gdefs[8]);
+                Duration(2, Duration::YEAR), -1, gdefs[8]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2.25, Duration::YEAR), -1, *gdefs[9]);
+                Duration(2.25, Duration::YEAR), -1, gdefs[9]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2.5, Duration::YEAR), -1, *gdefs[10]);
+                Duration(2.5, Duration::YEAR), -1, gdefs[10]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::FAKE,
-                Duration(2.75, Duration::YEAR), -1, *gdefs[11]);
+                Duration(2.75, Duration::YEAR), -1, gdefs[11]);
 
         testEqualYieldCurveDefinition(InstrumentDefinition::SWAP,
-                Duration(3, Duration::YEAR), 1, *gdefs[12]);
+                Duration(3, Duration::YEAR), 1, gdefs[12]);
     }
 
-    while(!gdefs.empty())
-    {
-        InstrumentDefinition *instrDef = gdefs.back();
-        gdefs.pop_back();
-        delete instrDef;
-    }
 
-    while(!instrDefs.empty())
-    {
-        InstrumentDefinition *instrDef = instrDefs.back();
-        instrDefs.pop_back();
-        delete instrDef;
-    }
 
     fin.close();
 }
 
+TEST_F(YieldCurveDefinitionTest, MonthlyAndThirdlyCoupons)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    readCurveDefinitions("testYieldCurveData/curveSpec1.csv", instrDefs);
+
+    // 1Y / 12 and 1Y / 3 scaled up hit every coupon month once,
+    // 7M, 14M, 25M, 28M and 31M included
+    double freqs[] = {12.0, 3.0};
+    for(int f = 0; f < 2; f ++)
+    {
+        YieldCurveDefinition ycDef(instrDefs, freqs[f]);
+        const std::vector<InstrumentDefinition>& gdefs = ycDef.getAllDefinitions();
+
+        int step = (int)(12 / freqs[f]);
+        for(int months = step; months <= 36; months += step)
+        {
+            int found = 0;
+            for(int i = 0; i < (int)gdefs.size(); i ++)
+                if(gdefs[i].maturity().tenor() == Tenor(months, 0))
+                    found ++;
+            EXPECT_EQ(1, found) << months << "M at frequency " << freqs[f];
+        }
+
+        for(int i = 1; i < (int)gdefs.size(); i ++)
+            EXPECT_LT(gdefs[i - 1].maturity().tenor(), gdefs[i].maturity().tenor())
+                << "frequency " << freqs[f] << " definition " << i;
+    }
+}
+
 TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction3)
 {
     std::ifstream fin("testYieldCurveData/curveSpec3.csv");
     std::string line;
-    std::vector<InstrumentDefinition *> instrDefs;
+    std::vector<InstrumentDefinition> instrDefs;
 
     getline(fin, line);
     
@@ -261,18 +289,11 @@ TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction3)
         if(!fin.good())
             break;
 
-        InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
-        instrDefs.push_back(instrDef);
+        instrDefs.push_back(InstrumentDefinition::parseString(line));
     }
 
     EXPECT_ANY_THROW(YieldCurveDefinition ycDef(instrDefs, 4.0));
 
-    while(!instrDefs.empty())
-    {
-        InstrumentDefinition *instrDef = instrDefs.back();
-        instrDefs.pop_back();
-        delete instrDef;
-    }
 
     fin.close();
 }
@@ -280,44 +301,13 @@ TEST_F(YieldCurveDefinitionTest, YieldCurveDefinitionConstruction3)
 TEST_F(YieldCurveInstanceTest, YieldCurveInstanceConstruction1)
 {
     // Build Construction
-    std::ifstream deffin("testYieldCurveData/curveSpec1.csv");
-    std::string line;
-    std::vector<InstrumentDefinition *> instrDefs;
-
-    getline(deffin, line);
-    
-    while(deffin.good())
-    {
-        getline(deffin, line);
-        if(!deffin.good())
-            break;
-
-        InstrumentDefinition *instrDef = InstrumentDefinition::parseString(line);
-        instrDefs.push_back(instrDef);
-    }
-
-    YieldCurveDefinition ycDef(instrDefs, 4.0);
-    deffin.close();
-
-    // Read Data
-    std::ifstream datafin("testYieldCurveData/curveDataInput1.csv");
+    std::vector<InstrumentDefinition> instrDefs;
     InstrumentValues values;
-    int id;
-    double rate;
-
-    getline(datafin, line);
-
-    while(datafin.good())
-    {
-        char comma;
-        datafin >> id >> comma >> rate;
-        values.values.push_back(std::pair<int, double>(id, rate));
-    }
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
 
     // Bind data to Yield Curve Defition, and do the test
     YieldCurveInstance *yci = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE);
-    std::vector<InstrumentDefinition *> generatedInstrDefs = ycDef.getAllDefinitions();
-    std::vector<InstrumentDefinition *>& gdefs = generatedInstrDefs;
 
     double expectedRate;
     double actualRate;
@@ -325,13 +315,13 @@ TEST_F(YieldCurveInstanceTest, YieldCurveInstanceConstruction1)
     for(int i = 0; i < (int)values.values.size(); i ++)
     {
         std::pair<int, double>& valuepair = values.values[i];
-        InstrumentDefinition *ptrDef = ycDef.getDefinitionByID(valuepair.first);
-        Date maturityDate = WorkDate(today + ptrDef->maturity());
+        const InstrumentDefinition& def = ycDef.getDefinitionByID(valuepair.first);
+        Date maturityDate = WorkDate(today + def.maturity());
 
         expectedRate = valuepair.second;
         try
         {
-            actualRate = getCompoundRate(*yci, maturityDate, ptrDef->type(), 4.0);
+            actualRate = getCompoundRate(*yci, maturityDate, def.type(), 4.0);
         }
         catch(YieldCurveException& e)
         {
@@ -339,19 +329,513 @@ TEST_F(YieldCurveInstanceTest, YieldCurveInstanceConstruction1)
         }
 
         EXPECT_NEAR(expectedRate, actualRate, 1e-5) << "Maturity: " << 
-            ptrDef->maturity().toString() << "; Maturity Date: " <<
+            def.maturity().toString() << "; Maturity Date: " <<
             maturityDate.toString() << "; Type: " << 
-            InstrumentDefinition::typeToString(ptrDef->type()) << std::endl;
+            InstrumentDefinition::typeToString(def.type()) << std::endl;
     }
 
 
     // Dispose
     delete yci;
-    while(!instrDefs.empty())
+
+}
+
+TEST_F(YieldCurveInstanceTest, YieldCurveStoragePolicies)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    YieldCurveDefinition::CURVETYPE types[] = {
+        YieldCurveDefinition::ZEROCOUPONRATE,
+        YieldCurveDefinition::DISCOUNTFACTOR,
+        YieldCurveDefinition::CONTINUOUSRATE,
+        YieldCurveDefinition::LOGDISCOUNTFACTOR};
+
+    Date today = WorkDate(Date::today());
+    for(int t = 0; t < 4; t ++)
     {
-        InstrumentDefinition *instrDef = instrDefs.back();
-        instrDefs.pop_back();
-        delete instrDef;
+        YieldCurveInstance *yci = ycDef.bindData(&values, types[t]);
+
+        // Every representation reprices its inputs
+        std::vector<Date> maturityDates;
+        for(int i = 0; i < (int)values.values.size(); i ++)
+        {
+            const InstrumentDefinition& def = ycDef.getDefinitionByID(values.values[i].first);
+            Date maturityDate = WorkDate(today + def.maturity());
+            maturityDates.push_back(maturityDate);
+
+            double actualRate = getCompoundRate(*yci, maturityDate, def.type(), 4.0);
+            EXPECT_NEAR(values.values[i].second, actualRate, 1e-5) << "Curve type " <<
+                t << "; Maturity: " << def.maturity().toString();
+        }
+
+        // The sweep resolves the conversion the same way
+        std::vector<double> sweepValues, sweepDfs;
+        std::vector<char> found;
+        yci->sweepSorted(maturityDates, sweepValues, sweepDfs, found);
+        for(int i = 0; i < (int)maturityDates.size(); i ++)
+        {
+            ASSERT_TRUE(found[i] != 0);
+            EXPECT_DOUBLE_EQ(yci->getDf(maturityDates[i]), sweepDfs[i]);
+            EXPECT_DOUBLE_EQ((*yci)[maturityDates[i]], sweepValues[i]);
+        }
+
+        delete yci;
     }
+}
 
+TEST_F(YieldCurveInstanceTest, YieldCurveJacobian)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    YieldCurveDefinition::CURVETYPE types[] = {
+        YieldCurveDefinition::ZEROCOUPONRATE,
+        YieldCurveDefinition::DISCOUNTFACTOR,
+        YieldCurveDefinition::CONTINUOUSRATE,
+        YieldCurveDefinition::LOGDISCOUNTFACTOR};
+
+    Date today = WorkDate(Date::today());
+    Date queryDate = WorkDate(today + Duration(200, Duration::DAY));
+    int numQuotes = (int)values.values.size();
+    const double bump = 1e-4;
+
+    for(int t = 0; t < 4; t ++)
+    {
+        CurveJacobian jacobian;
+        YieldCurveInstance *yci = ycDef.bindData(&values, types[t], &jacobian);
+        ASSERT_EQ(numQuotes, (int)jacobian.quoteIds.size());
+        int numPillars = (int)jacobian.pillarDates.size();
+        ASSERT_EQ(numPillars * numQuotes, (int)jacobian.dDfdQuote.size());
+
+        std::vector<double> rho;
+        jacobian.bucketedRho(*yci, queryDate, rho);
+
+        // Central differences of the bumped bootstraps
+        for(int j = 0; j < numQuotes; j ++)
+        {
+            InstrumentValues up(values), down(values);
+            up.values[j].second += bump;
+            down.values[j].second -= bump;
+            YieldCurveInstance *yciUp = ycDef.bindData(&up, types[t]);
+            YieldCurveInstance *yciDown = ycDef.bindData(&down, types[t]);
+
+            for(int i = 0; i < numPillars; i ++)
+            {
+                Date date = jacobian.pillarDates[i];
+                double expected = (yciUp->getDf(date) - yciDown->getDf(date)) / (2 * bump);
+                EXPECT_NEAR(expected, jacobian.derivative(i, j), 1e-6) << "Curve type " <<
+                    t << "; pillar " << date.toString() << "; quote " << j;
+            }
+
+            double expected = (yciUp->getDf(queryDate) - yciDown->getDf(queryDate)) / (2 * bump);
+            EXPECT_NEAR(expected, rho[j], 1e-6) << "Curve type " << t << "; quote " << j;
+
+            delete yciUp;
+            delete yciDown;
+        }
+
+        delete yci;
+    }
+}
+
+TEST_F(YieldCurveInstanceTest, YieldCurveHistoricalAsOf)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    // A Saturday, the curve starts on the following Monday
+    Date asOf("2015-03-14");
+    Date startDate("2015-03-16");
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, asOf);
+    EXPECT_EQ(startDate, yci->startDate());
+
+    for(int i = 0; i < (int)values.values.size(); i ++)
+    {
+        const InstrumentDefinition& def = ycDef.getDefinitionByID(values.values[i].first);
+        Date maturityDate = WorkDate(startDate + def.maturity());
+
+        double actualRate = getCompoundRate(*yci, maturityDate, def.type(), 4.0);
+        EXPECT_NEAR(values.values[i].second, actualRate, 1e-5) << "Maturity: " <<
+            def.maturity().toString();
+    }
+
+    // A batch of historical dates built in parallel matches the
+    // curves built one by one
+    std::vector<InstrumentValues> history;
+    std::vector<Date> asOfs;
+    for(int d = 0; d < 6; d ++)
+    {
+        InstrumentValues dayValues(values);
+        for(int i = 0; i < (int)dayValues.values.size(); i ++)
+            dayValues.values[i].second += 0.01 * d;
+        history.push_back(dayValues);
+        asOfs.push_back(WorkDate(asOf + Duration(7 * d, Duration::DAY)));
+    }
+
+    std::vector<YieldCurveInstance *> curves;
+    ycDef.bindHistory(history, asOfs, YieldCurveDefinition::ZEROCOUPONRATE, 3, curves);
+    ASSERT_EQ(history.size(), curves.size());
+    for(int d = 0; d < (int)curves.size(); d ++)
+    {
+        YieldCurveInstance *expected = ycDef.bindData(&history[d],
+                YieldCurveDefinition::ZEROCOUPONRATE, asOfs[d]);
+        EXPECT_EQ(expected->startDate(), curves[d]->startDate());
+
+        Date date = WorkDate(asOfs[d] + Duration(3, Duration::YEAR));
+        EXPECT_DOUBLE_EQ(expected->getDf(date), curves[d]->getDf(date)) << "Day " << d;
+
+        delete expected;
+        delete curves[d];
+    }
+
+    // Mismatched inputs are refused
+    asOfs.pop_back();
+    EXPECT_THROW(ycDef.bindHistory(history, asOfs,
+                YieldCurveDefinition::ZEROCOUPONRATE, 2, curves), YieldCurveException);
+
+    delete yci;
+}
+
+TEST_F(YieldCurveInstanceTest, YieldCurveLazyBootstrap)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    Date today = WorkDate(Date::today());
+
+    // Binding with a jacobian solves the whole curve at once
+    CurveJacobian jacobian;
+    YieldCurveInstance *eager = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today, &jacobian);
+    int numPoints = eager->numSolvedPoints();
+    ASSERT_EQ((int)jacobian.pillarDates.size(), numPoints);
+
+    // A short date only solves the pillars up to it
+    YieldCurveInstance *lazy = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+    EXPECT_EQ(0, lazy->numSolvedPoints());
+
+    Date shortDate = WorkDate(today + Duration(6, Duration::MONTH));
+    EXPECT_DOUBLE_EQ(eager->getDf(shortDate), lazy->getDf(shortDate));
+    EXPECT_GT(lazy->numSolvedPoints(), 0);
+    EXPECT_LT(lazy->numSolvedPoints(), numPoints);
+
+    // Later dates extend it transparently
+    Date lastDate = jacobian.pillarDates[numPoints - 1];
+    EXPECT_DOUBLE_EQ(eager->getDf(lastDate), lazy->getDf(lastDate));
+    EXPECT_EQ(numPoints, lazy->numSolvedPoints());
+    delete lazy;
+
+    // Readers racing to extend the same curve, in different
+    // orders, see the curve of the eager bootstrap
+    std::vector<Date> dates;
+    for(Date date = today + Duration(1, Duration::DAY); date < lastDate;
+            date = date + Duration(5, Duration::DAY))
+        dates.push_back(date);
+    std::vector<Date> reversed(dates.rbegin(), dates.rend());
+
+    lazy = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE, today);
+    const int numReaders = 4;
+    std::vector<std::vector<double> > dfs(numReaders);
+    std::vector<CurveReader *> readers;
+    std::vector<Concurrency::Thread *> threads;
+    for(int k = 0; k < numReaders; k ++)
+    {
+        readers.push_back(new CurveReader(*lazy, k % 2 == 0 ? dates : reversed,
+                    dfs[k]));
+        threads.push_back(new Concurrency::Thread(*readers[k]));
+    }
+
+    for(int k = 0; k < numReaders; k ++)
+    {
+        threads[k]->join();
+        delete threads[k];
+        delete readers[k];
+    }
+
+    int numDates = (int)dates.size();
+    for(int k = 0; k < numReaders; k ++)
+    {
+        ASSERT_EQ(numDates, (int)dfs[k].size());
+        for(int i = 0; i < numDates; i ++)
+        {
+            Date date = k % 2 == 0 ? dates[i] : reversed[i];
+            EXPECT_DOUBLE_EQ(eager->getDf(date), dfs[k][i]) << "Reader " << k <<
+                "; date " << date.toString();
+        }
+    }
+    EXPECT_EQ(numPoints, lazy->numSolvedPoints());
+    delete lazy;
+
+    // Solved up front before the curve is shared
+    lazy = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE, today);
+    lazy->solveAll();
+    EXPECT_EQ(numPoints, lazy->numSolvedPoints());
+    delete lazy;
+
+    // A curve published to a snapshot holder is complete, its
+    // readers never wait on the bootstrap
+    lazy = ycDef.bindData(&values, YieldCurveDefinition::ZEROCOUPONRATE, today);
+    EXPECT_EQ(0, lazy->numSolvedPoints());
+    CurveSnapshotHolder holder;
+    holder.publish(lazy);
+    {
+        CurveSnapshotHolder::Pin pin(holder);
+        EXPECT_EQ(lazy, pin.get());
+        EXPECT_EQ(numPoints, pin->numSolvedPoints());
+    }
+
+    delete eager;
+}
+
+TEST_F(YieldCurveInstanceTest, YieldCurveParRateStrip)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    Date today = WorkDate(Date::today());
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+
+    // Every quarter out to beyond the 3Y end of the curve
+    ParRateStrip strip;
+    getParRateStrip(*yci, Duration(5, Duration::YEAR),
+            Duration(3, Duration::MONTH), 4.0, strip);
+    int numMaturities = (int)strip.maturityDates.size();
+    ASSERT_EQ(20, numMaturities);
+
+    int numSwaps = 0;
+    for(int i = 0; i < numMaturities; i ++)
+    {
+        Date maturityDate = strip.maturityDates[i];
+        if(std::isnan(strip.swapRates[i]))
+        {
+            EXPECT_THROW(getCompoundRate(*yci, maturityDate,
+                        InstrumentDefinition::SWAP, 4.0), YieldCurveException);
+            EXPECT_TRUE(std::isnan(strip.cashRates[i]));
+            continue;
+        }
+
+        numSwaps ++;
+        EXPECT_DOUBLE_EQ(getCompoundRate(*yci, maturityDate,
+                    InstrumentDefinition::SWAP, 4.0), strip.swapRates[i]) <<
+            "Maturity " << maturityDate.toString();
+        EXPECT_DOUBLE_EQ(getCompoundRate(*yci, maturityDate,
+                    InstrumentDefinition::CASH, 4.0), strip.cashRates[i]);
+        // The first FRA starts on the start date of the curve
+        if(std::isnan(strip.fraRates[i]))
+            EXPECT_THROW(getCompoundRate(*yci, maturityDate,
+                        InstrumentDefinition::FRA, 4.0), YieldCurveException);
+        else
+            EXPECT_DOUBLE_EQ(getCompoundRate(*yci, maturityDate,
+                        InstrumentDefinition::FRA, 4.0), strip.fraRates[i]);
+    }
+    EXPECT_GE(numSwaps, 11);
+
+    // Short maturities have no coupon and FRAs starting before
+    // the curve
+    std::vector<Date> shortDates;
+    shortDates.push_back(WorkDate(today + Duration(1, Duration::MONTH)));
+    getParRateStrip(*yci, shortDates, 4.0, strip);
+    EXPECT_DOUBLE_EQ(getCompoundRate(*yci, shortDates[0],
+                InstrumentDefinition::CASH, 4.0), strip.cashRates[0]);
+    EXPECT_TRUE(std::isnan(strip.fraRates[0]));
+    EXPECT_TRUE(std::isnan(strip.swapRates[0]));
+
+    // A batch of curves, each from its own start date
+    InstrumentValues shifted(values);
+    for(int i = 0; i < (int)shifted.values.size(); i ++)
+        shifted.values[i].second += 0.25;
+    std::vector<YieldCurveInstance *> curves;
+    curves.push_back(yci);
+    curves.push_back(ycDef.bindData(&shifted, YieldCurveDefinition::ZEROCOUPONRATE,
+                WorkDate(today + Duration(10, Duration::DAY))));
+
+    std::vector<Duration> tenors;
+    for(int quarters = 1; quarters <= 8; quarters ++)
+        tenors.push_back(Duration(3 * quarters, Duration::MONTH));
+
+    std::vector<ParRateStrip> strips;
+    getParRateStrips(curves, tenors, 4.0, 2, strips);
+    ASSERT_EQ(2, (int)strips.size());
+    for(int c = 0; c < 2; c ++)
+    {
+        ASSERT_EQ((int)tenors.size(), (int)strips[c].swapRates.size());
+        for(int i = 0; i < (int)tenors.size(); i ++)
+        {
+            Date maturityDate = WorkDate(curves[c]->startDate() + tenors[i]);
+            EXPECT_EQ(maturityDate, strips[c].maturityDates[i]);
+            EXPECT_DOUBLE_EQ(getCompoundRate(*curves[c], maturityDate,
+                        InstrumentDefinition::SWAP, 4.0), strips[c].swapRates[i]);
+        }
+    }
+    EXPECT_GT(strips[1].swapRates[4], strips[0].swapRates[4]);
+
+    delete curves[1];
+    delete yci;
+}
+
+TEST_F(YieldCurveInstanceTest, YieldCurveExtrapolation)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    Date today = WorkDate(Date::today());
+    Schedule::Dates pillarDates = ycDef.getPillarDates(today);
+    Date first = pillarDates.front();
+    Date last = pillarDates.back();
+
+    // Before the start date, the start date, inside, at the last
+    // point and after it, not sorted
+    std::vector<Date> dates;
+    dates.push_back(WorkDate(last + Duration(2, Duration::YEAR)));
+    dates.push_back(WorkDate(today - Duration(7, Duration::DAY)));
+    dates.push_back(WorkDate(today + Duration(1, Duration::YEAR)));
+    dates.push_back(today);
+    dates.push_back(last);
+    dates.push_back(WorkDate(last + Duration(1, Duration::YEAR)));
+
+    YieldCurveDefinition::CURVETYPE types[] = {
+        YieldCurveDefinition::ZEROCOUPONRATE,
+        YieldCurveDefinition::DISCOUNTFACTOR,
+        YieldCurveDefinition::CONTINUOUSRATE};
+    for(int k = 0; k < 3; k ++)
+    {
+        YieldCurveInstance *yci = ycDef.bindData(&values, types[k], today);
+
+        std::vector<double> lookupValues, dfs;
+        std::vector<YieldCurveInstance::LOOKUPSTATUS> status;
+        yci->lookup(dates, YieldCurveInstance::NOEXTRAPOLATION,
+                lookupValues, dfs, status);
+        ASSERT_EQ(dates.size(), status.size());
+        EXPECT_EQ(YieldCurveInstance::OUTOFRANGE, status[0]);
+        EXPECT_EQ(YieldCurveInstance::OUTOFRANGE, status[1]);
+        EXPECT_EQ(YieldCurveInstance::INRANGE, status[2]);
+        EXPECT_EQ(YieldCurveInstance::OUTOFRANGE, status[3]);
+        EXPECT_EQ(YieldCurveInstance::INRANGE, status[4]);
+        EXPECT_TRUE(std::isnan(dfs[0]));
+        EXPECT_TRUE(std::isnan(lookupValues[3]));
+        EXPECT_DOUBLE_EQ(yci->getDf(dates[2]), dfs[2]);
+        EXPECT_DOUBLE_EQ((*yci)[dates[4]], lookupValues[4]);
+
+        double firstDf = yci->getDf(first);
+        double lastDf = yci->getDf(last);
+        double lastT = normDiffDate(today, last, Date::ACT365);
+        double t0 = normDiffDate(today, dates[0], Date::ACT365);
+        double t5 = normDiffDate(today, dates[5], Date::ACT365);
+
+        // Flat zero: the continuous zero rate of the end points
+        yci->lookup(dates, YieldCurveInstance::FLATZERO, lookupValues, dfs, status);
+        EXPECT_EQ(YieldCurveInstance::EXTRAPOLATED, status[0]);
+        EXPECT_EQ(YieldCurveInstance::OUTOFRANGE, status[1]);
+        EXPECT_EQ(YieldCurveInstance::EXTRAPOLATED, status[3]);
+        EXPECT_EQ(YieldCurveInstance::INRANGE, status[4]);
+        EXPECT_NEAR(log(dfs[0]) / t0, log(lastDf) / lastT, 1e-12);
+        EXPECT_NEAR(log(dfs[5]) / t5, log(lastDf) / lastT, 1e-12);
+        EXPECT_DOUBLE_EQ(1.0, dfs[3]);
+        if(types[k] == YieldCurveDefinition::DISCOUNTFACTOR)
+            EXPECT_DOUBLE_EQ(1.0, lookupValues[3]);
+        else
+            EXPECT_DOUBLE_EQ((*yci)[first], lookupValues[3]);
+
+        // Flat forward: the forward of the last segment, on to
+        // the last point and from there on
+        yci->lookup(dates, YieldCurveInstance::FLATFORWARD, lookupValues, dfs, status);
+        EXPECT_EQ(YieldCurveInstance::EXTRAPOLATED, status[0]);
+        double forward = log(dfs[5] / dfs[0]) / (t0 - t5);
+        double lastForward = log(lastDf / dfs[5]) / (t5 - lastT);
+        EXPECT_NEAR(forward, lastForward, 1e-10);
+        EXPECT_DOUBLE_EQ(1.0, dfs[3]);
+
+        // Clamp: the value and the df of the nearest point
+        yci->lookup(dates, YieldCurveInstance::CLAMP, lookupValues, dfs, status);
+        EXPECT_EQ(YieldCurveInstance::EXTRAPOLATED, status[0]);
+        EXPECT_DOUBLE_EQ(lastDf, dfs[0]);
+        EXPECT_DOUBLE_EQ(lastDf, dfs[5]);
+        EXPECT_DOUBLE_EQ((*yci)[last], lookupValues[5]);
+        EXPECT_DOUBLE_EQ(firstDf, dfs[3]);
+        EXPECT_EQ(YieldCurveInstance::OUTOFRANGE, status[1]);
+
+        delete yci;
+    }
+}
+
+TEST_F(YieldCurveInstanceTest, YieldCurveRollForward)
+{
+    std::vector<InstrumentDefinition> instrDefs;
+    InstrumentValues values;
+    loadCurve1(instrDefs, values);
+    YieldCurveDefinition ycDef(instrDefs, 4.0);
+
+    Date today = WorkDate(Date::today());
+    Schedule::Dates pillarDates = ycDef.getPillarDates(today);
+    YieldCurveInstance *yci = ycDef.bindData(&values,
+            YieldCurveDefinition::ZEROCOUPONRATE, today);
+
+    // Overnight, in between pillars and on a pillar
+    std::vector<Date> horizons;
+    horizons.push_back(today + Duration(1, Duration::DAY));
+    horizons.push_back(today + Duration(100, Duration::DAY));
+    horizons.push_back(pillarDates[5]);
+
+    std::vector<YieldCurveInstance *> rolled;
+    yci->rollForward(horizons, rolled);
+    ASSERT_EQ(horizons.size(), rolled.size());
+    for(int h = 0; h < (int)horizons.size(); h ++)
+    {
+        Date horizon = WorkDate(horizons[h]);
+        EXPECT_EQ(horizon, rolled[h]->startDate());
+        EXPECT_EQ(YieldCurveDefinition::ZEROCOUPONRATE, rolled[h]->curveType());
+
+        // The forwards of the points after the horizon are kept
+        double horizonDf = yci->getDf(horizon);
+        int numAfter = 0;
+        for(int i = 0; i < (int)pillarDates.size(); i ++)
+        {
+            Date date = pillarDates[i];
+            if(!(horizon < date))
+                continue;
+
+            numAfter ++;
+            EXPECT_NEAR(yci->getDf(date) / horizonDf, rolled[h]->getDf(date), 1e-14);
+        }
+        EXPECT_EQ(numAfter, rolled[h]->numSolvedPoints());
+
+        // The same as a single roll
+        YieldCurveInstance *single = yci->rollForward(horizons[h]);
+        Date last = pillarDates.back();
+        EXPECT_EQ(single->getDf(last), rolled[h]->getDf(last));
+        delete single;
+    }
+
+    // Rolling by nothing keeps the curve
+    YieldCurveInstance *same = yci->rollForward(today);
+    for(int i = 0; i < (int)pillarDates.size(); i ++)
+    {
+        Date date = pillarDates[i];
+        EXPECT_NEAR(yci->getDf(date), same->getDf(date), 1e-14);
+    }
+    delete same;
+
+    EXPECT_THROW(yci->rollForward(today - Duration(7, Duration::DAY)),
+            YieldCurveException);
+    EXPECT_THROW(yci->rollForward(pillarDates.back()), YieldCurveException);
+
+    for(int h = 0; h < (int)rolled.size(); h ++)
+        delete rolled[h];
+    delete yci;
 }